@@ -0,0 +1,136 @@
+/********************************************************/
+/* Benchmark of the non-temporal relaxed planning graph */
+/* (FF_RPG). Compares the heuristic values and the      */
+/* evaluation times of the current implementation with  */
+/* the previous one (FF_RPGReference) over a set of     */
+/* states obtained by random walks from the initial     */
+/* state. TILs are not considered.                      */
+/********************************************************/
+
+#include "../utils/utils.h"
+#include "../parser/parser.h"
+#include "../parser/parsedTask.h"
+#include "../preprocess/preprocess.h"
+#include "../grounder/grounder.h"
+#include "../sas/sasTranslator.h"
+#include "../heuristics/hFF.h"
+#include "ffRPGReference.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+#define DEFAULT_NUM_STATES	1000
+#define WALK_LENGTH			20
+#define NUM_REPETITIONS		10
+
+// Parses, preprocesses, grounds and translates the planning task
+std::shared_ptr<SASTask> loadTask(char* domainFileName, char* problemFileName) {
+	std::unique_ptr<ParsedTask> parsedTask;
+	Parser parser;
+	parser.parseDomain(domainFileName);
+	parser.parseProblem(problemFileName, parsedTask);
+	std::unique_ptr<PreprocessedTask> prepTask;
+	Preprocess preprocess(parsedTask);
+	preprocess.preprocessTask(prepTask);
+	std::unique_ptr<GroundedTask> gTask;
+	Grounder grounder(prepTask);
+	grounder.groundTask(false, gTask);
+	std::shared_ptr<SASTask> sTask = std::make_shared<SASTask>();
+	SASTranslator translator;
+	translator.translate(gTask, false, false, false, sTask);
+	return sTask;
+}
+
+// Checks if the propositional conditions hold in the state
+bool holdConditions(std::vector<SASCondition>& conditions, TState* s) {
+	for (SASCondition& c : conditions)
+		if (s->state[c.var] != c.value) return false;
+	return true;
+}
+
+// Copies a state
+std::shared_ptr<TState> copyState(TState* s) {
+	std::shared_ptr<TState> res = std::make_shared<TState>(s->numSASVars, s->numNumVars);
+	for (unsigned int i = 0; i < s->numSASVars; i++)
+		res->state[i] = s->state[i];
+	for (unsigned int i = 0; i < s->numNumVars; i++) {
+		res->minState[i] = s->minState[i];
+		res->maxState[i] = s->maxState[i];
+	}
+	return res;
+}
+
+// Generates the set of states through random walks from the initial state. Actions are
+// applied atomically (start and end effects) and only their propositional conditions are checked
+void generateStates(std::shared_ptr<SASTask> task, unsigned int numStates, unsigned int seed,
+	std::vector<std::shared_ptr<TState>>& states) {
+	std::mt19937 rng(seed);
+	std::shared_ptr<TState> initialState = std::make_shared<TState>(task);
+	std::shared_ptr<TState> current = copyState(initialState.get());
+	std::vector<unsigned int> applicable;
+	unsigned int steps = 0;
+	while (states.size() < numStates) {
+		states.push_back(copyState(current.get()));
+		applicable.clear();
+		for (unsigned int i = 0; i < task->actions.size(); i++) {
+			SASAction* a = task->actions[i].get();
+			if (holdConditions(a->startCond, current.get()) && holdConditions(a->overCond, current.get())
+				&& holdConditions(a->endCond, current.get()))
+				applicable.push_back(i);
+		}
+		if (applicable.empty() || ++steps == WALK_LENGTH) {
+			current = copyState(initialState.get());
+			steps = 0;
+		} else {
+			SASAction* a = task->actions[applicable[rng() % applicable.size()]].get();
+			for (SASCondition& e : a->startEff) current->state[e.var] = e.value;
+			for (SASCondition& e : a->endEff) current->state[e.var] = e.value;
+		}
+	}
+}
+
+// Main method: ffrpg_benchmark <domain> <problem> [<number of states> [<seed>]]
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cout << "Usage: ffrpg_benchmark <domain> <problem> [<number of states> [<seed>]]" << endl;
+		return 2;
+	}
+	unsigned int numStates = argc > 3 ? atoi(argv[3]) : DEFAULT_NUM_STATES;
+	unsigned int seed = argc > 4 ? atoi(argv[4]) : 0;
+	std::shared_ptr<SASTask> task = loadTask(argv[1], argv[2]);
+	std::vector<std::shared_ptr<TState>> states;
+	generateStates(task, numStates, seed, states);
+	FF_RPG rpg;
+	rpg.initialize(task);
+	std::vector<uint16_t> hValues(states.size()), hReference(states.size());
+	auto t = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < NUM_REPETITIONS; r++)
+		for (unsigned int i = 0; i < states.size(); i++)
+			hValues[i] = rpg.evaluate(states[i], nullptr);
+	double currentTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count();
+	t = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < NUM_REPETITIONS; r++)
+		for (unsigned int i = 0; i < states.size(); i++) {
+			FF_RPGReference reference(states[i], nullptr, task);
+			hReference[i] = reference.evaluate();
+		}
+	double referenceTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count();
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < states.size(); i++) {
+		if (hValues[i] != hReference[i]) {
+			if (mismatches == 0)
+				cout << "State " << i << ": h = " << hValues[i] << ", reference h = " << hReference[i] << endl;
+			mismatches++;
+		}
+	}
+	unsigned int numEvaluations = NUM_REPETITIONS * states.size();
+	cout << "States: " << states.size() << endl;
+	cout << "Mismatches: " << mismatches << endl;
+	cout << "Current: " << (currentTime / numEvaluations) << " us/evaluation" << endl;
+	cout << "Reference: " << (referenceTime / numEvaluations) << " us/evaluation" << endl;
+	if (currentTime > 0)
+		cout << "Speedup: " << (referenceTime / currentTime) << endl;
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+/********************************************************/
+/* Previous implementation of the non-temporal relaxed  */
+/* planning graph (FF_RPG), kept as a reference for the */
+/* benchmark of the current one.                        */
+/********************************************************/
+
+#include <iostream>
+#include <time.h>
+#include "ffRPGReference.h"
+using namespace std;
+
+#define PENALTY 8
+
+FF_RPGReferenceVarValue::FF_RPGReferenceVarValue(TVariable var, TValue value) {
+	this->var = var;
+	this->value = value;
+}
+
+FF_RPGReference::FF_RPGReference(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, std::shared_ptr<SASTask> task) {
+	this->task = task;
+	initialize();
+	//cout << "STATE:" << endl;
+	for (unsigned int i = 0; i < fs->numSASVars; i++) {
+		TValue v = fs->state[i];
+		lastLevel->emplace_back(i, v);
+		literalLevels[i][v] = 0;
+		//cout << "(" << task->variables[i].name << ", " << task->values[v].name << ") -> Level 0" << endl;
+	}
+	if (tilActions != nullptr) {
+		addTILactions(tilActions);
+	}
+	expand();
+}
+
+void FF_RPGReference::addTILactions(std::vector<std::shared_ptr<SASAction>>* tilActions) {
+	for (unsigned int i = 0; i < tilActions->size(); i++) {
+		std::shared_ptr<SASAction> a = tilActions->at(i);
+		for (unsigned int j = 0; j < a->endEff.size(); j++) {
+			TVariable v = a->endEff[j].var;
+			TValue value = a->endEff[j].value;
+			if (literalLevels[v][value] != 0) {
+				lastLevel->emplace_back(v, value);
+				literalLevels[v][value] = 0;
+			}
+		}
+	}
+}
+
+void FF_RPGReference::expand() {
+	numLevels = 0;
+	while (lastLevel->size() > 0) {
+		newLevel->clear();
+		for (unsigned int i = 0; i < lastLevel->size(); i++) {
+			TVariable var = (*lastLevel)[i].var;
+			TValue value = (*lastLevel)[i].value;
+			vector<std::shared_ptr<SASAction>> &actions = task->requirers[var][value];
+			for (unsigned int j = 0; j < actions.size(); j++) {
+				std::shared_ptr<SASAction> a = actions[j];
+				if (actionLevels[a->index] == MAX_INT32 && isExecutable(a)) {
+					actionLevels[a->index] = numLevels;
+					addEffects(a);
+				}
+			}
+		}
+		if (numLevels == 0) {
+			for (unsigned int j = 0; j < task->actionsWithoutConditions.size(); j++) {
+				std::shared_ptr<SASAction> a = task->actionsWithoutConditions[j];
+				actionLevels[a->index] = numLevels;
+				addEffects(a);
+			}
+		}
+		numLevels++;
+		for (unsigned int i = 0; i < newLevel->size(); i++) {
+			literalLevels[(*newLevel)[i].var][(*newLevel)[i].value] = numLevels;
+		}
+    std::unique_ptr<std::vector<FF_RPGReferenceVarValue>> aux = std::move(lastLevel);
+		lastLevel = std::move(newLevel);
+		newLevel = std::move(aux);
+	}
+}
+
+bool FF_RPGReference::isExecutable(std::shared_ptr<SASAction> a) {
+	for (unsigned int i = 0; i < a->startCond.size(); i++) {
+		if (literalLevels[a->startCond[i].var][a->startCond[i].value] == MAX_INT32)
+			return false;
+	}
+	for (unsigned int i = 0; i < a->overCond.size(); i++) {
+		if (literalLevels[a->overCond[i].var][a->overCond[i].value] == MAX_INT32)
+			return false;
+	}
+	/*
+	if (forceAtEndConditions) {
+		for (unsigned int i = 0; i < a->endCond.size(); i++) {
+			if (literalLevels[a->endCond[i].var][a->endCond[i].value] == MAX_INT32)
+				return false;
+		}
+	}*/
+	return true;
+}
+
+void FF_RPGReference::addEffects(std::shared_ptr<SASAction> a) {
+	for (unsigned int i = 0; i < a->startEff.size(); i++) {
+		addEffect(a->startEff[i].var, a->startEff[i].value);
+	}
+	for (unsigned int i = 0; i < a->endEff.size(); i++) {
+		addEffect(a->endEff[i].var, a->endEff[i].value);
+	}
+}
+
+void FF_RPGReference::addEffect(TVariable var, TValue value) {
+	if (literalLevels[var][value] == MAX_INT32) {
+		for (unsigned int i = 0; i < newLevel->size(); i++)
+			if ((*newLevel)[i].var == var && (*newLevel)[i].value == value)
+				return;
+		newLevel->emplace_back(var, value);
+	}
+}
+
+void FF_RPGReference::initialize() {
+	unsigned int numVars = task->variables.size();
+	literalLevels.resize(numVars);
+	for (unsigned int i = 0; i < numVars; i++) {
+		literalLevels[i].resize(task->values.size(), MAX_INT32);
+	}
+	actionLevels.resize(task->actions.size(), MAX_INT32);
+	lastLevel = std::make_unique<vector<FF_RPGReferenceVarValue>>();
+	newLevel = std::make_unique<vector<FF_RPGReferenceVarValue>>();
+}
+
+void FF_RPGReference::resetReachedValues() {
+	for (unsigned int i = 0; i < reachedValues.size(); i++) {
+		TVariable v = SASTask::getVariableIndex(reachedValues[i]);
+		TValue value = SASTask::getValueIndex(reachedValues[i]);
+		if (literalLevels[v][value] < 0)
+			literalLevels[v][value] = -literalLevels[v][value];
+	}
+	reachedValues.clear();
+}
+
+uint16_t FF_RPGReference::computeHeuristic(PriorityQueue* openConditions) {
+	int gLevel;
+	uint16_t bestCost;
+	uint16_t h = 0;
+	while (openConditions->size() > 0) {
+    std::shared_ptr<FF_RPGReferenceCondition> g = std::dynamic_pointer_cast<FF_RPGReferenceCondition>(openConditions->poll());
+		//if (debug) cout << "Condition: " << task->variables[g->var].name << " = " << task->values[g->value].name << " (level " << literalLevels[g->var][g->value] << ")" << endl;
+		gLevel = literalLevels[g->var][g->value];
+		if (gLevel <= 0) {
+			continue;
+		}
+		if (gLevel == MAX_INT32) return MAX_UINT16;
+		literalLevels[g->var][g->value] = -gLevel;
+		reachedValues.push_back(SASTask::getVariableValueCode(g->var, g->value));
+		vector<std::shared_ptr<SASAction>> &prod = task->producers[g->var][g->value];
+		std::shared_ptr<SASAction> bestAction = nullptr;
+		bestCost = MAX_UINT16;
+		for (unsigned int i = 0; i < prod.size(); i++) {
+			std::shared_ptr<SASAction> a = prod[i];
+			if (gLevel == actionLevels[a->index] + 1) {
+				if (bestAction == nullptr) {
+					bestAction = a;
+					bestCost = /*mutex ? getDifficultyWithPermanentMutex(a) :*/ getDifficulty(a);
+					if (bestCost == 0) break;
+				}
+				else {
+					uint16_t cost = /*mutex ? getDifficultyWithPermanentMutex(a) :*/ getDifficulty(a);
+					if (cost < bestCost) {
+						bestAction = a;
+						bestCost = cost;
+						if (bestCost == 0) {
+							break;
+						}
+					}
+				}
+			}
+		}
+		if (bestAction != nullptr) {
+			//if (debug) cout << bestAction->name << endl;
+			h++;
+			addSubgoals(bestAction, openConditions);
+		}
+		else {
+			return MAX_UINT16;
+		}
+	}
+	return h;
+}
+
+uint16_t FF_RPGReference::evaluate() {
+	resetReachedValues();
+	PriorityQueue openConditions(128);
+	addSubgoals(task->getListOfGoals(), &openConditions);
+	return computeHeuristic(&openConditions);
+}
+
+void FF_RPGReference::addSubgoals(std::vector<TVarValue>* goals, PriorityQueue* openConditions) {
+	TVariable var;
+	TValue value;
+	for (unsigned int i = 0; i < goals->size(); i++) {
+		var = SASTask::getVariableIndex(goals->at(i));
+		value = SASTask::getValueIndex(goals->at(i));
+		addSubgoal(var, value, openConditions);
+	}
+}
+
+void FF_RPGReference::addSubgoal(TVariable var, TValue value, PriorityQueue* openConditions) {
+	int level = literalLevels[var][value];
+	if (level > 0) {
+		openConditions->add(std::make_shared<FF_RPGReferenceCondition>(var, value, level));
+	}
+}
+
+void FF_RPGReference::addSubgoals(std::shared_ptr<SASAction> a, PriorityQueue* openConditions) {
+	TVariable var;
+	TValue value;
+	// Add the conditions of the action that do not hold in the frontier state as subgoals 
+	for (unsigned int i = 0; i < a->startCond.size(); i++) {
+		var = a->startCond[i].var;
+		value = a->startCond[i].value;
+		addSubgoal(var, value, openConditions);
+	}
+	for (unsigned int i = 0; i < a->overCond.size(); i++) {
+		var = a->overCond[i].var;
+		value = a->overCond[i].value;
+		addSubgoal(var, value, openConditions);
+	}
+	/*
+	if (forceAtEndConditions) {
+		for (unsigned int i = 0; i < a->endCond.size(); i++) {
+			var = a->endCond[i].var;
+			value = a->endCond[i].value;
+			addSubgoal(var, value, openConditions);
+		}
+	}*/
+}
+
+uint16_t FF_RPGReference::getDifficulty(std::shared_ptr<SASAction> a) {
+	uint16_t cost = 0;
+	for (unsigned int i = 0; i < a->startCond.size(); i++) {
+		cost += getDifficulty(&(a->startCond[i]));
+	}
+	for (unsigned int i = 0; i < a->overCond.size(); i++) {
+		cost += getDifficulty(&(a->overCond[i])); 
+	}
+	/*
+	if (forceAtEndConditions) {
+		for (unsigned int i = 0; i < a->endCond.size(); i++) {
+			cost += getDifficulty(&(a->endCond[i]));
+		}
+	}*/
+	//cout << " * Difficulty: " << cost << endl;
+	return cost;
+}
+
+uint16_t FF_RPGReference::getDifficulty(SASCondition* c) {
+	int level = literalLevels[c->var][c->value];
+	//cout << " * Dif. of (" << task->variables[c->var].name << ", " << task->values[c->value].name << "): " << level << endl;
+	return level > 0 ? level : 0;
+}
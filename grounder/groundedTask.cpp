@@ -5,6 +5,7 @@
 /* Grounded task obtained after the grounding process.  */
 /********************************************************/
 
+#include <algorithm>
 #include "groundedTask.h"
 #include "../utils/utils.h"
 using namespace std;
@@ -41,6 +42,44 @@ string GroundedVar::toString(std::unique_ptr<ParsedTask> & task, bool isGoal) {
     return s + ")"; // + std::to_string(index);
 }
 
+/********************************************************/
+/* CLASS: GroundedReachedValues                         */
+/********************************************************/
+
+// Returns the level where the value was reached, or MAX_UNSIGNED_INT if it has not been reached
+unsigned int GroundedReachedValues::getLevel(unsigned int value) {
+    for (unsigned int i = 0; i < numInline; i++)
+        if (inlineValues[i] == value) return inlineLevels[i];
+    if (moreValues != nullptr) {
+        std::unordered_map<unsigned int, unsigned int>::const_iterator it = moreValues->find(value);
+        if (it != moreValues->end()) return it->second;
+    }
+    return MAX_UNSIGNED_INT;
+}
+
+// Annotates a reached value. Returns false if it was already reached
+bool GroundedReachedValues::add(unsigned int value, unsigned int level) {
+    if (getLevel(value) != MAX_UNSIGNED_INT) return false;
+    if (numInline < REACHED_VALUES_INLINE) {
+        inlineValues[numInline] = value;
+        inlineLevels[numInline++] = level;
+    } else {
+        if (moreValues == nullptr) moreValues = std::make_unique<std::unordered_map<unsigned int, unsigned int>>();
+        (*moreValues)[value] = level;
+    }
+    return true;
+}
+
+// Returns the reached values, sorted
+std::vector<unsigned int> GroundedReachedValues::getValues() {
+    std::vector<unsigned int> values(inlineValues, inlineValues + numInline);
+    if (moreValues != nullptr)
+        for (const std::pair<const unsigned int, unsigned int> &v : *moreValues)
+            values.push_back(v.first);
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
 /********************************************************/
 /* CLASS: GroundedCondition                             */
 /********************************************************/
@@ -129,6 +168,18 @@ bool GroundedNumericExpression::requiresNumericVariable(TVariable v)
     return false;
 }
 
+// Checks if two expressions are structurally identical
+bool GroundedNumericExpression::equals(const GroundedNumericExpression &e) const
+{
+    if (type != e.type || terms.size() != e.terms.size()) return false;
+    if (type == GE_NUMBER && value != e.value) return false;
+    if ((type == GE_VAR || type == GE_OBJECT || type == GE_CONTROL_VAR) && index != e.index) return false;
+    for (unsigned int i = 0; i < terms.size(); i++)
+        if (!terms[i].equals(e.terms[i]))
+            return false;
+    return true;
+}
+
 /********************************************************/
 /* CLASS: GroundedNumericCondition                     */
 /********************************************************/
@@ -157,6 +208,15 @@ bool GroundedNumericCondition::requiresNumericVariable(TVariable v)
     return false;
 }
 
+bool GroundedNumericCondition::equals(const GroundedNumericCondition &c) const
+{
+    if (comparator != c.comparator || terms.size() != c.terms.size()) return false;
+    for (unsigned int i = 0; i < terms.size(); i++)
+        if (!terms[i].equals(c.terms[i]))
+            return false;
+    return true;
+}
+
 /********************************************************/
 /* CLASS: GroundedNumericEffect                         */
 /********************************************************/
@@ -174,6 +234,11 @@ void GroundedNumericEffect::writePDDLEffect(std::ofstream &f, std::unique_ptr<Pa
     f << ")";
 }
 
+bool GroundedNumericEffect::equals(const GroundedNumericEffect &e) const
+{
+    return assignment == e.assignment && varIndex == e.varIndex && exp.equals(e.exp);
+}
+
 /********************************************************/
 /* CLASS: PartiallyGroundedNumericExpression            */
 /********************************************************/
@@ -495,6 +560,11 @@ void GroundedDuration::writePDDLDuration(ofstream &f, std::unique_ptr<ParsedTask
     f << ")";
 }
 
+bool GroundedDuration::equals(const GroundedDuration &d) const
+{
+    return time == d.time && comp == d.comp && exp.equals(d.exp);
+}
+
 /********************************************************/
 /* CLASS: Action                                        */
 /********************************************************/
@@ -762,9 +832,8 @@ string GroundedTask::toString() {
         s += "\n* Var. " + to_string(i) + ": " + variables[i].toString(task);
         if (!variables[i].isNumeric) {
             s += "\n  Values:";
-            for (unsigned int j = 0; j < task->objects.size(); j++)
-                if (reachedValues[i][j] != MAX_UNSIGNED_INT)
-                   s += " (" + task->objects[j].name + ")" + to_string(reachedValues[i][j]);
+            for (unsigned int j : reachedValues[i].getValues())
+                s += " (" + task->objects[j].name + ")" + to_string(reachedValues[i].getLevel(j));
         }
     }
     s += "\nACTIONS: " + to_string(actions.size()) + ":";
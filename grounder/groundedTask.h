@@ -13,6 +13,10 @@
 #include <cstdint>
 #include <fstream>
 #include <memory>
+#include <unordered_map>
+
+// Number of reached values of a variable stored without allocating memory
+#define REACHED_VALUES_INLINE 4
 
 // Types of the control parameters (real or integer)
 enum GroundedControlVarType {
@@ -59,6 +63,22 @@ public:
     std::string toString(std::unique_ptr<ParsedTask> & task, bool isGoal);
 };
 
+// Values reached by a variable during the grounding, with the level where each one was reached. Most
+// variables only reach a few values, which are stored inline; the rest go to a hash table
+class GroundedReachedValues {
+private:
+    unsigned int numInline;
+    unsigned int inlineValues[REACHED_VALUES_INLINE];
+    unsigned int inlineLevels[REACHED_VALUES_INLINE];
+    std::unique_ptr<std::unordered_map<unsigned int, unsigned int>> moreValues;
+
+public:
+    GroundedReachedValues() : numInline(0) { }
+    unsigned int getLevel(unsigned int value);
+    bool add(unsigned int value, unsigned int level);
+    std::vector<unsigned int> getValues();
+};
+
 // Grounded condition
 class GroundedCondition {
 public:
@@ -86,6 +106,7 @@ public:
         std::vector<GroundedControlVar>& controlVars);
     void writePDDLNumericExpression(std::ofstream &f, std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables, bool isGoal);
     bool requiresNumericVariable(TVariable v);
+    bool equals(const GroundedNumericExpression &e) const;
 };
 
 // Types of partially-gorunded numeric expressions
@@ -115,6 +136,7 @@ public:
     std::string toString(std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables, std::vector<GroundedControlVar>& controlVars);
     void writePDDLCondition(std::ofstream &f, std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables, bool isGoal);
     bool requiresNumericVariable(TVariable v);
+    bool equals(const GroundedNumericCondition &c) const;
 };
 
 // Grounded numeric effect
@@ -125,6 +147,7 @@ public:
     GroundedNumericExpression exp;
     std::string toString(std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables, std::vector<GroundedControlVar>& controlVars);
     void writePDDLEffect(std::ofstream &f, std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables);
+    bool equals(const GroundedNumericEffect &e) const;
 };
 
 // Types of grounded goal descriptions
@@ -175,6 +198,7 @@ public:
     GroundedNumericExpression exp;
     std::string toString(std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables, std::vector<GroundedControlVar>& controlVars);
     void writePDDLDuration(std::ofstream &f, std::unique_ptr<ParsedTask> & task, std::vector<GroundedVar> &variables);
+    bool equals(const GroundedDuration &d) const;
 };
 
 class GroundedConditionalEffect {
@@ -288,7 +312,7 @@ public:
     std::vector<GroundedAction> actions;
     std::vector<GroundedAction> goals;
     std::vector<std::string> preferenceNames;
-    std::vector< std::vector<unsigned int> > reachedValues;
+    std::vector<GroundedReachedValues> reachedValues;
 	std::vector<GroundedConstraint> constraints;
 	GroundedMetric metric;
 	char metricType;	// '>' = Maximize, '<' = Minimize , 'X' = no metric specified
@@ -6,6 +6,9 @@
 /* PreprocessedTask.                                    */
 /********************************************************/
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "grounder.h"
 #include "../utils/utils.h"
 using namespace std;
@@ -39,6 +42,96 @@ void GrounderOperator::initialize(Operator &o) {
 }
 
 
+/********************************************************/
+/* CLASS: GrounderMatch                                 */
+/********************************************************/
+
+// Prepares the matching of an operator. The parameter stacks are always empty between matchings
+void GrounderMatch::initialize(GrounderOperator *op, unsigned int newValueIndex) {
+    this->op = op;
+    this->newValueIndex = newValueIndex;
+    if (paramValues.size() < op->numParams)
+        paramValues.resize(op->numParams);
+    factPosition.assign(op->preconditions.size(), 0);
+    result = nullptr;
+}
+
+
+/********************************************************/
+/* CLASS: GrounderTupleTable                            */
+/********************************************************/
+
+GrounderTupleTable::GrounderTupleTable() {
+    clear();
+}
+
+// Removes all the tuples
+void GrounderTupleTable::clear() {
+    slots.assign(1024, Slot{0, MAX_UNSIGNED_INT, 0});
+    pool.clear();
+    numKeys = 0;
+}
+
+// Computes the hash code of a tuple
+uint64_t GrounderTupleTable::getHash(unsigned int head, const unsigned int *params, unsigned int numParams) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (((uint64_t)numParams << 32) | head);
+    for (unsigned int i = 0; i < numParams; i++) {
+        h ^= params[i];
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+// Returns the slot of a tuple, or the empty slot where it should be stored
+unsigned int GrounderTupleTable::findSlot(uint64_t hash, unsigned int head, const unsigned int *params, unsigned int numParams) {
+    unsigned int mask = slots.size() - 1;
+    unsigned int i = (unsigned int)(hash ^ (hash >> 32)) & mask;
+    while (slots[i].offset != MAX_UNSIGNED_INT) {
+        Slot &s = slots[i];
+        if (s.hash == hash && pool[s.offset] == numParams && pool[s.offset + 1] == head &&
+            std::equal(params, params + numParams, pool.begin() + s.offset + 2))
+            return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Doubles the number of slots
+void GrounderTupleTable::grow() {
+    vector<Slot> old = std::move(slots);
+    slots.assign(old.size() * 2, Slot{0, MAX_UNSIGNED_INT, 0});
+    unsigned int mask = slots.size() - 1;
+    for (Slot &s : old) {
+        if (s.offset == MAX_UNSIGNED_INT) continue;
+        unsigned int i = (unsigned int)(s.hash ^ (s.hash >> 32)) & mask;
+        while (slots[i].offset != MAX_UNSIGNED_INT) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+}
+
+// Returns the index of a tuple, or MAX_UNSIGNED_INT if it is not in the table
+unsigned int GrounderTupleTable::find(unsigned int head, const vector<unsigned int> &params) {
+    Slot &s = slots[findSlot(getHash(head, params.data(), params.size()), head, params.data(), params.size())];
+    return s.offset == MAX_UNSIGNED_INT ? MAX_UNSIGNED_INT : s.value;
+}
+
+// Stores the index of a tuple. If the tuple was already in the table, its index is replaced
+void GrounderTupleTable::insert(unsigned int head, const vector<unsigned int> &params, unsigned int value) {
+    if (2 * (numKeys + 1) > slots.size()) grow();
+    uint64_t hash = getHash(head, params.data(), params.size());
+    Slot &s = slots[findSlot(hash, head, params.data(), params.size())];
+    if (s.offset == MAX_UNSIGNED_INT) {
+        s.hash = hash;
+        s.offset = pool.size();
+        pool.push_back(params.size());
+        pool.push_back(head);
+        pool.insert(pool.end(), params.begin(), params.end());
+        numKeys++;
+    }
+    s.value = value;
+}
+
 /********************************************************/
 /* CLASS: ProgrammedValue                              */
 /********************************************************/
@@ -49,10 +142,47 @@ ProgrammedValue::ProgrammedValue(unsigned int index, unsigned int varIndex, unsi
     this->valueIndex = valueIndex;
 }
 
+/********************************************************/
+/* CLASS: GrounderActionSignature                       */
+/********************************************************/
+
+GrounderActionSignature::GrounderActionSignature(GroundedAction &a) {
+    vector<GroundedCondition> *conditions[5] = {&a.startCond, &a.overCond, &a.endCond, &a.startEff, &a.endEff};
+    vector<uint64_t> *codes[5] = {&cond[0], &cond[1], &cond[2], &eff[0], &eff[1]};
+    for (unsigned int t = 0; t < 5; t++) {
+        for (GroundedCondition &c : *(conditions[t]))
+            codes[t]->push_back(((uint64_t)c.varIndex << 32) | c.valueIndex);
+        std::sort(codes[t]->begin(), codes[t]->end());
+        codes[t]->erase(std::unique(codes[t]->begin(), codes[t]->end()), codes[t]->end());
+    }
+    auto combine = [](uint64_t h, uint64_t v) {
+        h ^= v;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        return h ^ (h >> 31);
+    };
+    uint64_t h = combine(0x9E3779B97F4A7C15ULL, ((uint64_t)a.instantaneous << 32) | a.duration.size());
+    for (unsigned int t = 0; t < 2; t++) {
+        h = combine(h, eff[t].size());
+        for (uint64_t code : eff[t]) h = combine(h, code);
+    }
+    for (GroundedNumericEffect &e : a.startNumEff) h = combine(h, ((uint64_t)e.assignment << 32) | e.varIndex);
+    for (GroundedNumericEffect &e : a.endNumEff) h = combine(h, ((uint64_t)(e.assignment + 8) << 32) | e.varIndex);
+    effectHash = (size_t)h;
+    h = 0x9E3779B97F4A7C15ULL;
+    for (unsigned int t = 0; t < 3; t++) {
+        h = combine(h, cond[t].size());
+        for (uint64_t code : cond[t]) h = combine(h, code);
+    }
+    h = combine(h, ((uint64_t)a.startNumCond.size() << 40) | ((uint64_t)a.overNumCond.size() << 20) | a.endNumCond.size());
+    conditionHash = (size_t)h;
+}
+
 /********************************************************/
 /* CLASS: Grounder                                      */
 /********************************************************/
 Grounder::Grounder(std::unique_ptr<PreprocessedTask> &prepTask): prepTask(prepTask){
+    numGroundedActions = numIrrelevantActions = 0;
+    numDuplicateActions = numDominatedActions = 0;
 }
 
 // Grounding process
@@ -71,17 +201,12 @@ void Grounder::groundTask(bool keepStaticData, std::unique_ptr<GroundedTask> &gT
     for (unsigned int i = 0; i < auxValues->size(); i++) {
         ProgrammedValue &pv = auxValues->at(i);
         newValues->push_back(pv);
-        valuesByFunction[gTask->variables[pv.varIndex].fncIndex].push_back(pv);
+        addValueToFunction(pv);
     }
     auxValues->clear();
+    workers.resize(std::max(1u, std::thread::hardware_concurrency()));
     while (newValues->size() > 0) {
-        for (unsigned int i = 0; i < newValues->size(); i++) {
-#ifdef _GROUNDER_TRACE_ON_
-            cout << gTask->variables[newValues->at(i).varIndex].toString(prepTask->task) << "=" <<
-                gTask->task->objects[newValues->at(i).valueIndex].toString() << endl;
-#endif
-            match(newValues->at(i));
-        }
+        matchLevel();
         startNewValues += newValues->size();
         swapLevels();
         currentLevel++;
@@ -93,10 +218,16 @@ void Grounder::groundTask(bool keepStaticData, std::unique_ptr<GroundedTask> &gT
     	gTask->metricType = gTask->task->metricType == MT_MAXIMIZE ? '>' : '<';
     	gTask->metric = groundMetric(&(gTask->task->metric));
     }
+	numGroundedActions = gTask->actions.size();
+	numIrrelevantActions = 0;
 	if (!keepStaticData) {
+		removeIrrelevantActions();
 		removeStaticVariables();
 	}
 	checkNumericConditions();
+	numDuplicateActions = numDominatedActions = 0;
+	if (!keepStaticData)
+		removeRedundantActions();
     computeInitialVariableValues();
     checkNumericEffectsNotRequired();
     clearMemory();
@@ -135,15 +266,28 @@ void Grounder::initOperators() {
     numOps = prepTask->operators.size();
     ops = std::make_unique<GrounderOperator[]>(numOps);
     unsigned int numObjects = prepTask->task->objects.size();
+    unordered_map<string, unsigned int> opNames;
     for (unsigned int i = 0; i < numOps; i++) {
         GrounderOperator &g = ops[i];
         g.index = i;
         g.initialize(prepTask->operators[i]);
+        unordered_map<string, unsigned int>::const_iterator it = opNames.find(g.op->name);
+        if (it == opNames.end()) {
+            g.nameIndex = opNames.size();
+            opNames[g.op->name] = g.nameIndex;
+        } else g.nameIndex = it->second;
         for (unsigned int j = 0; j < g.numParams; j++)
             for (unsigned int k = 0; k < numObjects; k++)
                 if (objectIsCompatible(k, g.op->parameters[j].types))
                     g.compatibleObjectsWithParam[j].push_back(k);
     }
+    initStaticFunctions();
+    for (unsigned int i = 0; i < numOps; i++) {
+        GrounderOperator &g = ops[i];
+        for (OpFluent& c : g.op->atEnd.prec)
+            if (staticFunction[c.variable.fncIndex] && !(c.value.type == TERM_CONSTANT && c.value.index == prepTask->task->CONSTANT_FALSE))
+                g.staticPreconditions.emplace_back(c);
+    }
     unsigned int numFunctions = prepTask->task->functions.size();
     opRequireFunction = std::make_unique<vector<GrounderOperator*>[]>(numFunctions);
     for (unsigned int i = 0; i < numOps; i++) {
@@ -179,6 +323,7 @@ void Grounder::initInitialState() {
     newValues = std::make_unique<vector<ProgrammedValue>>();
     auxValues = std::make_unique<vector<ProgrammedValue>>();
     valuesByFunction = std::make_unique<vector<ProgrammedValue>[]>(numFunctions);
+    argumentIndex = std::make_unique<vector<unordered_map<unsigned int, vector<unsigned int>>>[]>(numFunctions);
     unsigned int initStateSize = prepTask->task->init.size();
     for (unsigned int i = 0; i < initStateSize; i++)
         createVariable(prepTask->task->init[i]);
@@ -186,10 +331,10 @@ void Grounder::initInitialState() {
     for (unsigned int i = 0; i < initStateSize; i++) {
         Fact &f = prepTask->task->init[i];
         if (!f.valueIsNumeric) {    // Program only non-numeric variables
-            ProgrammedValue pv(numValues++, getVariableIndex(f), f.value);
+            ProgrammedValue pv(numValues++, getVariableIndex(f.function, f.parameters), f.value);
             newValues->push_back(pv);
-            valuesByFunction[f.function].push_back(pv);
-            gTask->reachedValues[pv.varIndex][pv.valueIndex] = 0;
+            addValueToFunction(pv);
+            gTask->reachedValues[pv.varIndex].add(pv.valueIndex, 0);
         }
     }
     startNewValues = 0;
@@ -197,58 +342,36 @@ void Grounder::initInitialState() {
 
 // Creates a new variable
 void Grounder::createVariable(const Fact &f) {
-    string factName = getVariableName(f.function, f.parameters);
-    if (variableIndex.find(factName) == variableIndex.end()) { // New variable
+    if (variableIndex.find(f.function, f.parameters) == MAX_UNSIGNED_INT) { // New variable
         GroundedVar v;
         v.index = gTask->variables.size();
         v.fncIndex = f.function;
         v.isNumeric = f.valueIsNumeric;
         v.params = f.parameters;
         gTask->variables.push_back(v);
-        variableIndex[factName] = v.index;
-        unsigned int notReached = MAX_UNSIGNED_INT;
-        if (v.isNumeric) gTask->reachedValues.emplace_back(0, notReached);
-        else {
-             gTask->reachedValues.emplace_back(prepTask->task->objects.size(), notReached);
-             vector<unsigned int> values = gTask->reachedValues.back();
-             values[f.value] = 0;
-        }
+        variableIndex.insert(v.fncIndex, v.params, v.index);
+        gTask->reachedValues.emplace_back();
     }
 }
 
-// Returns the description of a variable
-string Grounder::getVariableName(unsigned int function, const vector<unsigned int> &parameters) {
-    string name = to_string(function);
-    for (unsigned int i = 0; i < parameters.size(); i++)
-        name += " " + to_string(parameters[i]);
-    return name;
+// Returns the index of a variable, or MAX_UNSIGNED_INT if it does not exist
+unsigned int Grounder::getVariableIndex(unsigned int function, const vector<unsigned int> &parameters) {
+    return variableIndex.find(function, parameters);
 }
 
-// Returns the description of a literal
-string Grounder::getVariableName(const Literal &l, const vector<unsigned int> &opParameters) {
-    string name = to_string(l.fncIndex);
+// Returns the index of a variable
+unsigned int Grounder::getVariableIndex(const Literal &l, const vector<unsigned int> &opParameters) {
+    keyParameters.clear();
     for (unsigned int i = 0; i < l.params.size(); i++)
         if (l.params[i].type == TERM_PARAMETER)
-           name += " " + to_string(opParameters[l.params[i].index]);
+           keyParameters.push_back(opParameters[l.params[i].index]);
         else
-           name += " " + to_string(l.params[i].index);
-    return name;
-}
-    
-// Returns the index of a variable
-unsigned int Grounder::getVariableIndex(const Fact &f) {
-    return variableIndex[getVariableName(f.function, f.parameters)];
+           keyParameters.push_back(l.params[i].index);
+    return variableIndex.find(l.fncIndex, keyParameters);
 }
 
-// Returns the index of a variable
-unsigned int Grounder::getVariableIndex(const Literal &l, const vector<unsigned int> &opParameters) {
-    const string &name = getVariableName(l, opParameters);
-    unordered_map<string,unsigned int>::const_iterator it = variableIndex.find(name);
-    if (it == variableIndex.end()) return MAX_UNSIGNED_INT;
-    else return it->second;
-}
-
-// Grounding by combining all posible values for the parameters
+// Grounding by combining all posible values for the parameters. The values of a parameter that appears in
+// a static precondition are taken from the facts of the initial state that can match that precondition
 void Grounder::groundRemainingParameters(GrounderOperator &op) {
     unsigned int pIndex = MAX_UNSIGNED_INT;
     for (unsigned int i = 0; i < op.numParams; i++)
@@ -259,15 +382,91 @@ void Grounder::groundRemainingParameters(GrounderOperator &op) {
     if (pIndex == MAX_UNSIGNED_INT) {
         groundAction(op);
     } else {
-        vector<unsigned int> &v = op.compatibleObjectsWithParam[pIndex];
+        vector<unsigned int> joinedObjects;
+        bool joined = getStaticCandidates(op, pIndex, joinedObjects);
+        vector<unsigned int> &v = joined ? joinedObjects : op.compatibleObjectsWithParam[pIndex];
         for (unsigned int i = 0; i < v.size(); i++) {
+            if (joined && !objectIsCompatible(v[i], op.op->parameters[pIndex].types))
+                continue;
             op.paramValues[pIndex].push_back(v[i]);
-            groundRemainingParameters(op);
+            if (staticPreconditionsHold(op, pIndex))
+                groundRemainingParameters(op);
             op.paramValues[pIndex].pop_back();
         }
     }
 }
 
+// Marks the functions that are not modified by any operator. Their facts are those in the initial state
+void Grounder::initStaticFunctions() {
+    unsigned int numFunctions = prepTask->task->functions.size();
+    staticFunction = std::make_unique<bool[]>(numFunctions);
+    for (unsigned int i = 0; i < numFunctions; i++)
+        staticFunction[i] = !prepTask->task->isNumericFunction(i);
+    for (unsigned int i = 0; i < numOps; i++) {
+        Operator* op = ops[i].op;
+        for (OpFluent& e : op->atStart.eff) staticFunction[e.variable.fncIndex] = false;
+        for (OpFluent& e : op->atEnd.eff) staticFunction[e.variable.fncIndex] = false;
+        for (OpConditionalEffect& ce : op->condEffects) {
+            for (OpFluent& e : ce.atStart.eff) staticFunction[e.variable.fncIndex] = false;
+            for (OpFluent& e : ce.atEnd.eff) staticFunction[e.variable.fncIndex] = false;
+        }
+    }
+}
+
+// Joins the static preconditions that contain a parameter with the facts of the initial state, and returns
+// the (sorted) objects of that parameter in the matching facts. Returns false if the parameter is not in
+// any static precondition
+bool Grounder::getStaticCandidates(GrounderOperator &op, unsigned int pIndex, vector<unsigned int> &objects) {
+    const vector<unsigned int>* best = nullptr;
+    GrounderAssignment *bestPrec = nullptr;
+    unsigned int bestSize = MAX_UNSIGNED_INT, bestPos = 0, numCandidates;
+    for (GrounderAssignment &p : op.staticPreconditions) {
+        unsigned int numArgs = p.params->size(), pos = 0;
+        while (pos < numArgs && !(p.params->at(pos).type == TERM_PARAMETER && p.params->at(pos).index == pIndex)) pos++;
+        if (pos == numArgs && !(p.value->type == TERM_PARAMETER && p.value->index == pIndex)) continue;
+        const vector<unsigned int>* c = getCandidates(op.paramValues.get(), p, numCandidates);
+        if (numCandidates < bestSize) {
+            best = c;
+            bestPrec = &p;
+            bestSize = numCandidates;
+            bestPos = pos;
+        }
+    }
+    if (bestPrec == nullptr) return false;
+    vector<ProgrammedValue> &vf = valuesByFunction[bestPrec->fncIndex];
+    for (unsigned int i = 0; i < bestSize; i++) {
+        ProgrammedValue &pv = vf[best == nullptr ? i : best->at(i)];
+        if (precMatches(op.paramValues.get(), op.op, *bestPrec, pv.varIndex, pv.valueIndex))
+            objects.push_back(bestPos < bestPrec->params->size() ? gTask->variables[pv.varIndex].params[bestPos] : pv.valueIndex);
+    }
+    std::sort(objects.begin(), objects.end());
+    objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+    return true;
+}
+
+// Checks the static preconditions that contain the given parameter and have all their parameters grounded
+bool Grounder::staticPreconditionsHold(GrounderOperator &op, unsigned int pIndex) {
+    for (GrounderAssignment &p : op.staticPreconditions) {
+        bool containsParam = p.value->type == TERM_PARAMETER && p.value->index == pIndex;
+        bool grounded = p.value->type != TERM_PARAMETER || !op.paramValues[p.value->index].empty();
+        keyParameters.clear();
+        for (unsigned int i = 0; i < p.params->size() && grounded; i++) {
+            Term &t = p.params->at(i);
+            if (t.type == TERM_PARAMETER) {
+                if (op.paramValues[t.index].empty()) grounded = false;
+                else keyParameters.push_back(op.paramValues[t.index].back());
+                if (t.index == pIndex) containsParam = true;
+            } else keyParameters.push_back(t.index);
+        }
+        if (!containsParam || !grounded) continue;
+        unsigned int varIndex = variableIndex.find(p.fncIndex, keyParameters);
+        unsigned int value = p.value->type == TERM_PARAMETER ? op.paramValues[p.value->index].back() : p.value->index;
+        if (varIndex == MAX_UNSIGNED_INT || gTask->reachedValues[varIndex].getLevel(value) == MAX_UNSIGNED_INT)
+            return false;
+    }
+    return true;
+}
+
 // Grounds a new action
 void Grounder::groundAction(GrounderOperator &op) {
     GroundedAction a(op.op->instantaneous, op.op->isTIL, op.op->isGoal);
@@ -278,10 +477,9 @@ void Grounder::groundAction(GrounderOperator &op) {
         a.parameters.push_back(op.paramValues[i].back());
     }
     if (!op.op->isGoal) {
-		std::string name = a.getName(gTask->task);
-		if (groundedActions.find(name) != groundedActions.end())
+		if (groundedActions.find(op.nameIndex, a.parameters) != MAX_UNSIGNED_INT)
             return;	// Repeated action
-		groundedActions[name] = a.index;
+		groundedActions.insert(op.nameIndex, a.parameters, a.index);
 	}
     for (unsigned int i = 0; i < op.op->controlVars.size(); i++) {
         a.controlVars.emplace_back(op.op->controlVars[i], i, gTask->task);
@@ -314,10 +512,8 @@ void Grounder::groundAction(GrounderOperator &op) {
 
 // Programs a new reached value
 void Grounder::programNewValue(GroundedCondition &eff) {
-    vector<unsigned int> &v = gTask->reachedValues[eff.varIndex];
-    if (v[eff.valueIndex] == MAX_UNSIGNED_INT) {     // New value
+    if (gTask->reachedValues[eff.varIndex].add(eff.valueIndex, currentLevel + 1)) {     // New value
         //cout << gTask->variables[eff.varIndex].toString(prepTask->task) << endl;
-        v[eff.valueIndex] = currentLevel + 1;
         auxValues->emplace_back(numValues, eff.varIndex, eff.valueIndex);
         numValues++;
     }
@@ -336,33 +532,66 @@ bool Grounder::objectIsCompatible(unsigned int objIndex, vector<unsigned int> &t
     return false;
 }
 
-// Checks whether a programmed value matches one of the preconditions of the operators
-void Grounder::match(ProgrammedValue &pv) {
-    vector<GrounderOperator*> &rf = opRequireFunction[gTask->variables[pv.varIndex].fncIndex];
-    for (unsigned int i = 0; i < rf.size(); i++) {
-        GrounderOperator* op = rf[i];
-        int precIndex = -1;
-		do {
-#ifdef _GROUNDER_TRACE_ON_
-            cout << gTask->variables[pv.varIndex].toString(prepTask->task) << "=" <<
-                gTask->task->objects[pv.valueIndex].toString() << endl;
-#endif
-            precIndex = matches(op, pv.varIndex, pv.valueIndex, precIndex + 1);
-            if (precIndex != -1) {  // Match found
-                op->newValueIndex = pv.index;
-                stackParameters(op, precIndex, pv.varIndex, pv.valueIndex);
-                completeMatch(op, 0);
-                unstackParameters(op, precIndex);
+// Matches the programmed values of the current level with the operators. The pairs (programmed value,
+// operator) are matched in parallel, in blocks, as they only read the facts of the previous levels. Blocks
+// with few pairs, as in most levels of small tasks, are matched in the calling thread. Then, the actions
+// are grounded sequentially, in the same order as if the values were matched one by one
+void Grounder::matchLevel() {
+    vector<GrounderLevelItem> items;
+    unsigned int numLevelValues = newValues->size(), i = 0;
+    while (i < numLevelValues) {
+        items.clear();
+        while (i < numLevelValues && items.size() < GROUNDER_LEVEL_BLOCK) {
+            vector<GrounderOperator*> &rf = opRequireFunction[gTask->variables[newValues->at(i).varIndex].fncIndex];
+            for (unsigned int j = 0; j < rf.size(); j++)
+                items.emplace_back(i, rf[j]);
+            i++;
+        }
+        std::atomic<unsigned int> next(0);
+        auto worker = [&](GrounderMatch *m) {
+            unsigned int k;
+            while ((k = next++) < items.size())
+                match(*m, items[k]);
+        };
+        unsigned int numThreads = std::min((unsigned int)items.size() / GROUNDER_MIN_ITEMS_PER_THREAD, (unsigned int)workers.size());
+        vector<std::thread> threads;
+        for (unsigned int t = 1; t < numThreads; t++)
+            threads.emplace_back(worker, &workers[t]);
+        worker(&workers[0]);
+        for (std::thread& t : threads)
+            t.join();
+        for (GrounderLevelItem &item : items) {
+            ProgrammedValue &pv = newValues->at(item.valueIndex);
+            for (GrounderMatchResult &r : item.results) {
+                if (!item.op->preconditions[r.trigger].grounded)    // Negative preconditions can be reached by previous matchings
+                    groundMatches(r, pv);
             }
-        } while (precIndex != -1);
+        }
     }
 }
 
+// Finds the matchings of a programmed value with the preconditions of an operator
+void Grounder::match(GrounderMatch &m, GrounderLevelItem &item) {
+    ProgrammedValue &pv = newValues->at(item.valueIndex);
+    m.initialize(item.op, pv.index);
+    int precIndex = -1;
+    do {
+#ifdef _GROUNDER_TRACE_ON_
+        cout << gTask->variables[pv.varIndex].toString(prepTask->task) << "=" <<
+            gTask->task->objects[pv.valueIndex].toString() << endl;
+#endif
+        precIndex = matches(m, item.op, pv.varIndex, pv.valueIndex, precIndex + 1);
+        if (precIndex != -1) {  // Match found
+            item.results.emplace_back(item.op, (unsigned int) precIndex);
+            findMatches(m, pv, item.results.back());
+        }
+    } while (precIndex != -1);
+}
+
 // Exchanges the levels of programmed values (newValues <-> auxValues)
 void Grounder::swapLevels() {
     for (unsigned int i = 0; i < auxValues->size(); i++) {
-        ProgrammedValue &pv = auxValues->at(i);
-        valuesByFunction[gTask->variables[pv.varIndex].fncIndex].push_back(pv);
+        addValueToFunction(auxValues->at(i));
     }
     std::unique_ptr<vector<ProgrammedValue>> aux = std::move(newValues);
     newValues = std::move(auxValues);
@@ -370,12 +599,26 @@ void Grounder::swapLevels() {
     auxValues->clear();
 }
 
+// Adds a programmed value to the list of values of its function, and to the indexes of its arguments
+void Grounder::addValueToFunction(ProgrammedValue &pv) {
+    GroundedVar &v = gTask->variables[pv.varIndex];
+    vector<ProgrammedValue> &vf = valuesByFunction[v.fncIndex];
+    vector<unordered_map<unsigned int, vector<unsigned int>>> &index = argumentIndex[v.fncIndex];
+    unsigned int position = vf.size();
+    vf.push_back(pv);
+    if (index.size() < v.params.size() + 1)
+        index.resize(v.params.size() + 1);
+    for (unsigned int i = 0; i < v.params.size(); i++)
+        index[i][v.params[i]].push_back(position);
+    index[v.params.size()][pv.valueIndex].push_back(position);
+}
+
 // Checks whether a fluent matches an operator precondition
-int Grounder::matches(GrounderOperator *op, unsigned int varIndex, unsigned int valueIndex, int startPrec) {
+int Grounder::matches(GrounderMatch &m, GrounderOperator *op, unsigned int varIndex, unsigned int valueIndex, int startPrec) {
     unsigned int fncIndex = gTask->variables[varIndex].fncIndex;
     for (unsigned int i = (unsigned int) startPrec; i < op->preconditions.size(); i++) {
         GrounderAssignment &p = op->preconditions[i];
-        if (!p.grounded && p.fncIndex == fncIndex && precMatches(op, p, varIndex, valueIndex)) {
+        if (!p.grounded && p.fncIndex == fncIndex && precMatches(m.paramValues.data(), op->op, p, varIndex, valueIndex)) {
             return (int) i;
         }
     }
@@ -383,117 +626,194 @@ int Grounder::matches(GrounderOperator *op, unsigned int varIndex, unsigned int
 }
 
 // Stacks the parameter values when a precondition matches with a fluent
-void Grounder::stackParameters(GrounderOperator *op, int precIndex, unsigned int varIndex, unsigned int valueIndex) {
-    unsigned int i;
-    GrounderAssignment &prec = op->preconditions[(unsigned int) precIndex];
+void Grounder::stackParameters(vector<unsigned int> *paramValues, GrounderAssignment &prec, unsigned int varIndex, unsigned int valueIndex) {
     GroundedVar &v = gTask->variables[varIndex];
-    for (i = 0; i < v.params.size(); i++)
+    for (unsigned int i = 0; i < v.params.size(); i++)
         if (prec.params->at(i).type == TERM_PARAMETER)
-            op->paramValues[prec.params->at(i).index].push_back(v.params[i]);
+            paramValues[prec.params->at(i).index].push_back(v.params[i]);
     if (prec.value->type == TERM_PARAMETER)
-        op->paramValues[prec.value->index].push_back(valueIndex);
-    prec.grounded = true;
+        paramValues[prec.value->index].push_back(valueIndex);
 }
 
 // Unstacks the last parameter values
-void Grounder::unstackParameters(GrounderOperator *op, int precIndex) {
-    unsigned int index;
-    GrounderAssignment &prec = op->preconditions[(unsigned int) precIndex];
+void Grounder::unstackParameters(vector<unsigned int> *paramValues, GrounderAssignment &prec) {
     for (unsigned int i = 0; i < prec.params->size(); i++)
-        if (prec.params->at(i).type == TERM_PARAMETER) {
-            index = prec.params->at(i).index;
-            op->paramValues[index].pop_back();
-        }
-    if (prec.value->type == TERM_PARAMETER) {
-        index = prec.value->index;
-        op->paramValues[index].pop_back();
-    }
-    prec.grounded = false;
-}
-
-// Checks whether a precondition p matches with a fluent (variable v = valueIndex)
-bool Grounder::precMatches(GrounderOperator *op, GrounderAssignment &p, unsigned int varIndex, unsigned int valueIndex) {
-    unsigned int paramIndex;
-     GroundedVar &v = gTask->variables[varIndex];
-     for (unsigned int i = 0; i < v.params.size(); i++) { // Check the parameters
-         paramIndex = p.params->at(i).index;
-         if (p.params->at(i).type == TERM_PARAMETER) {  // Parameter
-            vector<unsigned int> &paramValues = op->paramValues[paramIndex];
-            if (paramValues.size() == 0) {    // Ungrounded parameter, types should match
-               if (!objectIsCompatible(v.params[i], op->op->parameters[paramIndex].types)) {
-                  return false;
-               }
-            } else {                          // Grounded parameter, objects must coincide
-              if (paramValues.back() != v.params[i]) {
-                 return false;
-              }
+        if (prec.params->at(i).type == TERM_PARAMETER)
+            paramValues[prec.params->at(i).index].pop_back();
+    if (prec.value->type == TERM_PARAMETER)
+        paramValues[prec.value->index].pop_back();
+}
+
+// Checks whether a precondition p matches with a fluent (variable v = valueIndex). A parameter that appears
+// several times in the precondition must be matched with the same object
+bool Grounder::precMatches(vector<unsigned int> *paramValues, Operator *op, GrounderAssignment &p, unsigned int varIndex, unsigned int valueIndex) {
+    GroundedVar &v = gTask->variables[varIndex];
+    unsigned int numArgs = v.params.size();
+    for (unsigned int i = 0; i <= numArgs; i++) {
+        Term &t = i < numArgs ? p.params->at(i) : *p.value;
+        unsigned int obj = i < numArgs ? v.params[i] : valueIndex;
+        if (t.type == TERM_PARAMETER) {     // Parameter
+            vector<unsigned int> &values = paramValues[t.index];
+            if (values.size() > 0) {        // Grounded parameter, objects must coincide
+                if (values.back() != obj) return false;
+            } else {
+                unsigned int j = 0;         // Ungrounded parameter: check the previous arguments and the types
+                while (j < i && !(p.params->at(j).type == TERM_PARAMETER && p.params->at(j).index == t.index)) j++;
+                if (j < i) {
+                    if (v.params[j] != obj) return false;
+                } else if (!objectIsCompatible(obj, op->parameters[t.index].types)) {
+                    return false;
+                }
             }
-         } else {                           // Constant object
-             if (paramIndex != v.params[i]) {
-                 return false;
-             }
-         }
-     }
-     paramIndex = p.value->index;           // Check the value
-     if (p.value->type == TERM_PARAMETER) {             // Parameter
-        vector<unsigned int> &paramValues = op->paramValues[paramIndex];
-        if (paramValues.size() == 0) {    // Ungrounded parameter, types should match
-           return objectIsCompatible(valueIndex, op->op->parameters[paramIndex].types);
-        } else {                          // Grounded parameter, objects must coincide
-           return paramValues.back() == valueIndex;
+        } else {                            // Constant object
+            if (t.index != obj) return false;
         }
-     } else {                               // Constant object
-       return valueIndex == paramIndex;
-     }
+    }
+    return true;
 }
 
-// Completes the operator matching process
-void Grounder::completeMatch(GrounderOperator *op, unsigned int precIndex) {
-    GrounderAssignment *p = nullptr;
-     while (precIndex < op->preconditions.size()) {
-           p = &(op->preconditions[precIndex]);
-           if (!p->grounded) {
-              if (!p->value->type == TERM_PARAMETER && p->value->index == prepTask->task->CONSTANT_FALSE)
-                 p->grounded = true;
-			  else {
-#ifdef _GROUNDER_TRACE_ON_
-				  cout << "Precondition " << precIndex << "(" << gTask->task->functions[op->preconditions[precIndex].fncIndex].name << ") ungrounded" << endl;
-#endif				  
-				  break;
-			  }
-           }
-           precIndex++;
-     }
-     if (precIndex >= op->preconditions.size()) {  // All preconditions already grounded
-#ifdef _GROUNDER_TRACE_ON_
-		 cout << "All preconditions gounded" << endl;
-#endif
-		 groundRemainingParameters(*op);
-     } else {                                      // Continue with the precondition matching
-#ifdef _GROUNDER_TRACE_ON_
-		 cout << "Trying to ground precondition " << precIndex << ": " << gTask->task->functions[op->preconditions[precIndex].fncIndex].name << endl;
-#endif
-		vector<ProgrammedValue> &vf = valuesByFunction[p->fncIndex];
-        for (unsigned int i = 0; i < vf.size(); i++) {
-            ProgrammedValue &pv = vf[i];
-#ifdef _GROUNDER_TRACE_ON_
-			cout << "    Testing " << gTask->variables[pv.varIndex].toString(gTask->task) << "=" << gTask->task->objects[pv.valueIndex].name << endl;
-			cout << "    pv.index = " << pv.index << ", startNewValues = " << startNewValues << ", op->newValueIndex = " << op->newValueIndex << endl;
-#endif
-			if ((pv.index < startNewValues || pv.index >= op->newValueIndex)
-               && precMatches(op, *p, pv.varIndex, pv.valueIndex)) {
-#ifdef _GROUNDER_TRACE_ON_
-				cout << "    Match found with " << gTask->variables[pv.varIndex].toString(gTask->task) << "=" << gTask->task->objects[pv.valueIndex].name << endl;
-#endif
-				stackParameters(op, precIndex, pv.varIndex, pv.valueIndex);
-                completeMatch(op, precIndex + 1);
-                unstackParameters(op, precIndex);
+// Returns the candidate facts to match a precondition, given the current parameter values. The smallest
+// list of facts that share an argument with the precondition is selected. If no argument is known, the
+// result is nullptr and all the values of the function are candidates
+const vector<unsigned int>* Grounder::getCandidates(vector<unsigned int> *paramValues, GrounderAssignment &p, unsigned int &numCandidates) {
+    static const vector<unsigned int> noCandidates;
+    vector<unordered_map<unsigned int, vector<unsigned int>>> &index = argumentIndex[p.fncIndex];
+    const vector<unsigned int>* best = nullptr;
+    numCandidates = valuesByFunction[p.fncIndex].size();
+    if (index.empty()) return best;
+    unsigned int numArgs = p.params->size();
+    for (unsigned int i = 0; i <= numArgs; i++) {
+        Term &t = i < numArgs ? p.params->at(i) : *p.value;
+        unsigned int obj;
+        if (t.type == TERM_PARAMETER) {
+            if (paramValues[t.index].empty()) continue;
+            obj = paramValues[t.index].back();
+        } else {
+            obj = t.index;
+        }
+        unordered_map<unsigned int, vector<unsigned int>>::const_iterator it = index[i].find(obj);
+        if (it == index[i].end()) {
+            numCandidates = 0;
+            return &noCandidates;
+        }
+        if (it->second.size() < numCandidates) {
+            best = &(it->second);
+            numCandidates = best->size();
+        }
+    }
+    return best;
+}
+
+// Joins the pending preconditions (the first numPending ones) with the reached facts. The most selective
+// precondition is matched first. Facts programmed in the current level can only be used if they are not
+// older than the programmed value that triggered the matching. The complete matches are stored in the result,
+// unless firstOnly is true: then, the search stops at the first complete match
+bool Grounder::joinPreconditions(GrounderMatch &m, unsigned int numPending, bool firstOnly) {
+    if (numPending == 0) {
+        if (!firstOnly) m.result->bindings.insert(m.result->bindings.end(), m.factPosition.begin(), m.factPosition.end());
+        return true;
+    }
+    unsigned int best = 0, bestSize = MAX_UNSIGNED_INT, numCandidates;
+    const vector<unsigned int>* candidates = nullptr;
+    for (unsigned int i = 0; i < numPending && bestSize > 0; i++) {
+        const vector<unsigned int>* c = getCandidates(m.paramValues.data(), m.op->preconditions[m.pending[i]], numCandidates);
+        if (numCandidates < bestSize) {
+            best = i;
+            bestSize = numCandidates;
+            candidates = c;
+        }
+    }
+    if (bestSize == 0) return false;
+    unsigned int precIndex = m.pending[best];
+    GrounderAssignment &p = m.op->preconditions[precIndex];
+    vector<ProgrammedValue> &vf = valuesByFunction[p.fncIndex];
+    std::swap(m.pending[best], m.pending[numPending - 1]);
+    bool found = false;
+    for (unsigned int i = 0; i < bestSize; i++) {
+        unsigned int position = candidates == nullptr ? i : candidates->at(i);
+        ProgrammedValue &pv = vf[position];
+        if ((pv.index < startNewValues || pv.index >= m.newValueIndex)
+            && precMatches(m.paramValues.data(), m.op->op, p, pv.varIndex, pv.valueIndex)) {
+            m.factPosition[precIndex] = position;
+            stackParameters(m.paramValues.data(), p, pv.varIndex, pv.valueIndex);
+            found = joinPreconditions(m, numPending - 1, firstOnly) || found;
+            unstackParameters(m.paramValues.data(), p);
+            if (found && firstOnly) break;
+        }
+    }
+    std::swap(m.pending[best], m.pending[numPending - 1]);
+    return found;
+}
+
+// Finds the complete matches of an operator, given the programmed value that matches its trigger precondition.
+// Negative preconditions are not matched. When the operator cannot be completely matched, the reach limit
+// is also computed: the negative preconditions that the left-to-right matching would have reached
+void Grounder::findMatches(GrounderMatch &m, ProgrammedValue &pv, GrounderMatchResult &r) {
+    GrounderOperator *op = m.op;
+    unsigned int numPrecs = op->preconditions.size();
+    bool pendingFalsePrec = false;
+    m.result = &r;
+    m.trigger = r.trigger;
+    m.pending.clear();
+    for (unsigned int i = 0; i < numPrecs; i++) {
+        if (i == m.trigger) continue;
+        if (op->preconditions[i].isFalse(prepTask->task->CONSTANT_FALSE)) {
+            if (!op->preconditions[i].grounded) pendingFalsePrec = true;
+        }
+        else m.pending.push_back(i);
+    }
+    stackParameters(m.paramValues.data(), op->preconditions[m.trigger], pv.varIndex, pv.valueIndex);
+    joinPreconditions(m, m.pending.size(), false);
+    if (r.numBindings() > 0 || !pendingFalsePrec) {
+        r.reachLimit = numPrecs;
+    } else {
+        vector<unsigned int> pending = m.pending;
+        r.reachLimit = numPrecs;
+        for (unsigned int n = 1; n <= pending.size(); n++) {   // Prefixes of the preconditions, in order
+            m.pending.assign(pending.begin(), pending.begin() + n);
+            if (!joinPreconditions(m, n, true)) {
+                r.reachLimit = pending[n - 1];
+                break;
             }
         }
-     }
-#ifdef _GROUNDER_TRACE_ON_
-	 cout << "Finishing" << endl;
-#endif
+        m.pending = pending;
+    }
+    unstackParameters(m.paramValues.data(), op->preconditions[m.trigger]);
+}
+
+// Grounds the complete matches of an operator, in the same order as the left-to-right matching of its
+// preconditions: sorted by the positions of the matched facts, taking the preconditions in order
+void Grounder::groundMatches(GrounderMatchResult &r, ProgrammedValue &pv) {
+    GrounderOperator *op = r.op;
+    unsigned int numPrecs = op->preconditions.size();
+    vector<unsigned int> pending;
+    for (unsigned int i = 0; i < numPrecs; i++) {
+        GrounderAssignment &p = op->preconditions[i];
+        if (i == r.trigger) continue;
+        if (!p.isFalse(prepTask->task->CONSTANT_FALSE)) pending.push_back(i);
+        else if (i < r.reachLimit) p.grounded = true;
+    }
+    unsigned int numBindings = r.numBindings();
+    vector<unsigned int> order(numBindings);
+    for (unsigned int i = 0; i < numBindings; i++) order[i] = i;
+    const unsigned int *b = r.bindings.data();
+    std::sort(order.begin(), order.end(), [b, numPrecs](unsigned int x, unsigned int y) {
+        return std::lexicographical_compare(b + x * numPrecs, b + (x + 1) * numPrecs, b + y * numPrecs, b + (y + 1) * numPrecs);
+    });
+    stackParameters(op->paramValues.get(), op->preconditions[r.trigger], pv.varIndex, pv.valueIndex);
+    for (unsigned int i = 0; i < numBindings; i++) {
+        const unsigned int *positions = b + order[i] * numPrecs;
+        for (unsigned int j : pending) {
+            ProgrammedValue &f = valuesByFunction[op->preconditions[j].fncIndex][positions[j]];
+            stackParameters(op->paramValues.get(), op->preconditions[j], f.varIndex, f.valueIndex);
+        }
+        groundRemainingParameters(*op);
+        for (unsigned int j : pending)
+            unstackParameters(op->paramValues.get(), op->preconditions[j]);
+    }
+    unstackParameters(op->paramValues.get(), op->preconditions[r.trigger]);
+    r.bindings.clear();
+    r.bindings.shrink_to_fit();
 }
 
 // Check equality conditions
@@ -587,11 +907,8 @@ unsigned int Grounder::createNewVariable(const Literal &l, const vector<unsigned
         if (l.params[i].type == TERM_PARAMETER) v.params.push_back(opParameters[l.params[i].index]);
         else v.params.push_back(l.params[i].index);
     gTask->variables.push_back(v);
-    const string &name = getVariableName(v.fncIndex, v.params);
-    variableIndex[name] = v.index;
-    unsigned int notReached = MAX_UNSIGNED_INT;
-    if (v.isNumeric) gTask->reachedValues.emplace_back(0, notReached);
-    else gTask->reachedValues.emplace_back(prepTask->task->objects.size(), notReached);
+    variableIndex.insert(v.fncIndex, v.params, v.index);
+    gTask->reachedValues.emplace_back();
     return v.index;    
 }
 
@@ -1167,13 +1484,14 @@ void Grounder::removeStaticVariables(vector<bool> &staticVar, vector<unsigned in
     for (unsigned int i = 0; i < staticVar.size(); i++)
         if (!staticVar[i]) numNonStaticVars++;
     vector<GroundedVar> oldVariables = gTask->variables;
-    vector< vector<unsigned int> > oldReachedValues = gTask->reachedValues;
+    vector<GroundedReachedValues> oldReachedValues = std::move(gTask->reachedValues);
     gTask->variables.resize(numNonStaticVars);
+    gTask->reachedValues.clear();
     gTask->reachedValues.resize(numNonStaticVars);
     for (unsigned int i = 0; i < staticVar.size(); i++) {
         if (!staticVar[i]) {
             gTask->variables[newIndex[i]] = oldVariables[i];
-            gTask->reachedValues[newIndex[i]] = oldReachedValues[i];
+            gTask->reachedValues[newIndex[i]] = std::move(oldReachedValues[i]);
         }
     }
     i = 0;
@@ -1932,12 +2250,146 @@ GroundedMetric Grounder::groundMetric(Metric* m) {
 								gm.terms.push_back(groundMetric(&(m->terms[i])));
 							break;
 	case MT_IS_VIOLATED:	gm.index = preferenceIndex[m->preferenceName];	break;
-	case MT_FLUENT:			gm.index = variableIndex[getVariableName(m->function, m->parameters)];	break;
+	case MT_FLUENT:			gm.index = getVariableIndex(m->function, m->parameters);
+							if (gm.index == MAX_UNSIGNED_INT) {		// Fluent not used in the task
+								Literal l;
+								l.fncIndex = m->function;
+								for (unsigned int p : m->parameters) l.params.emplace_back(TERM_CONSTANT, p);
+								gm.index = createNewVariable(l, m->parameters);
+							}
+							break;
 	case MT_TOTAL_TIME:;
 	}
 	return gm;
 }
 
+// Removes the actions that cannot contribute to reach the goals. Starting from the goal conditions, an
+// action is relevant if it produces a relevant value, and then its conditions become relevant too.
+// The time-initial literals are always kept, and the metric only adds relevant variables when it is
+// maximized. Tasks with preferences or trajectory constraints are not pruned
+void Grounder::removeIrrelevantActions() {
+    unsigned int numVars = gTask->variables.size(), numActions = gTask->actions.size();
+    if (!gTask->constraints.empty()) return;
+    for (GroundedAction &a : gTask->actions)
+        if (!a.preferences.empty()) return;
+    for (GroundedAction &g : gTask->goals)
+        if (!g.preferences.empty()) return;
+    vector<vector<unsigned int>> producers(numVars);    // Actions that modify each variable
+    for (unsigned int i = 0; i < numActions; i++) {
+        GroundedAction &a = gTask->actions[i];
+        auto addProducer = [&](unsigned int v) { if (producers[v].empty() || producers[v].back() != i) producers[v].push_back(i); };
+        for (GroundedCondition &e : a.startEff) addProducer(e.varIndex);
+        for (GroundedCondition &e : a.endEff) addProducer(e.varIndex);
+        for (GroundedNumericEffect &e : a.startNumEff) addProducer(e.varIndex);
+        for (GroundedNumericEffect &e : a.endNumEff) addProducer(e.varIndex);
+        for (GroundedConditionalEffect &ce : a.conditionalEffect) {
+            for (GroundedCondition &e : ce.startEff) addProducer(e.varIndex);
+            for (GroundedCondition &e : ce.endEff) addProducer(e.varIndex);
+            for (GroundedNumericEffect &e : ce.startNumEff) addProducer(e.varIndex);
+            for (GroundedNumericEffect &e : ce.endNumEff) addProducer(e.varIndex);
+        }
+    }
+    relevantValues.clear();
+    relevantValues.resize(numVars);
+    relevantNumVar.assign(numVars, false);
+    relevanceQueue.clear();
+    vector<bool> relevant(numActions, false);
+    for (GroundedAction &g : gTask->goals)
+        addRelevantConditions(g);
+    for (unsigned int i = 0; i < numActions; i++)
+        if (gTask->actions[i].isTIL) {
+            relevant[i] = true;
+            addRelevantConditions(gTask->actions[i]);
+        }
+    if (gTask->metricType == '>')
+        addRelevantMetric(gTask->metric);
+    while (!relevanceQueue.empty()) {
+        GroundedCondition v = relevanceQueue.back();
+        relevanceQueue.pop_back();
+        for (unsigned int i : producers[v.varIndex]) {
+            if (!relevant[i] && producesRelevantValue(gTask->actions[i], v)) {
+                relevant[i] = true;
+                addRelevantConditions(gTask->actions[i]);
+            }
+        }
+    }
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < numActions; i++) {
+        if (relevant[i]) {
+            if (n != i) gTask->actions[n] = std::move(gTask->actions[i]);
+            gTask->actions[n].index = n;
+            n++;
+        }
+    }
+    numIrrelevantActions = numActions - n;
+    gTask->actions.erase(gTask->actions.begin() + n, gTask->actions.end());
+    relevantValues.clear();
+    relevantNumVar.clear();
+}
+
+// Annotates a relevant (variable, value) pair. MAX_UNSIGNED_INT is used as value for the numeric variables
+void Grounder::addRelevantValue(unsigned int varIndex, unsigned int valueIndex) {
+    if (valueIndex == MAX_UNSIGNED_INT) {
+        if (relevantNumVar[varIndex]) return;
+        relevantNumVar[varIndex] = true;
+    } else if (!relevantValues[varIndex].add(valueIndex, 0)) return;
+    relevanceQueue.emplace_back(varIndex, valueIndex);
+}
+
+// Annotates the numeric variables of an expression as relevant
+void Grounder::addRelevantExpression(GroundedNumericExpression &e) {
+    if (e.type == GE_VAR) addRelevantValue(e.index, MAX_UNSIGNED_INT);
+    for (GroundedNumericExpression &t : e.terms)
+        addRelevantExpression(t);
+}
+
+// Annotates the numeric variables of the metric as relevant
+void Grounder::addRelevantMetric(GroundedMetric &m) {
+    if (m.type == MT_FLUENT) addRelevantValue(m.index, MAX_UNSIGNED_INT);
+    for (GroundedMetric &t : m.terms)
+        addRelevantMetric(t);
+}
+
+// Annotates the conditions of an action, and the variables used in its duration and numeric effects, as relevant
+void Grounder::addRelevantConditions(GroundedAction &a) {
+    for (GroundedCondition &c : a.startCond) addRelevantValue(c.varIndex, c.valueIndex);
+    for (GroundedCondition &c : a.overCond) addRelevantValue(c.varIndex, c.valueIndex);
+    for (GroundedCondition &c : a.endCond) addRelevantValue(c.varIndex, c.valueIndex);
+    for (vector<GroundedNumericCondition>* cond : {&a.startNumCond, &a.overNumCond, &a.endNumCond})
+        for (GroundedNumericCondition &c : *cond)
+            for (GroundedNumericExpression &e : c.terms) addRelevantExpression(e);
+    for (GroundedDuration &d : a.duration) addRelevantExpression(d.exp);
+    for (GroundedNumericEffect &e : a.startNumEff) addRelevantExpression(e.exp);
+    for (GroundedNumericEffect &e : a.endNumEff) addRelevantExpression(e.exp);
+    for (GroundedConditionalEffect &ce : a.conditionalEffect) {
+        for (GroundedCondition &c : ce.startCond) addRelevantValue(c.varIndex, c.valueIndex);
+        for (GroundedCondition &c : ce.endCond) addRelevantValue(c.varIndex, c.valueIndex);
+        for (vector<GroundedNumericCondition>* cond : {&ce.startNumCond, &ce.endNumCond})
+            for (GroundedNumericCondition &c : *cond)
+                for (GroundedNumericExpression &e : c.terms) addRelevantExpression(e);
+        for (GroundedNumericEffect &e : ce.startNumEff) addRelevantExpression(e.exp);
+        for (GroundedNumericEffect &e : ce.endNumEff) addRelevantExpression(e.exp);
+    }
+}
+
+// Checks if an action produces a relevant (variable, value) pair, or modifies a relevant numeric variable
+bool Grounder::producesRelevantValue(GroundedAction &a, GroundedCondition &v) {
+    auto produces = [&](vector<GroundedCondition> &eff, vector<GroundedNumericEffect> &numEff) {
+        if (v.valueIndex == MAX_UNSIGNED_INT) {
+            for (GroundedNumericEffect &e : numEff)
+                if (e.varIndex == v.varIndex) return true;
+        } else {
+            for (GroundedCondition &e : eff)
+                if (e.varIndex == v.varIndex && e.valueIndex == v.valueIndex) return true;
+        }
+        return false;
+    };
+    if (produces(a.startEff, a.startNumEff) || produces(a.endEff, a.endNumEff)) return true;
+    for (GroundedConditionalEffect &ce : a.conditionalEffect)
+        if (produces(ce.startEff, ce.startNumEff) || produces(ce.endEff, ce.endNumEff)) return true;
+    return false;
+}
+
 // Checks if there are numeric conditions that can already be evaluated
 void Grounder::checkNumericConditions() {
 	unsigned int i = 0;
@@ -1971,6 +2423,120 @@ void Grounder::checkNumericConditions() {
 	}
 }
 
+// Removes the actions whose conditions and effects are identical to those of a previous action, which
+// appear when the parameters that distinguish them only occur in static conditions (e.g. interchangeable
+// vehicles), and the actions whose conditions are a strict superset of those of another action with the
+// same effects and duration. The remaining action is a valid grounding of the task, so the plans are
+// printed with its own name. Actions with control variables, conditional effects or preferences, and the
+// time-initial literals, are always kept
+void Grounder::removeRedundantActions() {
+    unsigned int numActions = gTask->actions.size();
+    vector<GrounderActionSignature> signature;
+    signature.reserve(numActions);
+    unordered_map<size_t, vector<unsigned int>> sameEffectHash;
+    for (unsigned int i = 0; i < numActions; i++) {
+        GroundedAction &a = gTask->actions[i];
+        signature.emplace_back(a);
+        if (!a.isTIL && a.controlVars.empty() && a.conditionalEffect.empty() && a.preferences.empty())
+            sameEffectHash[signature[i].effectHash].push_back(i);
+    }
+    vector<bool> removed(numActions, false);
+    for (auto &group : sameEffectHash) {
+        vector<unsigned int> &candidates = group.second;
+        if (candidates.size() < 2) continue;
+        unordered_map<size_t, vector<unsigned int>> sameConditionHash;
+        vector<unsigned int> kept;
+        for (unsigned int i : candidates) {
+            GroundedAction &a = gTask->actions[i];
+            vector<unsigned int> &previous = sameConditionHash[signature[i].conditionHash];
+            bool duplicate = false;
+            for (unsigned int j : previous) {
+                GroundedAction &b = gTask->actions[j];
+                if (sameEffects(a, signature[i], b, signature[j]) && sameConditions(a, signature[i], b, signature[j])) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate) {
+                removed[i] = true;
+                numDuplicateActions++;
+            } else {
+                previous.push_back(i);
+                kept.push_back(i);
+            }
+        }
+        if (kept.size() < 2 || kept.size() > GROUNDER_DOMINANCE_GROUP) continue;
+        // Only strict dominance is considered, and an action is never removed because of an already
+        // removed one, so at least one of the non-dominated actions is always kept
+        for (unsigned int i : kept) {
+            GroundedAction &a = gTask->actions[i];
+            for (unsigned int j : kept) {
+                if (i == j || removed[j]) continue;
+                GroundedAction &b = gTask->actions[j];
+                if (sameEffects(a, signature[i], b, signature[j]) && weakerConditions(b, signature[j], a, signature[i])
+                    && !weakerConditions(a, signature[i], b, signature[j])) {
+                    removed[i] = true;
+                    numDominatedActions++;
+                    break;
+                }
+            }
+        }
+    }
+    if (numDuplicateActions + numDominatedActions == 0) return;
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < numActions; i++) {
+        if (!removed[i]) {
+            if (n != i) gTask->actions[n] = std::move(gTask->actions[i]);
+            gTask->actions[n].index = n;
+            n++;
+        }
+    }
+    gTask->actions.erase(gTask->actions.begin() + n, gTask->actions.end());
+}
+
+// Checks if two actions have the same effects and duration
+bool Grounder::sameEffects(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2) {
+    if (a1.instantaneous != a2.instantaneous || s1.eff[0] != s2.eff[0] || s1.eff[1] != s2.eff[1] ||
+        a1.duration.size() != a2.duration.size() || a1.startNumEff.size() != a2.startNumEff.size() ||
+        a1.endNumEff.size() != a2.endNumEff.size())
+        return false;
+    for (unsigned int i = 0; i < a1.duration.size(); i++)
+        if (!a1.duration[i].equals(a2.duration[i])) return false;
+    for (unsigned int i = 0; i < a1.startNumEff.size(); i++)
+        if (!a1.startNumEff[i].equals(a2.startNumEff[i])) return false;
+    for (unsigned int i = 0; i < a1.endNumEff.size(); i++)
+        if (!a1.endNumEff[i].equals(a2.endNumEff[i])) return false;
+    return true;
+}
+
+// Checks if two actions have the same conditions. The numeric conditions are compared as sets, since
+// their order in the action is not canonical
+bool Grounder::sameConditions(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2) {
+    for (unsigned int t = 0; t < 3; t++)
+        if (s1.cond[t] != s2.cond[t]) return false;
+    return weakerConditions(a1, s1, a2, s2) && weakerConditions(a2, s2, a1, s1);
+}
+
+// Checks if the conditions of the first action are a subset of the conditions of the second one
+bool Grounder::weakerConditions(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2) {
+    for (unsigned int t = 0; t < 3; t++)
+        if (!std::includes(s2.cond[t].begin(), s2.cond[t].end(), s1.cond[t].begin(), s1.cond[t].end())) return false;
+    vector<GroundedNumericCondition> *c1[3] = {&a1.startNumCond, &a1.overNumCond, &a1.endNumCond};
+    vector<GroundedNumericCondition> *c2[3] = {&a2.startNumCond, &a2.overNumCond, &a2.endNumCond};
+    for (unsigned int t = 0; t < 3; t++) {
+        for (GroundedNumericCondition &c : *(c1[t])) {
+            bool found = false;
+            for (GroundedNumericCondition &d : *(c2[t]))
+                if (c.equals(d)) {
+                    found = true;
+                    break;
+                }
+            if (!found) return false;
+        }
+    }
+    return true;
+}
+
 // Checks if a numeric condition can be evaluated. Returns 0 if it is not possible.
 // Otherwise, returns 1 if the condition holds or -1 otherwise.
 int Grounder::checkNumericCondition(GroundedNumericCondition* c) {
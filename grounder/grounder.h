@@ -16,6 +16,12 @@
 
 // EPSILON for temporal scheduling
 #define EPSILON 0.001f
+// Number of (programmed value, operator) pairs matched in parallel before grounding their actions
+#define GROUNDER_LEVEL_BLOCK 4096
+// Minimum number of pairs for each matching thread. Smaller blocks are matched in the calling thread
+#define GROUNDER_MIN_ITEMS_PER_THREAD 64
+// Maximum number of actions with the same effects that are compared pairwise to find dominated actions
+#define GROUNDER_DOMINANCE_GROUP 256
 
 // Class for assigments grounding
 class GrounderAssignment {
@@ -25,6 +31,8 @@ public:
     bool grounded;
     Term *value;
     GrounderAssignment(OpFluent &f);
+    // Negative preconditions are not matched with facts
+    inline bool isFalse(unsigned int constantFalse) { return value->type == TERM_CONSTANT && value->index == constantFalse; }
 };
 
 // Class for operators grounding
@@ -32,15 +40,53 @@ class GrounderOperator {
 public:
     int index;
     Operator *op;
+    unsigned int nameIndex;                     // Operators with the same name share this index
     unsigned int numParams;
     std::unique_ptr<std::vector<unsigned int>[]> paramValues;  
     std::unique_ptr<std::vector<unsigned int>[]> compatibleObjectsWithParam;  
-    unsigned int newValueIndex;
     std::vector<GrounderAssignment> preconditions;
+    std::vector<GrounderAssignment> staticPreconditions;    // At-end preconditions on static functions
     
     void initialize(Operator &o);
 };
 
+// Result of the matching of an operator, triggered by a programmed value that matches one of its preconditions
+class GrounderMatchResult {
+public:
+    GrounderOperator *op;
+    unsigned int trigger;                       // Precondition matched by the programmed value
+    unsigned int reachLimit;                    // Negative preconditions before this index are reached
+    std::vector<unsigned int> bindings;         // Complete matches (position of the matched fact of each precondition, consecutively)
+
+    GrounderMatchResult(GrounderOperator *op, unsigned int trigger) : op(op), trigger(trigger), reachLimit(0) { }
+    inline unsigned int numBindings() { return op->preconditions.empty() ? 0 : bindings.size() / op->preconditions.size(); }
+};
+
+// Matching state of a worker thread. It has its own parameter stacks, so the operators are not modified
+// while the facts are joined
+class GrounderMatch {
+public:
+    GrounderOperator *op;
+    unsigned int trigger;
+    unsigned int newValueIndex;                 // Index of the programmed value
+    std::vector<std::vector<unsigned int>> paramValues;
+    std::vector<unsigned int> pending;          // Preconditions to match
+    std::vector<unsigned int> factPosition;     // For each precondition, position of the matched fact in valuesByFunction
+    GrounderMatchResult *result;
+
+    void initialize(GrounderOperator *op, unsigned int newValueIndex);
+};
+
+// Matchings of a programmed value with the preconditions of an operator, computed in parallel in each level
+class GrounderLevelItem {
+public:
+    unsigned int valueIndex;                    // Position in newValues
+    GrounderOperator *op;
+    std::vector<GrounderMatchResult> results;   // One per matched precondition
+
+    GrounderLevelItem(unsigned int valueIndex, GrounderOperator *op) : valueIndex(valueIndex), op(op) { }
+};
+
 // Class to program facts in the initial state
 class ProgrammedValue {
 public:
@@ -58,6 +104,42 @@ public:
     float numericValue;
 };
 
+// Open-addressing hash table that maps tuples of integers (a function or operator name index, followed
+// by the object parameters) to an index. The tuples are stored consecutively in a pool
+class GrounderTupleTable {
+private:
+    class Slot {
+    public:
+        uint64_t hash;
+        unsigned int offset;                    // Position of the tuple in the pool, MAX_UNSIGNED_INT if empty
+        unsigned int value;
+    };
+    std::vector<Slot> slots;                    // The size is a power of two
+    std::vector<unsigned int> pool;             // Length of the tuple, head and parameters
+    unsigned int numKeys;
+
+    static uint64_t getHash(unsigned int head, const unsigned int *params, unsigned int numParams);
+    unsigned int findSlot(uint64_t hash, unsigned int head, const unsigned int *params, unsigned int numParams);
+    void grow();
+
+public:
+    GrounderTupleTable();
+    unsigned int find(unsigned int head, const std::vector<unsigned int> &params);
+    void insert(unsigned int head, const std::vector<unsigned int> &params, unsigned int value);
+    void clear();
+};
+
+// Sorted (variable, value) codes of the conditions and effects of a grounded action, used to find
+// duplicate and dominated actions
+class GrounderActionSignature {
+public:
+    std::vector<uint64_t> cond[3];          // At start, over all and at end
+    std::vector<uint64_t> eff[2];           // At start and at end
+    size_t effectHash;
+    size_t conditionHash;
+    GrounderActionSignature(GroundedAction &a);
+};
+
 // Class for task grounding
 class Grounder {
 private:
@@ -67,18 +149,28 @@ private:
     unsigned int numOps;
     std::unique_ptr<GrounderOperator[]> ops;
     std::unique_ptr<std::vector<GrounderOperator*>[]> opRequireFunction;
-    std::unordered_map<std::string,unsigned int> variableIndex;
+    std::unique_ptr<bool[]> staticFunction;                     // Functions not modified by any operator
+    GrounderTupleTable variableIndex;                           // (function, parameters) -> variable
     std::unordered_map<std::string,unsigned int> preferenceIndex;
     std::unique_ptr<std::vector<ProgrammedValue>> newValues;
     std::unique_ptr<std::vector<ProgrammedValue>> auxValues;
     std::unique_ptr<std::vector<ProgrammedValue>[]> valuesByFunction;
-	std::unordered_map<std::string, unsigned int> groundedActions;
+    // For each function and argument position (the value is the last one), positions in valuesByFunction of the facts with each object
+    std::unique_ptr<std::vector<std::unordered_map<unsigned int, std::vector<unsigned int>>>[]> argumentIndex;
+    std::vector<GrounderMatch> workers;                         // Matching state of each thread
+	GrounderTupleTable groundedActions;                         // (operator name, parameters) -> action
 	unsigned int numValues;
     unsigned int startNewValues;
+    unsigned int numGroundedActions;                            // Before the relevance analysis
+    unsigned int numIrrelevantActions;
+    unsigned int numDuplicateActions;
+    unsigned int numDominatedActions;
+    std::vector<GroundedReachedValues> relevantValues;          // (variable, value) pairs that can contribute to the goals
+    std::vector<bool> relevantNumVar;
+    std::vector<GroundedCondition> relevanceQueue;              // The value is MAX_UNSIGNED_INT for numeric variables
     unsigned int currentLevel;
     
-    std::string getVariableName(unsigned int function, const std::vector<unsigned int> &parameters);
-    std::string getVariableName(const Literal &l, const std::vector<unsigned int> &opParameters);
+    std::vector<unsigned int> keyParameters;                    // Buffer to build the parameters of a variable
     void initTypesMatrix();
     void clearMemory();
     void addTypeToMatrix(unsigned int typeIndex, unsigned int subtypeIndex);
@@ -86,18 +178,26 @@ private:
     void addOpToRequireFunction(GrounderOperator *op, unsigned int f);
     void initInitialState();
     void createVariable(const Fact &f);
-    unsigned int getVariableIndex(const Fact &f);
+    unsigned int getVariableIndex(unsigned int function, const std::vector<unsigned int> &parameters);
     unsigned int getVariableIndex(const Literal &l, const std::vector<unsigned int> &opParameters);
     void groundRemainingParameters(GrounderOperator &op);
+    void initStaticFunctions();
+    bool getStaticCandidates(GrounderOperator &op, unsigned int pIndex, std::vector<unsigned int> &objects);
+    bool staticPreconditionsHold(GrounderOperator &op, unsigned int pIndex);
     void groundAction(GrounderOperator &op);
     bool objectIsCompatible(unsigned int objIndex, std::vector<unsigned int> &types);
-    void match(ProgrammedValue &pv);
+    void matchLevel();
+    void match(GrounderMatch &m, GrounderLevelItem &item);
     void swapLevels();
-    int matches(GrounderOperator *op, unsigned int varIndex, unsigned int valueIndex, int startPrec);
-    void stackParameters(GrounderOperator *op, int precIndex, unsigned int varIndex, unsigned int valueIndex);
-    void completeMatch(GrounderOperator *op, unsigned int precIndex);
-    void unstackParameters(GrounderOperator *op, int precIndex);
-    bool precMatches(GrounderOperator *op, GrounderAssignment &p, unsigned int varIndex, unsigned int valueIndex);
+    void addValueToFunction(ProgrammedValue &pv);
+    int matches(GrounderMatch &m, GrounderOperator *op, unsigned int varIndex, unsigned int valueIndex, int startPrec);
+    void stackParameters(std::vector<unsigned int> *paramValues, GrounderAssignment &prec, unsigned int varIndex, unsigned int valueIndex);
+    void unstackParameters(std::vector<unsigned int> *paramValues, GrounderAssignment &prec);
+    bool precMatches(std::vector<unsigned int> *paramValues, Operator *op, GrounderAssignment &p, unsigned int varIndex, unsigned int valueIndex);
+    void findMatches(GrounderMatch &m, ProgrammedValue &pv, GrounderMatchResult &r);
+    bool joinPreconditions(GrounderMatch &m, unsigned int numPending, bool firstOnly);
+    const std::vector<unsigned int>* getCandidates(std::vector<unsigned int> *paramValues, GrounderAssignment &p, unsigned int &numCandidates);
+    void groundMatches(GrounderMatchResult &r, ProgrammedValue &pv);
     bool checkEqualityConditions(GrounderOperator &op, GroundedAction &a);
     bool groundPreconditions(GrounderOperator &op, GroundedAction &a);
     bool groundPreconditions(std::vector<OpFluent> &opCond, std::vector<unsigned int> &parameters, std::vector<GroundedCondition> &aCond);
@@ -149,6 +249,16 @@ private:
     GroundedConstraint groundConstraint(GroundedConstraint* condition, unsigned int numParam, std::unordered_map<unsigned int, unsigned int>* parameters);
     GroundedMetric groundMetric(Metric* m);
 	void removeStaticVariables(GroundedMetric &m, std::vector<bool> &staticVar, std::vector<unsigned int> &newIndex, std::vector<VariableValue> &value);
+    void removeIrrelevantActions();
+    void addRelevantValue(unsigned int varIndex, unsigned int valueIndex);
+    void addRelevantExpression(GroundedNumericExpression &e);
+    void addRelevantMetric(GroundedMetric &m);
+    void addRelevantConditions(GroundedAction &a);
+    bool producesRelevantValue(GroundedAction &a, GroundedCondition &v);
+    void removeRedundantActions();
+    bool sameEffects(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2);
+    bool sameConditions(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2);
+    bool weakerConditions(GroundedAction &a1, GrounderActionSignature &s1, GroundedAction &a2, GrounderActionSignature &s2);
 	void checkNumericConditions();
 	int checkNumericCondition(GroundedNumericCondition* c);
     void checkNumericEffectsNotRequired();
@@ -161,6 +271,10 @@ private:
 public:
  Grounder(std::unique_ptr<PreprocessedTask> &prepTask);
  void groundTask(bool keepStaticData, std::unique_ptr<GroundedTask> &gTaskOut);
+ inline unsigned int getNumGroundedActions() { return numGroundedActions; }
+ inline unsigned int getNumIrrelevantActions() { return numIrrelevantActions; }
+ inline unsigned int getNumDuplicateActions() { return numDuplicateActions; }
+ inline unsigned int getNumDominatedActions() { return numDominatedActions; }
 };
 
 #endif
@@ -1,7 +1,6 @@
 #include "evaluator.h"
 #include <time.h>
-#include "numericRPG.h"
-#include "hFF.h"
+#include <unordered_set>
 using namespace std;
 
 /********************************************************/
@@ -15,19 +14,23 @@ using namespace std;
 /* CLASS: Evaluator                                     */
 /********************************************************/
 
-// Evaluates a plan. Its heuristic value is stored in the plan (p->h)
+// Evaluates a plan. Its heuristic value is stored in the plan (p->h). The heuristic cache is
+// checked first, as different plans can lead to the same frontier state
 void Evaluator::evaluate(std::shared_ptr<Plan> p) {
 	int limit = p->parentPlan.lock()->h;
-	if (numericConditionsOrConditionalEffects) {
-		NumericRPG rpg(p->fs, tilActions, task, limit);
-		p->h = rpg.evaluate();
-	}
-	else {
-		FF_RPG rpg(p->fs, tilActions, task);
-		p->h = rpg.evaluate();
+	int cacheLimit = numericConditionsOrConditionalEffects ? std::min(limit, 100) : 0;	// Only the numeric RPG depends on the limit
+	uint64_t key = HeuristicCache::getKey(p->fs.get(), cacheLimit);
+	if (!cache.find(key, p->fs.get(), cacheLimit, &p->h)) {
+		if (numericConditionsOrConditionalEffects) {
+			p->h = numericRPG.evaluate(p->fs, tilActions, limit);
+		}
+		else {
+			p->h = ffRPG.evaluate(p->fs, tilActions);
+		}
+		cache.add(key, p->fs.get(), cacheLimit, p->h);
 	}
 	if (landmarks != nullptr)
-	p->hLand = landmarks->countUncheckedNodes();
+	p->hLand = landmarks->countUncheckedNodes(p->landmarkStatus);
 }
 
 // Evaluates the initial plan. Its heuristic value is stored in the plan (p->h)
@@ -36,8 +39,7 @@ void Evaluator::evaluateInitialPlan(std::shared_ptr<Plan> p)
 	int numActions = (int)task->actions.size(), limit = 100;
 	//usefulActions = new bool[numActions];
 	//for (int i = 0; i < numActions; i++) usefulActions[i] = false;
-	NumericRPG rpg(p->fs, tilActions, task, limit);
-	p->h = rpg.evaluateInitialPlan(/*usefulActions*/);
+	p->h = numericRPG.evaluateInitialPlan(p->fs, tilActions, limit);
 }
 
 bool Evaluator::informativeLandmarks()
@@ -45,12 +47,36 @@ bool Evaluator::informativeLandmarks()
 	return landmarks != nullptr && landmarks->getNumInformativeNodes() > 0;
 }
 
+// Checks if the landmarks status of a plan can be derived from the status of its parent plan. This
+// is possible if the previous steps have not been rescheduled and the new step is placed after all of
+// them, so the time points of the parent plan are replayed in the same order
+bool Evaluator::incrementalLandmarks(std::shared_ptr<Plan> currentPlan)
+{
+	std::shared_ptr<Plan> parent = currentPlan->parentPlan.lock();
+	if (parent == nullptr || parent->landmarkStatus.empty() || currentPlan->planUpdates != nullptr)
+		return false;
+	unsigned int last = planComponents.size() - 1;
+	if (planComponents.get(last) != currentPlan)
+		return false;
+	TTime start = currentPlan->startPoint.updatedTime;
+	if (currentPlan->endPoint.updatedTime <= start)
+		return false;
+	for (unsigned int i = 1; i < last; i++) {
+		std::shared_ptr<Plan> p = planComponents.get(i);
+		if (p->startPoint.updatedTime >= start || p->endPoint.updatedTime >= start)
+			return false;
+	}
+	return true;
+}
+
 // Calculates the frontier state of a given plan. It also computes the number of useful actions included in the plan
 void Evaluator::calculateFrontierState(std::shared_ptr<TState> fs, std::shared_ptr<Plan> currentPlan)
 {
+	bool incremental = false;
 	if (landmarks != nullptr) {
-		landmarks->uncheckNodes();
-		landmarks->copyRootNodes(&openNodes);
+		incremental = incrementalLandmarks(currentPlan);
+		if (incremental) currentPlan->landmarkStatus = currentPlan->parentPlan.lock()->landmarkStatus;
+		else landmarks->initialStatus(currentPlan->landmarkStatus);
 	}
 	std::unordered_set<int> visitedActions;
 	pq.clear();
@@ -68,50 +94,44 @@ void Evaluator::calculateFrontierState(std::shared_ptr<TState> fs, std::shared_p
 			}
 		}
 	}
-	std::shared_ptr<LandmarkCheck> l, al;
 	while (pq.size() > 0) {
 		std::shared_ptr<ScheduledPoint> p = std::dynamic_pointer_cast<ScheduledPoint>(pq.poll());
 		std::shared_ptr<SASAction> a = p->plan->action;
 		bool atStart = (p->p & 1) == 0;
-		std::vector<SASCondition>* eff = atStart ? &a->startEff : &a->endEff;
+		std::vector<SASCondition>* eff;
     std::shared_ptr<std::vector<TFluentInterval>> numEff = atStart ? p->plan->startPoint.numVarValues : p->plan->endPoint.numVarValues;
-		for (SASCondition& c : *eff) {
-			fs->state[c.var] = c.value;
+		changes.clear();
+		if (a->isTIL) {		// TILs are not in the action table
+			eff = atStart ? &a->startEff : &a->endEff;
+			for (SASCondition& c : *eff) {
+				changes.push_back(SASTask::getVariableValueCode(c.var, c.value));
+			}
+		}
+		else {
+			unsigned int index = task->actionTable->getIndex(*a);
+			span<const TVarValue> tableEff = atStart ? task->actionTable->getStartEffects(index) : task->actionTable->getEndEffects(index);
+			changes.insert(changes.end(), tableEff.begin(), tableEff.end());
 		}
 		if (p->plan->holdCondEff != nullptr) {
 			for (int numCondEff : *p->plan->holdCondEff) {
 				SASConditionalEffect& ce = a->conditionalEff[numCondEff];
 				eff = atStart ? &ce.startEff: &ce.endEff;
 				for (SASCondition &c : *eff) {
-					fs->state[c.var] = c.value;
+					changes.push_back(SASTask::getVariableValueCode(c.var, c.value));
 				}
 			}
 		}
+		for (TVarValue e : changes) {
+			fs->state[SASTask::getVariableIndex(e)] = SASTask::getValueIndex(e);
+		}
 		if (numEff != nullptr) {
 			for (TFluentInterval& f : *numEff) {
 				fs->minState[f.numVar] = f.interval.minValue;
 				fs->maxState[f.numVar] = f.interval.maxValue;
 			}
 		}
-		if (landmarks != nullptr) {
-			int j = 0;
-			while (j < openNodes.size()) {
-				l = openNodes[j];
-				//cout << "Landmark " << l->toString(task, false) << endl;
-				if (l->goOn(fs)) {	// The landmark holds in the state and we can progress
-					l->check();
-					openNodes.erase(openNodes.begin() + j); // Remove node from the open nodes list
-					for (unsigned int k = 0; k < l->numNext(); k++) { // Go to the adjacent nodes
-						al = l->getNext(k);
-						if (!al->isChecked() && !findOpenNode(al)) {
-							openNodes.push_back(al); // Non-visited node -> append to open nodes
-						}
-					}
-				}
-				else {
-					j++;
-				}
-			}
+		if (landmarks != nullptr && (!incremental || p->plan == currentPlan)) {
+			landmarks->progress(currentPlan->landmarkStatus, fs.get(), changes);
 		}
 	}
 	/*
@@ -121,14 +141,6 @@ void Evaluator::calculateFrontierState(std::shared_ptr<TState> fs, std::shared_p
 	*/
 }
 
-bool Evaluator::findOpenNode(std::shared_ptr<LandmarkCheck> l)
-{
-	for (unsigned int i = 0; i < openNodes.size(); i++) {
-		if (openNodes[i] == l) return true;
-	}
-	return false;
-}
-
 Evaluator::Evaluator()
 {
 }
@@ -142,6 +154,9 @@ Evaluator::~Evaluator()
 // Evaluator initialization
 void Evaluator::initialize(std::shared_ptr<TState> state, std::shared_ptr<SASTask> task, std::vector<std::shared_ptr<SASAction>>* a, bool forceAtEndConditions) {
     this->task = task;
+	numericRPG.initialize(task);
+	ffRPG.initialize(task);
+	cache.initialize((unsigned int)task->variables.size(), (unsigned int)task->numVariables.size());
 	numericConditionsOrConditionalEffects = false;
 	for (std::shared_ptr<SASAction> a : task->actions) {
 		if (a->startNumCond.size() > 0 || a->overNumCond.size() > 0 || a->endNumCond.size() > 0) {
@@ -20,6 +20,9 @@
 #include "../planner/linearizer.h"
 #include "../planner/planComponents.h"
 #include "hLand.h"
+#include "numericRPG.h"
+#include "hFF.h"
+#include "heuristicCache.h"
 #include <memory>
 
 // Entry of a priority queue to sort the plan timepoints
@@ -49,13 +52,16 @@ private:
 	std::vector<std::shared_ptr<SASAction>>* tilActions;
 	PlanComponents planComponents;
 	PriorityQueue pq;
+	NumericRPG numericRPG;
+	FF_RPG ffRPG;
+	HeuristicCache cache;
 	//bool* usefulActions;
   std::unique_ptr<LandmarkHeuristic> landmarks;
-	std::vector<std::shared_ptr<LandmarkCheck>> openNodes;				// For hLand calculation
+	std::vector<TVarValue> changes;					// Fluents changed by a time point, for hLand calculation
 	bool numericConditionsOrConditionalEffects;
 
 	void calculateFrontierState(std::shared_ptr<TState> fs, std::shared_ptr<Plan> currentPlan);
-	bool findOpenNode(std::shared_ptr<LandmarkCheck> l);
+	bool incrementalLandmarks(std::shared_ptr<Plan> currentPlan);
 
 public:
 	Evaluator();
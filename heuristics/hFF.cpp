@@ -12,36 +12,137 @@ using namespace std;
 
 #define PENALTY 8
 
-FF_RPGVarValue::FF_RPGVarValue(TVariable var, TValue value) {
-	this->var = var;
-	this->value = value;
+FF_RPG::FF_RPG() {
+	task = nullptr;
+	epoch = 0;
+	numLevels = 0;
 }
 
-FF_RPG::FF_RPG(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, std::shared_ptr<SASTask> task) {
+// Builds the flat arrays of the task actions. An action is executable when all its start
+// and over conditions are reached, so its counter starts at the number of different
+// conditions. Actions without start and over conditions are executable as soon as any
+// of their other conditions is reached, as they only appear in the requirers of those
+void FF_RPG::initialize(std::shared_ptr<SASTask> task) {
 	this->task = task;
-	initialize();
+	unsigned int numActions = (unsigned int)task->actions.size();
+	unsigned int numVarValues = task->numVarValues;
+	varValueVar.resize(numVarValues);
+	varValueValue.resize(numVarValues);
+	for (TVariable v = 0; v < task->variables.size(); v++) {
+		unsigned int end = v + 1u < task->variables.size() ? task->varValueOffset[v + 1] : numVarValues;
+		for (unsigned int vv = task->varValueOffset[v]; vv < end; vv++) {
+			varValueVar[vv] = v;
+			varValueValue[vv] = task->varMinValue[v] + vv - task->varValueOffset[v];
+		}
+	}
+	precStart.clear();
+	prec.clear();
+	effStart.clear();
+	eff.clear();
+	numTriggers.assign(numActions, 0);
+	std::vector<std::vector<unsigned int>> actionTriggers(numVarValues);
+	const SASActionTable& table = *task->actionTable;
+	for (unsigned int i = 0; i < numActions; i++) {
+		precStart.push_back((unsigned int)prec.size());
+		for (TVarValue c : table.getStartOverConditions(i))
+			prec.push_back(task->getVarValueIndex(SASTask::getVariableIndex(c), SASTask::getValueIndex(c)));
+		effStart.push_back((unsigned int)eff.size());
+		for (TVarValue e : table.getAllEffects(i))
+			eff.push_back(task->getVarValueIndex(SASTask::getVariableIndex(e), SASTask::getValueIndex(e)));
+		addTriggers(task->actions[i], actionTriggers);
+	}
+	precStart.push_back((unsigned int)prec.size());
+	effStart.push_back((unsigned int)eff.size());
+	triggerStart.resize(numVarValues + 1);
+	trigger.clear();
+	for (unsigned int vv = 0; vv < numVarValues; vv++) {
+		triggerStart[vv] = (unsigned int)trigger.size();
+		trigger.insert(trigger.end(), actionTriggers[vv].begin(), actionTriggers[vv].end());
+	}
+	triggerStart[numVarValues] = (unsigned int)trigger.size();
+	goals.clear();
+	for (TVarValue g : *task->getListOfGoals())
+		goals.push_back(task->getVarValueIndex(SASTask::getVariableIndex(g), SASTask::getValueIndex(g)));
+	literalLevels.assign(numVarValues, MAX_INT32);
+	literalStamp.assign(numVarValues, 0);
+	actionLevels.assign(numActions, MAX_INT32);
+	actionCounter.assign(numActions, 0);
+	actionStamp.assign(numActions, 0);
+	inNewLevel.assign((numVarValues >> 6) + 1, 0);
+	epoch = 0;
+}
+
+// Adds the triggers of an action
+void FF_RPG::addTriggers(std::shared_ptr<SASAction> a, std::vector<std::vector<unsigned int>>& actionTriggers) {
+	unsigned int index = a->index;
+	if (!a->startCond.empty() || !a->overCond.empty()) {
+		for (SASCondition& c : a->startCond)
+			addTrigger(index, c, actionTriggers);
+		for (SASCondition& c : a->overCond)
+			addTrigger(index, c, actionTriggers);
+	}
+	else {
+		for (SASCondition& c : a->endCond)
+			addTrigger(index, c, actionTriggers);
+		for (SASConditionalEffect& e : a->conditionalEff) {
+			for (SASCondition& c : e.startCond)
+				addTrigger(index, c, actionTriggers);
+			for (SASCondition& c : e.endCond)
+				addTrigger(index, c, actionTriggers);
+		}
+		if (numTriggers[index] > 0)
+			numTriggers[index] = 1;		// Any of them makes the action executable
+	}
+}
+
+// Adds a trigger of an action, checking for no duplicates
+void FF_RPG::addTrigger(unsigned int a, SASCondition& c, std::vector<std::vector<unsigned int>>& actionTriggers) {
+	std::vector<unsigned int>& t = actionTriggers[task->getVarValueIndex(c.var, c.value)];
+	if (t.empty() || t.back() != a) {
+		t.push_back(a);
+		numTriggers[a]++;
+	}
+}
+
+// Clears the data of the previous evaluation
+void FF_RPG::reset() {
+	if (++epoch == 0) {	// Stamps overflow
+		std::fill(literalStamp.begin(), literalStamp.end(), 0);
+		std::fill(actionStamp.begin(), actionStamp.end(), 0);
+		epoch = 1;
+	}
+	lastLevel.clear();
+	newLevel.clear();
+	openConditions.clear();
+}
+
+// Builds the graph from the given frontier state and computes the heuristic value
+uint16_t FF_RPG::evaluate(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions) {
+	reset();
 	//cout << "STATE:" << endl;
 	for (unsigned int i = 0; i < fs->numSASVars; i++) {
-		TValue v = fs->state[i];
-		lastLevel->emplace_back(i, v);
-		literalLevels[i][v] = 0;
-		//cout << "(" << task->variables[i].name << ", " << task->values[v].name << ") -> Level 0" << endl;
+		unsigned int vv = task->getVarValueIndex(i, fs->state[i]);
+		lastLevel.push_back(vv);
+		setLiteralLevel(vv, 0);
+		//cout << "(" << task->variables[i].name << ", " << task->values[fs->state[i]].name << ") -> Level 0" << endl;
 	}
 	if (tilActions != nullptr) {
 		addTILactions(tilActions);
 	}
 	expand();
+	for (unsigned int g : goals)
+		addSubgoal(g);
+	return computeHeuristic();
 }
 
 void FF_RPG::addTILactions(std::vector<std::shared_ptr<SASAction>>* tilActions) {
 	for (unsigned int i = 0; i < tilActions->size(); i++) {
 		std::shared_ptr<SASAction> a = tilActions->at(i);
 		for (unsigned int j = 0; j < a->endEff.size(); j++) {
-			TVariable v = a->endEff[j].var;
-			TValue value = a->endEff[j].value;
-			if (literalLevels[v][value] != 0) {
-				lastLevel->emplace_back(v, value);
-				literalLevels[v][value] = 0;
+			unsigned int vv = task->getVarValueIndex(a->endEff[j].var, a->endEff[j].value);
+			if (getLiteralLevel(vv) != 0) {
+				lastLevel.push_back(vv);
+				setLiteralLevel(vv, 0);
 			}
 		}
 	}
@@ -49,143 +150,101 @@ void FF_RPG::addTILactions(std::vector<std::shared_ptr<SASAction>>* tilActions)
 
 void FF_RPG::expand() {
 	numLevels = 0;
-	while (lastLevel->size() > 0) {
-		newLevel->clear();
-		for (unsigned int i = 0; i < lastLevel->size(); i++) {
-			TVariable var = (*lastLevel)[i].var;
-			TValue value = (*lastLevel)[i].value;
+	while (lastLevel.size() > 0) {
+		newLevel.clear();
+		for (unsigned int vv : lastLevel) {
 #ifdef DEBUG_RPG_ON
-			cout << "(" << task->variables[var].name << "," << task->values[value].name << ")" << endl;
+			cout << "(" << task->variables[varValueVar[vv]].name << "," << task->values[varValueValue[vv]].name << ")" << endl;
 #endif
-			vector<std::shared_ptr<SASAction>> &actions = task->requirers[var][value];
-#ifdef DEBUG_RPG_ON
-			cout << actions.size() << " actions" << endl;
-#endif
-			for (unsigned int j = 0; j < actions.size(); j++) {
-				std::shared_ptr<SASAction> a = actions[j];
-				if (actionLevels[a->index] == MAX_INT32 && isExecutable(a)) {
+			for (unsigned int i = triggerStart[vv]; i < triggerStart[vv + 1]; i++) {
+				unsigned int a = trigger[i];
+				if (actionStamp[a] != epoch) {
+					actionStamp[a] = epoch;
+					actionLevels[a] = MAX_INT32;
+					actionCounter[a] = numTriggers[a];
+				}
+				if (--actionCounter[a] == 0 && actionLevels[a] == MAX_INT32) {
 #ifdef DEBUG_RPG_ON
-					cout << "[" << numLevels << "] " << a->name << endl;
+					cout << "[" << numLevels << "] " << task->actions[a]->name << endl;
 #endif
-					actionLevels[a->index] = numLevels;
+					actionLevels[a] = numLevels;
 					addEffects(a);
 				}
 			}
 		}
 		if (numLevels == 0) {
 			for (unsigned int j = 0; j < task->actionsWithoutConditions.size(); j++) {
-				std::shared_ptr<SASAction> a = task->actionsWithoutConditions[j];
-				actionLevels[a->index] = numLevels;
+				unsigned int a = task->actionsWithoutConditions[j]->index;
+				if (actionStamp[a] != epoch) {
+					actionStamp[a] = epoch;
+					actionCounter[a] = numTriggers[a];
+				}
+				actionLevels[a] = numLevels;
 				addEffects(a);
 			}
 		}
 		numLevels++;
-		for (unsigned int i = 0; i < newLevel->size(); i++) {
-			literalLevels[(*newLevel)[i].var][(*newLevel)[i].value] = numLevels;
+		for (unsigned int vv : newLevel) {
+			setLiteralLevel(vv, numLevels);
+			inNewLevel[vv >> 6] &= ~(1ULL << (vv & 63));
 		}
-    std::unique_ptr<std::vector<FF_RPGVarValue>> aux = std::move(lastLevel);
-		lastLevel = std::move(newLevel);
-		newLevel = std::move(aux);
+		lastLevel.swap(newLevel);
 	}
 #ifdef DEBUG_RPG_ON
 	cout << "There are " << numLevels << " levels" << endl;
 #endif
 }
 
-bool FF_RPG::isExecutable(std::shared_ptr<SASAction> a) {
-	for (unsigned int i = 0; i < a->startCond.size(); i++) {
-		if (literalLevels[a->startCond[i].var][a->startCond[i].value] == MAX_INT32)
-			return false;
-	}
-	for (unsigned int i = 0; i < a->overCond.size(); i++) {
-		if (literalLevels[a->overCond[i].var][a->overCond[i].value] == MAX_INT32)
-			return false;
-	}
-	/*
-	if (forceAtEndConditions) {
-		for (unsigned int i = 0; i < a->endCond.size(); i++) {
-			if (literalLevels[a->endCond[i].var][a->endCond[i].value] == MAX_INT32)
-				return false;
-		}
-	}*/
-	return true;
-}
-
-void FF_RPG::addEffects(std::shared_ptr<SASAction> a) {
-	for (unsigned int i = 0; i < a->startEff.size(); i++) {
-		addEffect(a->startEff[i].var, a->startEff[i].value);
-	}
-	for (unsigned int i = 0; i < a->endEff.size(); i++) {
-		addEffect(a->endEff[i].var, a->endEff[i].value);
+void FF_RPG::addEffects(unsigned int a) {
+	for (unsigned int i = effStart[a]; i < effStart[a + 1]; i++) {
+		addEffect(eff[i]);
 	}
 }
 
-void FF_RPG::addEffect(TVariable var, TValue value) {
-	if (literalLevels[var][value] == MAX_INT32) {
-		for (unsigned int i = 0; i < newLevel->size(); i++)
-			if ((*newLevel)[i].var == var && (*newLevel)[i].value == value)
-				return;
-		newLevel->emplace_back(var, value);
+void FF_RPG::addEffect(unsigned int vv) {
+	uint64_t bit = 1ULL << (vv & 63);
+	if (getLiteralLevel(vv) == MAX_INT32 && (inNewLevel[vv >> 6] & bit) == 0) {
+		inNewLevel[vv >> 6] |= bit;
+		newLevel.push_back(vv);
 #ifdef DEBUG_RPG_ON
-		cout << "* " << task->variables[var].name << " = " << task->values[value].name << endl;
+		cout << "* " << task->variables[varValueVar[vv]].name << " = " << task->values[varValueValue[vv]].name << endl;
 #endif
 	}
 }
 
-void FF_RPG::initialize() {
-	unsigned int numVars = task->variables.size();
-	literalLevels.resize(numVars);
-	for (unsigned int i = 0; i < numVars; i++) {
-		literalLevels[i].resize(task->values.size(), MAX_INT32);
-	}
-	actionLevels.resize(task->actions.size(), MAX_INT32);
-	lastLevel = std::make_unique<vector<FF_RPGVarValue>>();
-	newLevel = std::make_unique<vector<FF_RPGVarValue>>();
-}
-
-void FF_RPG::resetReachedValues() {
-	for (unsigned int i = 0; i < reachedValues.size(); i++) {
-		TVariable v = SASTask::getVariableIndex(reachedValues[i]);
-		TValue value = SASTask::getValueIndex(reachedValues[i]);
-		if (literalLevels[v][value] < 0)
-			literalLevels[v][value] = -literalLevels[v][value];
-	}
-	reachedValues.clear();
-}
-
-uint16_t FF_RPG::computeHeuristic(PriorityQueue* openConditions) {
+uint16_t FF_RPG::computeHeuristic() {
 	int gLevel;
 	uint16_t bestCost;
 	uint16_t h = 0;
-	while (openConditions->size() > 0) {
-    std::shared_ptr<FF_RPGCondition> g = std::dynamic_pointer_cast<FF_RPGCondition>(openConditions->poll());
-		//if (debug) cout << "Condition: " << task->variables[g->var].name << " = " << task->values[g->value].name << " (level " << literalLevels[g->var][g->value] << ")" << endl;
+	FF_RPGCondition g;
+	while (openConditions.size() > 0) {
+		openConditions.poll(g);
+		TVariable var = varValueVar[g.varValue];
+		TValue value = varValueValue[g.varValue];
 #ifdef DEBUG_RPG_ON
-		cout << "Condition: " << task->variables[g->var].name << " = " << task->values[g->value].name << " (level " << literalLevels[g->var][g->value] << ")" << endl;
+		cout << "Condition: " << task->variables[var].name << " = " << task->values[value].name << " (level " << getLiteralLevel(g.varValue) << ")" << endl;
 #endif
-		gLevel = literalLevels[g->var][g->value];
+		gLevel = getLiteralLevel(g.varValue);
 		if (gLevel <= 0) {
 			continue;
 		}
 		if (gLevel == MAX_INT32) return MAX_UINT16;
-		literalLevels[g->var][g->value] = -gLevel;
-		reachedValues.push_back(SASTask::getVariableValueCode(g->var, g->value));
-		vector<std::shared_ptr<SASAction>> &prod = task->producers[g->var][g->value];
-		std::shared_ptr<SASAction> bestAction = nullptr;
+		setLiteralLevel(g.varValue, -gLevel);
+		int bestAction = -1;
 		bestCost = MAX_UINT16;
-		for (unsigned int i = 0; i < prod.size(); i++) {
-			std::shared_ptr<SASAction> a = prod[i];
+		for (uint32_t a : task->getProducers(var, value)) {
 #ifdef DEBUG_RPG_ON
-			cout << a->name << ", dif. " << getDifficulty(a) << endl;
-#endif			
-			if (gLevel == actionLevels[a->index] + 1) {
-				if (bestAction == nullptr) {
+			cout << task->actions[a]->name << ", dif. " << getDifficulty(a) << endl;
+#endif
+			int aLevel = getActionLevel(a);
+			if (aLevel != MAX_INT32 && gLevel == aLevel + 1) {
+				if (bestAction == -1) {
 					bestAction = a;
-					bestCost = /*mutex ? getDifficultyWithPermanentMutex(a) :*/ getDifficulty(a);
+					bestCost = getDifficulty(a);
 					if (bestCost == 0) break;
 				}
 				else {
-					uint16_t cost = /*mutex ? getDifficultyWithPermanentMutex(a) :*/ getDifficulty(a);
+					uint16_t cost = getDifficulty(a);
 					if (cost < bestCost) {
 						bestAction = a;
 						bestCost = cost;
@@ -196,13 +255,12 @@ uint16_t FF_RPG::computeHeuristic(PriorityQueue* openConditions) {
 				}
 			}
 		}
-		if (bestAction != nullptr) {
-			//if (debug) cout << bestAction->name << endl;
+		if (bestAction != -1) {
 #ifdef DEBUG_RPG_ON
-			cout << "* Best action = " << bestAction->name << ", cost " << bestCost << endl;
+			cout << "* Best action = " << task->actions[bestAction]->name << ", cost " << bestCost << endl;
 #endif
 			h++;
-			addSubgoals(bestAction, openConditions);
+			addSubgoals(bestAction);
 		}
 		else {
 #ifdef DEBUG_RPG_ON
@@ -217,77 +275,29 @@ uint16_t FF_RPG::computeHeuristic(PriorityQueue* openConditions) {
 	return h;
 }
 
-uint16_t FF_RPG::evaluate() {
-	resetReachedValues();
-	PriorityQueue openConditions(128);
-	addSubgoals(task->getListOfGoals(), &openConditions);
-	return computeHeuristic(&openConditions);
-}
-
-void FF_RPG::addSubgoals(std::vector<TVarValue>* goals, PriorityQueue* openConditions) {
-	TVariable var;
-	TValue value;
-	for (unsigned int i = 0; i < goals->size(); i++) {
-		var = SASTask::getVariableIndex(goals->at(i));
-		value = SASTask::getValueIndex(goals->at(i));
-		addSubgoal(var, value, openConditions);
-	}
-}
-
-void FF_RPG::addSubgoal(TVariable var, TValue value, PriorityQueue* openConditions) {
-	int level = literalLevels[var][value];
+void FF_RPG::addSubgoal(unsigned int vv) {
+	int level = getLiteralLevel(vv);
 	if (level > 0) {
-		openConditions->add(std::make_shared<FF_RPGCondition>(var, value, level));
+		openConditions.add(FF_RPGCondition(vv, level));
 #ifdef DEBUG_RPG_ON
-		cout << "* Adding subgoal: " << task->variables[var].name << " = " << task->values[value].name << " (level " << level << ")" << endl;
+		cout << "* Adding subgoal: " << task->variables[varValueVar[vv]].name << " = " << task->values[varValueValue[vv]].name << " (level " << level << ")" << endl;
 #endif
 	}
 }
 
-void FF_RPG::addSubgoals(std::shared_ptr<SASAction> a, PriorityQueue* openConditions) {
-	TVariable var;
-	TValue value;
-	// Add the conditions of the action that do not hold in the frontier state as subgoals 
-	for (unsigned int i = 0; i < a->startCond.size(); i++) {
-		var = a->startCond[i].var;
-		value = a->startCond[i].value;
-		addSubgoal(var, value, openConditions);
-	}
-	for (unsigned int i = 0; i < a->overCond.size(); i++) {
-		var = a->overCond[i].var;
-		value = a->overCond[i].value;
-		addSubgoal(var, value, openConditions);
+// Add the start and over conditions of the action that do not hold in the frontier state as subgoals
+void FF_RPG::addSubgoals(unsigned int a) {
+	for (unsigned int i = precStart[a]; i < precStart[a + 1]; i++) {
+		addSubgoal(prec[i]);
 	}
-	/*
-	if (forceAtEndConditions) {
-		for (unsigned int i = 0; i < a->endCond.size(); i++) {
-			var = a->endCond[i].var;
-			value = a->endCond[i].value;
-			addSubgoal(var, value, openConditions);
-		}
-	}*/
 }
 
-uint16_t FF_RPG::getDifficulty(std::shared_ptr<SASAction> a) {
+uint16_t FF_RPG::getDifficulty(unsigned int a) {
 	uint16_t cost = 0;
-	for (unsigned int i = 0; i < a->startCond.size(); i++) {
-		cost += getDifficulty(&(a->startCond[i]));
-	}
-	for (unsigned int i = 0; i < a->overCond.size(); i++) {
-		cost += getDifficulty(&(a->overCond[i])); 
+	for (unsigned int i = precStart[a]; i < precStart[a + 1]; i++) {
+		int level = getLiteralLevel(prec[i]);
+		if (level > 0) cost += level;
 	}
-	/*
-	if (forceAtEndConditions) {
-		for (unsigned int i = 0; i < a->endCond.size(); i++) {
-			cost += getDifficulty(&(a->endCond[i]));
-		}
-	}*/
 	//cout << " * Difficulty: " << cost << endl;
 	return cost;
 }
-
-uint16_t FF_RPG::getDifficulty(SASCondition* c) {
-	int level = literalLevels[c->var][c->value];
-	//cout << " * Dif. of (" << task->variables[c->var].name << ", " << task->values[c->value].name << "): " << level << endl;
-	return level > 0 ? level : 0;
-}
@@ -8,58 +8,74 @@
 
 #include <memory>
 
-class FF_RPGCondition : public PriorityQueueItem {
+// Open condition of the relaxed plan: pair (variable, value) given by its index in the flat arrays
+class FF_RPGCondition {
 public:
-	TVariable var;
-	TValue value;
+	unsigned int varValue;
 	int level;
-	FF_RPGCondition(TVariable v, TValue val, int l) {
-		var = v;
-		value = val;
+	FF_RPGCondition() { }
+	FF_RPGCondition(unsigned int vv, int l) {
+		varValue = vv;
 		level = l;
 	}
-	inline int compare(std::shared_ptr<PriorityQueueItem> other) {
-		return std::dynamic_pointer_cast<FF_RPGCondition>(other)->level - level;
+	inline int compare(const FF_RPGCondition& other) const {
+		return other.level - level;
 	}
-	virtual ~FF_RPGCondition() { }
-};
-
-class FF_RPGVarValue {
-public:
-	TVariable var;
-	TValue value;
-	FF_RPGVarValue(TVariable var, TValue value);
 };
 
+// Non-temporal relaxed planning graph. The action data is stored in flat CSR arrays of
+// (variable, value) indexes, built once for the task, and the graph is reused in every evaluation
 class FF_RPG {
 private:
 	std::shared_ptr<SASTask> task;
-	std::vector< std::vector<int> > literalLevels;
-    std::vector<int> actionLevels;
-    unsigned int numLevels;
-    std::unique_ptr<std::vector<FF_RPGVarValue>> lastLevel;
-    std::unique_ptr<std::vector<FF_RPGVarValue>> newLevel;
-    std::vector<TVarValue> reachedValues;
-    
-    void initialize();
-    void addEffects(std::shared_ptr<SASAction> a);
-    void addEffect(TVariable var, TValue value);
+	unsigned int epoch;							// Current evaluation
+	std::vector<unsigned int> precStart;		// For each action, position of its first start/over condition in prec
+	std::vector<unsigned int> prec;				// Start and over conditions of the actions
+	std::vector<unsigned int> effStart;			// For each action, position of its first start/end effect in eff
+	std::vector<unsigned int> eff;				// Start and end effects of the actions
+	std::vector<unsigned int> triggerStart;		// For each (variable, value), position of its first action in trigger
+	std::vector<unsigned int> trigger;			// Actions whose counter decreases when a (variable, value) is reached
+	std::vector<int> numTriggers;				// For each action, number of triggers needed to execute it
+	std::vector<TVariable> varValueVar;			// Variable of each (variable, value)
+	std::vector<TValue> varValueValue;			// Value of each (variable, value)
+	std::vector<unsigned int> goals;
+	std::vector<int> literalLevels;
+	std::vector<unsigned int> literalStamp;
+	std::vector<int> actionLevels;
+	std::vector<int> actionCounter;				// Remaining triggers of each action
+	std::vector<unsigned int> actionStamp;
+	std::vector<uint64_t> inNewLevel;			// Bitset of the (variable, value) pairs in newLevel
+	std::vector<unsigned int> lastLevel;
+	std::vector<unsigned int> newLevel;
+	ValuePriorityQueue<FF_RPGCondition> openConditions;
+	unsigned int numLevels;
+
+	inline int getLiteralLevel(unsigned int vv) {
+		return literalStamp[vv] == epoch ? literalLevels[vv] : MAX_INT32;
+	}
+	inline void setLiteralLevel(unsigned int vv, int level) {
+		literalStamp[vv] = epoch;
+		literalLevels[vv] = level;
+	}
+	inline int getActionLevel(unsigned int a) {
+		return actionStamp[a] == epoch ? actionLevels[a] : MAX_INT32;
+	}
+	void addTriggers(std::shared_ptr<SASAction> a, std::vector<std::vector<unsigned int>>& actionTriggers);
+	void addTrigger(unsigned int a, SASCondition& c, std::vector<std::vector<unsigned int>>& actionTriggers);
+	void reset();
+	void addEffects(unsigned int a);
+	void addEffect(unsigned int vv);
 	void expand();
-	void addSubgoals(std::vector<TVarValue>* goals, PriorityQueue* openConditions);
-	void addSubgoal(TVariable var, TValue value, PriorityQueue* openConditions);
-	void addSubgoals(std::shared_ptr<SASAction> a, PriorityQueue* openConditions);
-	uint16_t getDifficulty(std::shared_ptr<SASAction> a);
-	uint16_t getDifficulty(SASCondition* c);
+	void addSubgoal(unsigned int vv);
+	void addSubgoals(unsigned int a);
+	uint16_t getDifficulty(unsigned int a);
 	void addTILactions(std::vector<std::shared_ptr<SASAction>>* tilActions);
-	uint16_t computeHeuristic(PriorityQueue* openConditions);
-	void resetReachedValues();
-	bool isExecutable(std::shared_ptr<SASAction> a);
+	uint16_t computeHeuristic();
 
 public:
-	std::vector<std::shared_ptr<SASAction>> relaxedPlan;
-
-	FF_RPG(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, std::shared_ptr<SASTask> task);
-	uint16_t evaluate();
+	FF_RPG();
+	void initialize(std::shared_ptr<SASTask> task);
+	uint16_t evaluate(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions);
 };
 
 #endif
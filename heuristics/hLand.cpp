@@ -1,119 +1,17 @@
+#include <bit>
 #include "hLand.h"
 
 //#define DEBUG_HLAND_ON
 
 using namespace std;
 
-/*******************************************/
-/* LandmarkCheck                           */
-/*******************************************/
-
-LandmarkCheck::LandmarkCheck(LandmarkNode* n) {
-	unsigned int numFluents = n->getNumFluents();
-	single = numFluents == 1;
-	for (unsigned int i = 0; i < numFluents; i++) {
-		vars.push_back(n->getVariable(i));
-		values.push_back(n->getValue(i));
-	}
-	checked = false;
-}
-
-void LandmarkCheck::addNext(std::shared_ptr<LandmarkCheck> n) {
-	next.push_back(n);
-}
-
-void LandmarkCheck::addPrev(std::weak_ptr<LandmarkCheck> n) {
-	prev.push_back(n);
-}
-
-string LandmarkCheck::toString(std::shared_ptr<SASTask> task, bool showNext) {
-	std::string res = "(";
-	res += task->variables[getVar()].name + "=" + task->values[getValue()].name;
-	if (!single) {
-		for (unsigned int i = 1; i < vars.size(); i++) {
-			res += "," + task->variables[vars[i]].name + "=" + task->values[values[i]].name;
-		}
-	}
-	res += ")";
-	if (checked) res += " checked";
-	res += " Next: " + to_string(next.size());
-	if (showNext) {
-		for (unsigned int i = 0; i < next.size(); i++) {
-			res += "\n\t-> " + next[i]->toString(task, false);
-		}
-	}
-	return res;
-}
-
-void LandmarkCheck::removePredecessor(std::shared_ptr<LandmarkCheck> n) {
-	unsigned int i = 0;
-	while (i < prev.size()) {
-		if (prev[i].lock() == n) {
-			//cout << "  Deleted predecessor" << endl;
-			prev.erase(prev.begin() + i);
-		}
-		else {
-			i++;
-		}
-	}
-}
-
-void LandmarkCheck::removeSuccessor(std::shared_ptr<LandmarkCheck> n) {
-	unsigned int i = 0;
-	while (i < next.size()) {
-		if (next[i] == n) {
-			next.erase(next.begin() + i);
-		}
-		else {
-			i++;
-		}
-	}
-}
-
-bool LandmarkCheck::isGoal(std::shared_ptr<SASTask> task) {
-	if (vars.size() != 1) return false;
-	TVariable v = getVar();
-	TValue value = getValue();
-	for (unsigned int i = 0; i < task->goals.size(); i++) {
-		std::shared_ptr<SASAction> g = task->goals[i];
-		for (unsigned int j = 0; j < g->startCond.size(); j++)
-			if (v == g->startCond[j].var && value == g->startCond[j].value) return true;
-		for (unsigned int j = 0; j < g->overCond.size(); j++)
-			if (v == g->overCond[j].var && value == g->overCond[j].value) return true;
-		for (unsigned int j = 0; j < g->endCond.size(); j++)
-			if (v == g->endCond[j].var && value == g->endCond[j].value) return true;
-	}
-	return false;
-}
-
-bool LandmarkCheck::isInitialState(std::shared_ptr<TState> state) {
-	if (isSingle()) {
-		return state->state[getVar()] == getValue();
-	}
-	else {
-		for (unsigned int i = 0; i < vars.size(); i++) {
-			if (state->state[vars[i]] == values[i])
-				return true;
-		}
-		return false;
-	}
-}
-
-bool LandmarkCheck::goOn(std::shared_ptr<TState> s) {
-	for (unsigned int i = 0; i < vars.size(); i++) {
-		if (s->state[vars[i]] == values[i])
-			return true;
-	}
-	return false;
-}
-
-
 /*******************************************/
 /* LandmarkHeuristic                       */
 /*******************************************/
 
 LandmarkHeuristic::LandmarkHeuristic() {
 	this->task = nullptr;
+	numNodes = numWords = 0;
 }
 
 LandmarkHeuristic::~LandmarkHeuristic() {
@@ -125,140 +23,200 @@ void LandmarkHeuristic::initialize(std::shared_ptr<SASTask> task, std::vector<st
 	initialize(state, task, tilActions);
 }
 
+// Builds the landmark graph. The nodes that hold in the initial state are removed, and the root
+// nodes are the first ones that do not hold
 void LandmarkHeuristic::initialize(std::shared_ptr<TState> state, std::shared_ptr<SASTask> task, std::vector<std::shared_ptr<SASAction>>* tilActions) {
-	this->task = task; 
+	this->task = task;
   std::shared_ptr<Landmarks> landmarks = std::make_shared<Landmarks>(state, task, tilActions);
 	landmarks->filterTransitiveOrders(task);
 #ifdef DEBUG_HLAND_ON
 	cout << landmarks->toString(task) << endl;
 #endif
 	unsigned int numLandNodes = landmarks->numNodes();
-	//cout << ";" << numLandNodes << " landmarks" << endl;
+	std::vector<std::vector<TVarValue>> nodeFluents(numLandNodes);
+	std::vector<std::vector<uint32_t>> nextList(numLandNodes), prevList(numLandNodes);
 	for (unsigned int i = 0; i < numLandNodes; i++) {
-    std::shared_ptr<LandmarkCheck> l = std::make_shared<LandmarkCheck>(landmarks->getNode(i));
-		nodes.push_back(l);
+		LandmarkNode* ln = landmarks->getNode(i);
+		for (unsigned int j = 0; j < ln->getNumFluents(); j++)
+			nodeFluents[i].push_back(SASTask::getVariableValueCode(ln->getVariable(j), ln->getValue(j)));
 	}
 	for (unsigned int i = 0; i < numLandNodes; i++) {
 		LandmarkNode* ln = landmarks->getNode(i);
 		unsigned int numAdj = ln->numAdjacents();
 		for (unsigned int j = 0; j < numAdj; j++) {
 			int adjIndex = ln->getAdjacent(j)->getIndex();
-			nodes[ln->getIndex()]->addNext(nodes[adjIndex]);
-			nodes[adjIndex]->addPrev(nodes[ln->getIndex()]);
+			nextList[ln->getIndex()].push_back(adjIndex);
+			prevList[adjIndex].push_back(ln->getIndex());
 		}
 	}
-	std::vector<std::shared_ptr<LandmarkCheck>> toDelete;
+	std::vector<uint32_t> toDelete;
 	for (unsigned int i = 0; i < numLandNodes; i++) {
-		if (nodes[i]->numPrev() == 0) {
-			addRootNode(nodes[i], state, &toDelete);
+		if (prevList[i].empty()) {
+			addRootNode(i, state.get(), nodeFluents, nextList, toDelete);
 		}
 	}
-	for (unsigned int i = 0; i < toDelete.size(); i++) {
-		std::shared_ptr<LandmarkCheck> n = toDelete[i];
-		//cout << "Deleting node: " << n->toString(task, false) << endl;
-		for (unsigned int j = 0; j < n->numPrev(); j++)
-			n->getPrev(j).lock()->removeSuccessor(n);
-		for (unsigned int j = 0; j < n->numNext(); j++)
-			n->getNext(j)->removePredecessor(n);
-		for (unsigned int j = 0; j < nodes.size(); j++) {
-			if (nodes[j] == n) {
-				nodes.erase(nodes.begin() + j);
-				break;
-			}
-		}
+	std::vector<bool> deleted(numLandNodes, false);
+	for (uint32_t n : toDelete) {
+		for (uint32_t p : prevList[n])
+			nextList[p].erase(std::remove(nextList[p].begin(), nextList[p].end(), n), nextList[p].end());
+		for (uint32_t s : nextList[n])
+			prevList[s].erase(std::remove(prevList[s].begin(), prevList[s].end(), n), prevList[s].end());
+		deleted[n] = true;
 	}
 	unsigned int i = 0;
 	while (i < rootNodes.size()) {
-		//cout << rootNodes[i]->toString(task, false) << endl;
-		if (hasRootPredecessor(rootNodes[i])) {
+		if (hasRootPredecessor(rootNodes[i], prevList)) {
 			rootNodes.erase(rootNodes.begin() + i);
 		}
 		else {
 			i++;
 		}
 	}
-	/*
-	for (i = 0; i < rootNodes.size(); i++) {
-		cout << "Root node: " << rootNodes[i]->toString(task, false) << endl;
-	}*/
+	// Flat arrays, without the deleted nodes
+	std::vector<uint32_t> newIndex(numLandNodes);
+	numNodes = 0;
+	for (i = 0; i < numLandNodes; i++) {
+		if (!deleted[i]) newIndex[i] = numNodes++;
+	}
+	numWords = (numNodes + 63) >> 6;
+	std::vector<std::vector<uint32_t>> watchList(task->numVarValues);
+	for (i = 0; i < numLandNodes; i++) {
+		if (deleted[i]) continue;
+		fluentOffset.push_back((uint32_t)fluents.size());
+		for (TVarValue vv : nodeFluents[i]) {
+			fluents.push_back(vv);
+			watchList[task->getVarValueIndex(SASTask::getVariableIndex(vv), SASTask::getValueIndex(vv))].push_back(newIndex[i]);
+		}
+		nextOffset.push_back((uint32_t)next.size());
+		for (uint32_t s : nextList[i])
+			next.push_back(newIndex[s]);
+	}
+	fluentOffset.push_back((uint32_t)fluents.size());
+	nextOffset.push_back((uint32_t)next.size());
+	for (std::vector<uint32_t>& w : watchList) {
+		watchOffset.push_back((uint32_t)watch.size());
+		watch.insert(watch.end(), w.begin(), w.end());
+	}
+	watchOffset.push_back((uint32_t)watch.size());
+	for (uint32_t& r : rootNodes)
+		r = newIndex[r];
 }
 
-bool LandmarkHeuristic::hasRootPredecessor(std::shared_ptr<LandmarkCheck> n) {
-	for (unsigned int i = 0; i < n->numPrev(); i++) {
-		std::shared_ptr<LandmarkCheck> p = n->getPrev(i).lock();
-		bool found = false;
-		for (unsigned int j = 0; j < rootNodes.size(); j++) {
-			if (rootNodes[j] == p) {
-				found = true;
-				break;
-			}
-		}
-		if (found) return true;
-		if (hasRootPredecessor(p)) return true;
+bool LandmarkHeuristic::hasRootPredecessor(uint32_t n, std::vector<std::vector<uint32_t>>& prevList) {
+	for (uint32_t p : prevList[n]) {
+		if (std::find(rootNodes.begin(), rootNodes.end(), p) != rootNodes.end()) return true;
+		if (hasRootPredecessor(p, prevList)) return true;
 	}
 	return false;
 }
 
-void LandmarkHeuristic::addRootNode(std::shared_ptr<LandmarkCheck> n, std::shared_ptr<TState> state, std::vector<std::shared_ptr<LandmarkCheck>>* toDelete) {
-	bool found = false;
-	if (n->goOn(state)) {
-		for (unsigned int i = 0; i < toDelete->size(); i++) {
-			if (toDelete->at(i) == n) {
-				found = true;
-				break;
-			}
-		}
-		if (!found) toDelete->push_back(n);
-		for (unsigned int i = 0; i < n->numNext(); i++) {
-			addRootNode(n->getNext(i), state, toDelete);
+void LandmarkHeuristic::addRootNode(uint32_t n, TState* state, std::vector<std::vector<TVarValue>>& nodeFluents,
+	std::vector<std::vector<uint32_t>>& nextList, std::vector<uint32_t>& toDelete) {
+	if (goOn(nodeFluents[n], state)) {
+		if (std::find(toDelete.begin(), toDelete.end(), n) == toDelete.end()) toDelete.push_back(n);
+		for (uint32_t s : nextList[n]) {
+			addRootNode(s, state, nodeFluents, nextList, toDelete);
 		}
 	} else {
-		for (unsigned int i = 0; i < rootNodes.size(); i++) {
-			if (rootNodes[i] == n) {
-				found = true;
-				break;
-			}
-		}
-		if (!found) rootNodes.push_back(n);
+		if (std::find(rootNodes.begin(), rootNodes.end(), n) == rootNodes.end()) rootNodes.push_back(n);
+	}
+}
+
+// Checks if any of the fluents of a node holds in the state
+bool LandmarkHeuristic::goOn(std::vector<TVarValue>& nodeFluents, TState* s) {
+	for (TVarValue vv : nodeFluents) {
+		if (s->state[SASTask::getVariableIndex(vv)] == SASTask::getValueIndex(vv))
+			return true;
 	}
+	return false;
 }
 
-void LandmarkHeuristic::uncheckNodes() {
-	for (unsigned int i = 0; i < nodes.size(); i++) {
-		//cout << nodes[i]->toString(task, false) << " unchecked" << endl;
-		nodes[i]->uncheck();
+bool LandmarkHeuristic::goOn(uint32_t n, TState* s) {
+	for (uint32_t i = fluentOffset[n]; i < fluentOffset[n + 1]; i++) {
+		if (s->state[SASTask::getVariableIndex(fluents[i])] == SASTask::getValueIndex(fluents[i]))
+			return true;
 	}
+	return false;
 }
 
-uint16_t LandmarkHeuristic::evaluate() {
-	uint16_t h = 0;
-	for (unsigned int i = 0; i < nodes.size(); i++) {
-		if (!nodes[i]->isChecked())
-			h++;
+// Status of the landmarks before executing any action: no checked nodes, and the root nodes are open
+void LandmarkHeuristic::initialStatus(std::vector<uint64_t>& status) {
+	status.assign(2 * numWords, 0);
+	for (uint32_t r : rootNodes)
+		status[numWords + (r >> 6)] |= 1ULL << (r & 63);
+}
+
+// Updates the status after a time point, given the (variable, value) pairs changed by its effects and
+// the resulting state. Only the open nodes that contain the changed pairs are checked, along with the
+// nodes that become open in this progression. The root nodes do not hold in the initial state, so an
+// open node can only become true through a change in one of its fluents
+void LandmarkHeuristic::progress(std::vector<uint64_t>& status, TState* s, std::vector<TVarValue>& changes) {
+	pending.clear();
+	for (TVarValue vv : changes) {
+		unsigned int index = task->getVarValueIndex(SASTask::getVariableIndex(vv), SASTask::getValueIndex(vv));
+		for (uint32_t i = watchOffset[index]; i < watchOffset[index + 1]; i++) {
+			if (isOpen(status, watch[i]))
+				pending.push_back(watch[i]);
+		}
+	}
+	while (!pending.empty()) {
+		uint32_t n = pending.back();
+		pending.pop_back();
+		if (!isOpen(status, n) || !goOn(n, s))
+			continue;
+		status[n >> 6] |= 1ULL << (n & 63);					// Checked
+		status[numWords + (n >> 6)] &= ~(1ULL << (n & 63));	// Not open
+		for (uint32_t i = nextOffset[n]; i < nextOffset[n + 1]; i++) {
+			uint32_t succ = next[i];
+			if (!isChecked(status, succ) && !isOpen(status, succ)) {
+				status[numWords + (succ >> 6)] |= 1ULL << (succ & 63);
+				pending.push_back(succ);
+			}
+		}
 	}
-	return h;
 }
 
-void LandmarkHeuristic::copyRootNodes(std::vector<std::shared_ptr<LandmarkCheck>>* v) {
-	v->clear();
-	v->insert(v->end(), rootNodes.begin(), rootNodes.end());
+uint16_t LandmarkHeuristic::countUncheckedNodes(std::vector<uint64_t>& status) {
+	unsigned int checked = 0;
+	for (unsigned int i = 0; i < numWords; i++)
+		checked += std::popcount(status[i]);
+	return (uint16_t)(numNodes - checked);
 }
 
 std::string LandmarkHeuristic::toString(std::shared_ptr<SASTask> task) {
 	std::string res = "LANDMARKS:\n";
-	for (unsigned int i = 0; i < nodes.size(); i++) {
-		res += "* " + nodes[i]->toString(task, true) + "\n";
+	for (uint32_t n = 0; n < numNodes; n++) {
+		res += "* (";
+		for (uint32_t i = fluentOffset[n]; i < fluentOffset[n + 1]; i++) {
+			if (i > fluentOffset[n]) res += ",";
+			res += task->variables[SASTask::getVariableIndex(fluents[i])].name + "=" + task->values[SASTask::getValueIndex(fluents[i])].name;
+		}
+		res += ") Next: " + to_string(nextOffset[n + 1] - nextOffset[n]) + "\n";
 	}
 	return res;
 }
 
+bool LandmarkHeuristic::isGoal(uint32_t n) {
+	if (fluentOffset[n + 1] - fluentOffset[n] != 1) return false;
+	TVariable v = SASTask::getVariableIndex(fluents[fluentOffset[n]]);
+	TValue value = SASTask::getValueIndex(fluents[fluentOffset[n]]);
+	for (unsigned int i = 0; i < task->goals.size(); i++) {
+		std::shared_ptr<SASAction> g = task->goals[i];
+		for (unsigned int j = 0; j < g->startCond.size(); j++)
+			if (v == g->startCond[j].var && value == g->startCond[j].value) return true;
+		for (unsigned int j = 0; j < g->overCond.size(); j++)
+			if (v == g->overCond[j].var && value == g->overCond[j].value) return true;
+		for (unsigned int j = 0; j < g->endCond.size(); j++)
+			if (v == g->endCond[j].var && value == g->endCond[j].value) return true;
+	}
+	return false;
+}
 
 int LandmarkHeuristic::getNumInformativeNodes() {
 	int n = 0;
-	for (unsigned int i = 0; i < nodes.size(); i++) {
-		if (nodes[i]->isSingle() && !nodes[i]->isGoal(task))
+	for (uint32_t i = 0; i < numNodes; i++) {
+		if (fluentOffset[i + 1] - fluentOffset[i] == 1 && !isGoal(i))
 			n++;
 	}
 	return n;
 }
-
@@ -7,62 +7,47 @@
 #include "../planner/state.h"
 #include "landmarks.h"
 
-class LandmarkCheck {			// Landmarks reachability for heuristic purposes
-private:
-	std::vector<TVariable> vars;
-	std::vector<TValue> values;
-	std::vector<std::weak_ptr<LandmarkCheck>> prev;
-	std::vector<std::shared_ptr<LandmarkCheck>> next;
-	bool checked;
-	bool single;
-
-public:
-	LandmarkCheck(LandmarkNode* n);
-	void addNext(std::shared_ptr<LandmarkCheck> n);
-	void addPrev(std::weak_ptr<LandmarkCheck> n);
-	void removeSuccessor(std::shared_ptr<LandmarkCheck> n);
-	void removePredecessor(std::shared_ptr<LandmarkCheck> n);
-	bool isGoal(std::shared_ptr<SASTask> task);
-	bool goOn(std::shared_ptr<TState> s);
-	bool isInitialState(std::shared_ptr<TState> state);
-	inline void uncheck() { checked = false; }
-	inline void check() { checked = true; }
-	inline bool isChecked() { return checked; }
-	inline bool isSingle() { return single; }
-	inline unsigned int numPrev() { return prev.size(); }
-	inline unsigned int numNext() { return next.size(); }
-	inline TVariable getVar() { return vars[0]; }
-	inline TValue getValue() { return values[0]; }
-	inline std::shared_ptr<LandmarkCheck> getNext(unsigned int i) { return next[i]; }
-	inline std::weak_ptr<LandmarkCheck> getPrev(unsigned int i) { return prev[i]; }
-	std::string toString(std::shared_ptr<SASTask> task, bool showNext);
-};
-
-class LandmarkHeuristic {		// Landmarks heuristic
+// Landmarks heuristic. The landmark graph is stored in flat CSR arrays indexed by node. The progress
+// of the landmarks in a plan is kept in a status bitset: the first numWords words are the checked
+// nodes and the next numWords words are the open nodes (not checked, but with a checked predecessor
+// or without predecessors). The status of a plan is derived from the status of its parent plan
+class LandmarkHeuristic {
 private:
 	std::shared_ptr<SASTask> task;
-	std::vector<std::shared_ptr<LandmarkCheck>> nodes;
-	std::vector<std::shared_ptr<LandmarkCheck>> rootNodes;
+	unsigned int numNodes;
+	unsigned int numWords;						// Number of 64-bit words of each bitset
+	std::vector<uint32_t> fluentOffset;			// For each node, position of its first fluent
+	std::vector<TVarValue> fluents;				// Disjunction of fluents of each node
+	std::vector<uint32_t> nextOffset;			// For each node, position of its first successor
+	std::vector<uint32_t> next;					// Landmark orders
+	std::vector<uint32_t> watchOffset;			// For each (variable, value), position of its first node in watch
+	std::vector<uint32_t> watch;				// Nodes that contain each (variable, value)
+	std::vector<uint32_t> rootNodes;
+	std::vector<uint32_t> pending;				// Nodes to check during the progression
 
-	void addRootNode(std::shared_ptr<LandmarkCheck> n, std::shared_ptr<TState> state, std::vector<std::shared_ptr<LandmarkCheck>>* toDelete);
-	bool hasRootPredecessor(std::shared_ptr<LandmarkCheck> n);
+	void addRootNode(uint32_t n, TState* state, std::vector<std::vector<TVarValue>>& nodeFluents,
+		std::vector<std::vector<uint32_t>>& nextList, std::vector<uint32_t>& toDelete);
+	bool hasRootPredecessor(uint32_t n, std::vector<std::vector<uint32_t>>& prevList);
+	static bool goOn(std::vector<TVarValue>& nodeFluents, TState* s);
+	bool goOn(uint32_t n, TState* s);
+	bool isGoal(uint32_t n);
+	inline bool isChecked(std::vector<uint64_t>& status, uint32_t n) {
+		return (status[n >> 6] >> (n & 63)) & 1;
+	}
+	inline bool isOpen(std::vector<uint64_t>& status, uint32_t n) {
+		return (status[numWords + (n >> 6)] >> (n & 63)) & 1;
+	}
 
 public:
-	LandmarkHeuristic(); 
+	LandmarkHeuristic();
 	~LandmarkHeuristic();
 	void initialize(std::shared_ptr<SASTask> task, std::vector<std::shared_ptr<SASAction>>* tilActions);
 	void initialize(std::shared_ptr<TState> state, std::shared_ptr<SASTask> task, std::vector<std::shared_ptr<SASAction>>* tilActions);
-	void uncheckNodes();
-	uint16_t evaluate();
-	void copyRootNodes(std::vector<std::shared_ptr<LandmarkCheck>>* v);
+	void initialStatus(std::vector<uint64_t>& status);
+	void progress(std::vector<uint64_t>& status, TState* s, std::vector<TVarValue>& changes);
+	uint16_t countUncheckedNodes(std::vector<uint64_t>& status);
 	std::string toString(std::shared_ptr<SASTask> task);
-	inline unsigned int getNumNodes() { return nodes.size(); }
-	inline uint16_t countUncheckedNodes() {
-		uint16_t n = 0;
-		for (unsigned int i = 0; i < nodes.size(); i++)
-			if (!nodes[i]->isChecked()) n++;
-		return n;
-	}
+	inline unsigned int getNumNodes() { return numNodes; }
 	int getNumInformativeNodes();
 };
 
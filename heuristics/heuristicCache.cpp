@@ -0,0 +1,130 @@
+/********************************************************/
+/* Transposition table of heuristic values, keyed by    */
+/* the frontier state of the plans.                     */
+/********************************************************/
+
+#include <iostream>
+#include "heuristicCache.h"
+
+using namespace std;
+
+HeuristicCacheStatistics HeuristicCache::stats;
+
+/********************************************************/
+/* CLASS: HeuristicCacheStatistics                      */
+/********************************************************/
+
+void HeuristicCacheStatistics::print()
+{
+	std::cout << ";Heuristic cache: " << hits << " hits of " << lookups << " lookups ("
+		<< (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "%). Collisions: " << collisions
+		<< ", evictions: " << evictions << std::endl;
+}
+
+/********************************************************/
+/* CLASS: HeuristicCache                                */
+/********************************************************/
+
+HeuristicCache::HeuristicCache()
+{
+	numSASVars = numNumVars = capacity = hand = 0;
+}
+
+// Initializes an empty cache for states of the given size. The number of entries is limited
+// by the memory needed to store the states
+void HeuristicCache::initialize(unsigned int numSASVars, unsigned int numNumVars)
+{
+	this->numSASVars = numSASVars;
+	this->numNumVars = numNumVars;
+	unsigned int stateSize = numSASVars * sizeof(TValue) + 2 * numNumVars * sizeof(TFloatValue);
+	capacity = HEURISTIC_CACHE_ENTRIES;
+	if (stateSize > 0 && HEURISTIC_CACHE_MEMORY / stateSize < capacity)
+		capacity = HEURISTIC_CACHE_MEMORY / stateSize;
+	if (capacity == 0) capacity = 1;
+	hand = 0;
+	keys.clear();
+	limits.clear();
+	values.clear();
+	referenced.clear();
+	states.clear();
+	numStates.clear();
+	index.clear();
+}
+
+// Checks if the state stored in an entry is the given one
+bool HeuristicCache::sameState(unsigned int entry, TState* s, int limit)
+{
+	if (limits[entry] != limit) return false;
+	const TValue* state = states.data() + (size_t)entry * numSASVars;
+	for (unsigned int i = 0; i < numSASVars; i++)
+		if (state[i] != s->state[i]) return false;
+	const TFloatValue* numState = numStates.data() + (size_t)entry * 2 * numNumVars;
+	for (unsigned int i = 0; i < numNumVars; i++) {
+		if (numState[2 * i] != s->minState[i] || numState[2 * i + 1] != s->maxState[i])
+			return false;
+	}
+	return true;
+}
+
+// Searches the heuristic value of a state. Returns false if it is not in the cache
+bool HeuristicCache::find(uint64_t key, TState* s, int limit, int* h)
+{
+	stats.lookups++;
+	std::unordered_map<uint64_t, unsigned int>::const_iterator got = index.find(key);
+	if (got == index.end()) return false;
+	unsigned int entry = got->second;
+	if (!sameState(entry, s, limit)) {
+		stats.collisions++;
+		return false;
+	}
+	referenced[entry] = 1;
+	*h = values[entry];
+	stats.hits++;
+	return true;
+}
+
+// Returns the entry to store a new state. If the cache is full, the clock hand advances,
+// giving a second chance to the referenced entries, until a non-referenced one is found
+unsigned int HeuristicCache::getFreeEntry()
+{
+	if (keys.size() < capacity) {
+		keys.push_back(0);
+		limits.push_back(0);
+		values.push_back(0);
+		referenced.push_back(0);
+		states.resize(states.size() + numSASVars);
+		numStates.resize(numStates.size() + 2 * numNumVars);
+		return (unsigned int)keys.size() - 1;
+	}
+	while (referenced[hand]) {
+		referenced[hand] = 0;
+		hand = (hand + 1) % capacity;
+	}
+	unsigned int entry = hand;
+	hand = (hand + 1) % capacity;
+	std::unordered_map<uint64_t, unsigned int>::iterator got = index.find(keys[entry]);
+	if (got != index.end() && got->second == entry)
+		index.erase(got);
+	stats.evictions++;
+	return entry;
+}
+
+// Stores the heuristic value of a state. An entry with the same key is replaced
+void HeuristicCache::add(uint64_t key, TState* s, int limit, int h)
+{
+	std::unordered_map<uint64_t, unsigned int>::iterator got = index.find(key);
+	unsigned int entry = got != index.end() ? got->second : getFreeEntry();
+	keys[entry] = key;
+	limits[entry] = limit;
+	values[entry] = h;
+	referenced[entry] = 0;
+	TValue* state = states.data() + (size_t)entry * numSASVars;
+	for (unsigned int i = 0; i < numSASVars; i++)
+		state[i] = s->state[i];
+	TFloatValue* numState = numStates.data() + (size_t)entry * 2 * numNumVars;
+	for (unsigned int i = 0; i < numNumVars; i++) {
+		numState[2 * i] = s->minState[i];
+		numState[2 * i + 1] = s->maxState[i];
+	}
+	index[key] = entry;
+}
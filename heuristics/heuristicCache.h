@@ -0,0 +1,62 @@
+#ifndef HEURISTIC_CACHE_H
+#define HEURISTIC_CACHE_H
+
+/********************************************************/
+/* Transposition table of heuristic values, keyed by    */
+/* the frontier state of the plans.                     */
+/********************************************************/
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "../utils/utils.h"
+#include "../planner/state.h"
+
+#define HEURISTIC_CACHE_ENTRIES		65536				// Maximum number of entries
+#define HEURISTIC_CACHE_MEMORY		(64U << 20)			// Maximum memory for the stored states (in bytes)
+
+// Usage statistics of the heuristic cache
+class HeuristicCacheStatistics {
+public:
+	uint64_t lookups;
+	uint64_t hits;
+	uint64_t collisions;	// Same hash key, but different state
+	uint64_t evictions;
+
+	HeuristicCacheStatistics() { lookups = hits = collisions = evictions = 0; }
+	void print();
+};
+
+// Bounded cache of heuristic values. The entries are found through the 64-bit hash of the frontier
+// state (combined with the search limit of the RPG), and the full state is stored to verify the hits.
+// When the cache is full, the entries are replaced with the clock (second chance) policy
+class HeuristicCache {
+private:
+	unsigned int numSASVars;
+	unsigned int numNumVars;
+	unsigned int capacity;
+	unsigned int hand;							// Clock hand
+	std::vector<uint64_t> keys;
+	std::vector<int> limits;
+	std::vector<int> values;
+	std::vector<uint8_t> referenced;
+	std::vector<TValue> states;					// numSASVars values per entry
+	std::vector<TFloatValue> numStates;			// numNumVars minimum and maximum values per entry
+	std::unordered_map<uint64_t, unsigned int> index;	// Hash key -> entry
+
+	bool sameState(unsigned int entry, TState* s, int limit);
+	unsigned int getFreeEntry();
+
+public:
+	static HeuristicCacheStatistics stats;
+
+	HeuristicCache();
+	void initialize(unsigned int numSASVars, unsigned int numNumVars);
+	inline static uint64_t getKey(TState* s, int limit) {
+		return 31 * s->getCode() + (uint64_t)limit;
+	}
+	bool find(uint64_t key, TState* s, int limit, int* h);
+	void add(uint64_t key, TState* s, int limit, int h);
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <atomic>
+#include <thread>
 #include "landmarks.h"
 
 using namespace std;
@@ -6,6 +8,7 @@ using namespace std;
 
 #define NECESSARY	1
 #define REASONABLE	2
+#define MIN_CANDIDATES_PER_THREAD	4	// Below this, spawning threads costs more than the verifications
 
 
 /*******************************************/
@@ -15,18 +18,17 @@ using namespace std;
 bool LandmarkRPG::verifyFluent(TVariable v, TValue value, std::shared_ptr<TState> s, std::shared_ptr<SASTask> task) {
 	this->task = task;
 	initialize(s);
-	achievedFluent.erase(SASTask::getVariableValueCode(v, value));
+	clearAchieved(v, value);
 	while (remainingGoals.size() > 0 && lastLevel->size() > 0) {
 		newLevel->clear();
 		for (unsigned int i = 0; i < lastLevel->size(); i++) {
 			TVariable gv = SASTask::getVariableIndex(lastLevel->at(i));
 			TValue gvalue = SASTask::getValueIndex(lastLevel->at(i));
 			if (gv == v && gvalue == value) continue;
-			std::vector<std::shared_ptr<SASAction>>& aList = task->requirers[gv][gvalue];
-			for (unsigned int j = 0; j < aList.size(); j++) {
-				std::shared_ptr<SASAction> a = aList[j];
-				if (!achievedAction[a->index] && isExecutable(a, v, value)) {
-					achievedAction[a->index] = true;
+			for (uint32_t index : task->getRequirers(gv, gvalue)) {
+				SASAction& a = *task->actions[index];
+				if (!achievedAction[index] && isExecutable(a, v, value)) {
+					achievedAction[index] = true;
 					addActionEffects(a);
 				}
 			}
@@ -43,7 +45,7 @@ bool LandmarkRPG::verifyFluents(std::vector<TVariable>* v, std::vector<TValue>*
 	initialize(s);
 	unsigned int n = v->size();
 	for (unsigned int i = 0; i < n; i++) {
-		achievedFluent.erase(SASTask::getVariableValueCode(v->at(i), value->at(i)));
+		clearAchieved(v->at(i), value->at(i));
 	}
 	while (remainingGoals.size() > 0 && lastLevel->size() > 0) {
 		newLevel->clear();
@@ -58,11 +60,10 @@ bool LandmarkRPG::verifyFluents(std::vector<TVariable>* v, std::vector<TValue>*
 				}
 			}
 			if (!inSet) {
-				std::vector<std::shared_ptr<SASAction>>& aList = task->requirers[gv][gvalue];
-				for (unsigned int j = 0; j < aList.size(); j++) {
-					std::shared_ptr<SASAction> a = aList[j];
-					if (!achievedAction[a->index] && isExecutable(a, v, value)) {
-						achievedAction[a->index] = true;
+				for (uint32_t index : task->getRequirers(gv, gvalue)) {
+					SASAction& a = *task->actions[index];
+					if (!achievedAction[index] && isExecutable(a, v, value)) {
+						achievedAction[index] = true;
 						addActionEffects(a);
 					}
 				}
@@ -83,11 +84,10 @@ bool LandmarkRPG::verifyActions(std::vector<std::shared_ptr<SASAction>>* actions
 		for (unsigned int i = 0; i < lastLevel->size(); i++) {
 			TVariable gv = SASTask::getVariableIndex(lastLevel->at(i));
 			TValue gvalue = SASTask::getValueIndex(lastLevel->at(i));
-			std::vector<std::shared_ptr<SASAction>>& aList = task->requirers[gv][gvalue];
-			for (unsigned int j = 0; j < aList.size(); j++) {
-				std::shared_ptr<SASAction> a = aList[j];
-				if (!achievedAction[a->index] && isExecutable(a) && allowedAction(a, actions)) {
-					achievedAction[a->index] = true;
+			for (uint32_t index : task->getRequirers(gv, gvalue)) {
+				SASAction& a = *task->actions[index];
+				if (!achievedAction[index] && isExecutable(a) && allowedAction(a, actions)) {
+					achievedAction[index] = true;
 					addActionEffects(a);
 				}
 			}
@@ -106,7 +106,7 @@ void LandmarkRPG::swapLevels() {
 	for (i = 0; i < newLevel->size(); i++) {
 		code = newLevel->at(i);
 		if (!fluentAchieved(code)) {
-			achievedFluent[code] = true;
+			setAchieved(code);
 			lastLevel->push_back(code);
 		}
 	}
@@ -123,13 +123,13 @@ void LandmarkRPG::swapLevels() {
 	}
 }
 
-bool LandmarkRPG::isExecutable(std::shared_ptr<SASAction> a, TVariable v, TValue value) {
+bool LandmarkRPG::isExecutable(SASAction& a, TVariable v, TValue value) {
 	if (!isExecutable(a)) return false;
-	for (unsigned int j = 0; j < a->startEff.size(); j++)
-		if (a->startEff[j].var == v && a->startEff[j].value == value) return false;
-	for (unsigned int j = 0; j < a->endEff.size(); j++)
-		if (a->endEff[j].var == v && a->endEff[j].value == value) return false;
-	for (SASConditionalEffect& e : a->conditionalEff) {
+	for (unsigned int j = 0; j < a.startEff.size(); j++)
+		if (a.startEff[j].var == v && a.startEff[j].value == value) return false;
+	for (unsigned int j = 0; j < a.endEff.size(); j++)
+		if (a.endEff[j].var == v && a.endEff[j].value == value) return false;
+	for (SASConditionalEffect& e : a.conditionalEff) {
 		bool executable = true;
 		for (unsigned int j = 0; j < e.startCond.size(); j++)
 			if (!fluentAchieved(e.startCond[j].var, e.startCond[j].value)) { executable = false; break; }
@@ -147,18 +147,18 @@ bool LandmarkRPG::isExecutable(std::shared_ptr<SASAction> a, TVariable v, TValue
 	return true;
 }
 
-bool LandmarkRPG::isExecutable(std::shared_ptr<SASAction> a, std::vector<TVariable>* v, std::vector<TValue>* value) {
+bool LandmarkRPG::isExecutable(SASAction& a, std::vector<TVariable>* v, std::vector<TValue>* value) {
 	if (!isExecutable(a)) return false;
 	unsigned int n = v->size();
-	for (unsigned int j = 0; j < a->startEff.size(); j++) {
+	for (unsigned int j = 0; j < a.startEff.size(); j++) {
 		for (unsigned int i = 0; i < n; i++)
-			if (a->startEff[j].var == v->at(i) && a->startEff[j].value == value->at(i)) return false;
+			if (a.startEff[j].var == v->at(i) && a.startEff[j].value == value->at(i)) return false;
 	}
-	for (unsigned int j = 0; j < a->endEff.size(); j++) {
+	for (unsigned int j = 0; j < a.endEff.size(); j++) {
 		for (unsigned int i = 0; i < n; i++)
-			if (a->endEff[j].var == v->at(i) && a->endEff[j].value == value->at(i)) return false;
+			if (a.endEff[j].var == v->at(i) && a.endEff[j].value == value->at(i)) return false;
 	}
-	for (SASConditionalEffect& e : a->conditionalEff) {
+	for (SASConditionalEffect& e : a.conditionalEff) {
 		bool executable = true;
 		for (unsigned int j = 0; j < e.startCond.size(); j++)
 			if (!fluentAchieved(e.startCond[j].var, e.startCond[j].value)) { executable = false; break; }
@@ -178,38 +178,38 @@ bool LandmarkRPG::isExecutable(std::shared_ptr<SASAction> a, std::vector<TVariab
 	return true;
 }
 
-bool LandmarkRPG::isExecutable(std::shared_ptr<SASAction> a) {
-	for (unsigned int j = 0; j < a->startCond.size(); j++)
-		if (!fluentAchieved(a->startCond[j].var, a->startCond[j].value)) return false;
-	for (unsigned int j = 0; j < a->overCond.size(); j++)
-		if (!fluentAchieved(a->overCond[j].var, a->overCond[j].value)) return false;
-	for (unsigned int j = 0; j < a->endCond.size(); j++)
-		if (!fluentAchieved(a->endCond[j].var, a->endCond[j].value)) return false;
+bool LandmarkRPG::isExecutable(SASAction& a) {
+	for (unsigned int j = 0; j < a.startCond.size(); j++)
+		if (!fluentAchieved(a.startCond[j].var, a.startCond[j].value)) return false;
+	for (unsigned int j = 0; j < a.overCond.size(); j++)
+		if (!fluentAchieved(a.overCond[j].var, a.overCond[j].value)) return false;
+	for (unsigned int j = 0; j < a.endCond.size(); j++)
+		if (!fluentAchieved(a.endCond[j].var, a.endCond[j].value)) return false;
 	return true;
 }
 
-bool LandmarkRPG::allowedAction(std::shared_ptr<SASAction> a, std::vector<std::shared_ptr<SASAction>>* actions) {
+bool LandmarkRPG::allowedAction(SASAction& a, std::vector<std::shared_ptr<SASAction>>* actions) {
 	for (unsigned int i = 0; i < actions->size(); i++) {
-		if (a->index == actions->at(i)->index) return false;
+		if (a.index == actions->at(i)->index) return false;
 	}
 	return true;
 }
 
-void LandmarkRPG::addActionEffects(std::shared_ptr<SASAction> a) {
+void LandmarkRPG::addActionEffects(SASAction& a) {
 	TVarValue code;
-	for (unsigned int j = 0; j < a->startEff.size(); j++) {
-		code = SASTask::getVariableValueCode(a->startEff[j].var, a->startEff[j].value);
+	for (unsigned int j = 0; j < a.startEff.size(); j++) {
+		code = SASTask::getVariableValueCode(a.startEff[j].var, a.startEff[j].value);
 		if (!fluentAchieved(code)) {
 			newLevel->push_back(code);
 		}
 	}
-	for (unsigned int j = 0; j < a->endEff.size(); j++) {
-		code = SASTask::getVariableValueCode(a->endEff[j].var, a->endEff[j].value);
+	for (unsigned int j = 0; j < a.endEff.size(); j++) {
+		code = SASTask::getVariableValueCode(a.endEff[j].var, a.endEff[j].value);
 		if (!fluentAchieved(code)) {
 			newLevel->push_back(code);
 		}
 	}
-	for (SASConditionalEffect& e : a->conditionalEff) {
+	for (SASConditionalEffect& e : a.conditionalEff) {
 		bool executable = true;
 		for (unsigned int j = 0; j < e.startCond.size(); j++)
 			if (!fluentAchieved(e.startCond[j].var, e.startCond[j].value)) { executable = false; break; }
@@ -232,19 +232,25 @@ void LandmarkRPG::addActionEffects(std::shared_ptr<SASAction> a) {
 	}
 }
 
+// Prepares the graph for a new verification. The memory is only allocated in the first one
 void LandmarkRPG::initialize(std::shared_ptr<TState> s) {
-	unsigned int numActions = task->actions.size();
-	achievedAction = std::make_unique<bool[]>(numActions);
+	if (achievedAction == nullptr) {
+		numActions = task->actions.size();
+		achievedAction = std::make_unique<bool[]>(numActions);
+		achievedFluent.assign((task->numVarValues + 63) >> 6, 0);
+		lastLevel = std::make_unique<std::vector<TVarValue>>();
+		lastLevel->reserve((s->numSASVars) << 1);
+		newLevel = std::make_unique<std::vector<TVarValue>>();
+		newLevel->reserve((s->numSASVars) << 1);
+		remainingGoals.reserve(s->numSASVars);
+	}
 	for (unsigned int i = 0; i < numActions; i++) achievedAction[i] = false;
-	lastLevel = std::make_unique<std::vector<TVarValue>>();
-	lastLevel->reserve((s->numSASVars) << 1);
-	newLevel = std::make_unique<std::vector<TVarValue>>();
-	newLevel->reserve((s->numSASVars) << 1);
-	remainingGoals.reserve(s->numSASVars);
+	lastLevel->clear();
+	newLevel->clear();
 	for (unsigned int i = 0; i < s->numSASVars; i++) {
 		TVarValue code = SASTask::getVariableValueCode(i, s->state[i]);
 		lastLevel->push_back(code);
-		achievedFluent[code] = true;
+		setAchieved(code);
 	}
 	for (unsigned int i = 0; i < task->goals.size(); i++) {
     std::shared_ptr<SASAction> g = task->goals[i];
@@ -261,7 +267,7 @@ void LandmarkRPG::addGoal(SASCondition* c) {
 }
 
 void LandmarkRPG::clearMemory() {
-	achievedFluent.clear();
+	std::fill(achievedFluent.begin(), achievedFluent.end(), 0);
 	remainingGoals.clear();
 }
 
@@ -273,11 +279,13 @@ void LandmarkRPG::clearMemory() {
 LandmarkTree::LandmarkTree(std::shared_ptr<TState> state, std::shared_ptr<SASTask> task, std::vector<std::shared_ptr<SASAction>>* tilActions) {
 	this->state = state;
 	this->task = task;
+	verifiers.resize(std::max(1u, std::thread::hardware_concurrency()));
 	rpg.initialize(false, task, tilActions);
 	rpg.build(state);
 	rpg.computeLiteralLevels();
 	rpg.computeActionLevels(state);
 	int size = rpg.getFluentListSize();
+	fluentVerified.assign(size, -1);
 	fluentNode.resize(size);
 	for (unsigned int i = 0; i < size; i++) {
 		fluentNode[i] = -1;
@@ -329,65 +337,87 @@ void LandmarkTree::addGoalNode(SASCondition* c, std::shared_ptr<TState> state) {
 	}
 }
 
-// The RPG is explored backwards, beginning from the last literal level
+// The RPG is explored backwards, beginning from the last literal level. The candidates of all the
+// objectives of a level are computed and verified together, and then processed in order
 void LandmarkTree::exploreRPG() {
+	std::vector<LMCandidates> batch;
 	int level = (int)rpg.getNumFluentLevels() - 1;
 	while (level > 0) {
 #ifdef DEBUG_LANDMARKS_ON
 		cout << "EXPLORING LEVEL " << level << ", whith " << objs[level].size() << " items" << endl;
 #endif
-		for (unsigned int i = 0; i < objs[level].size(); i++) {
-			std::shared_ptr<LMFluent> obj = objs[level][i];
+		unsigned int first = 0;
+		while (first < objs[level].size()) {	// The processing can add new objectives to this level
+			unsigned int last = objs[level].size();
+			batch.clear();
+			batch.resize(last - first);
+			for (unsigned int i = first; i < last; i++) {
+				std::shared_ptr<LMFluent> obj = objs[level][i];
 #ifdef DEBUG_LANDMARKS_ON		
-			cout << "* Obj: " << obj->toString(task) << endl;
+				cout << "* Obj: " << obj->toString(task) << endl;
 #endif
-			// calculate the set A of actions that produce the literal 
-			// Once 'a' is calculated, the action processing method is invoked 
-			// actionProcessing is only launched if there are producers, that is, if A is not an empty set 
+				// calculate the set A of actions that produce the literal 
+				// Once 'a' is calculated, the candidates are computed 
+				// There are only candidates if there are producers, that is, if A is not an empty set 
 #ifdef DEBUG_LANDMARKS_ON
-			for (unsigned int x = 0; x < obj->producers.size(); x++)
-				cout << "* Producer: " << obj->producers[x]->name << endl;
+				for (unsigned int x = 0; x < obj->producers.size(); x++)
+					cout << "* Producer: " << obj->producers[x]->name << endl;
 #endif
-			actionProcessing(&(obj->producers), nodes[fluentNode[obj->index]], level);
-		}
-		for (unsigned int i = 0; i < disjObjs[level].size(); i++) {
-			std::shared_ptr<USet> disjObj = disjObjs[level][i];
+				computeCandidates(&(obj->producers), batch[i - first]);
+			}
+			verifyBatch(batch, level);
+			for (unsigned int i = first; i < last; i++)
+				actionProcessing(batch[i - first], nodes[fluentNode[objs[level][i]->index]], level);
+			first = last;
+		}
+		first = 0;
+		while (first < disjObjs[level].size()) {
+			unsigned int last = disjObjs[level].size();
+			batch.clear();
+			batch.resize(last - first);
+			for (unsigned int i = first; i < last; i++) {
+				std::shared_ptr<USet> disjObj = disjObjs[level][i];
 #ifdef DEBUG_LANDMARKS_ON
-			cout << "* Dobj: " << disjObj->toString(task) << endl;
+				cout << "* Dobj: " << disjObj->toString(task) << endl;
 #endif
-			// For each disjunction of literals in disjObjs[level], we calculate A 
-			// as the union of the producer actions of each literal in the disjunction
-			std::vector<std::shared_ptr<SASAction>> a;
-			bool initialState = false;
-			for (unsigned int j = 0; j < disjObj->fluentSet.size(); j++) {
-				if (disjObj->fluentSet[j]->level == 0) {
-					initialState = true;
-					break;
-				}
-				for (unsigned int k = 0; k < disjObj->fluentSet[j]->producers.size(); k++) {
-					a.push_back(disjObj->fluentSet[j]->producers[k]);
+				// For each disjunction of literals in disjObjs[level], we calculate A 
+				// as the union of the producer actions of each literal in the disjunction
+				std::vector<std::shared_ptr<SASAction>> a;
+				bool initialState = false;
+				for (unsigned int j = 0; j < disjObj->fluentSet.size(); j++) {
+					if (disjObj->fluentSet[j]->level == 0) {
+						initialState = true;
+						break;
+					}
+					for (unsigned int k = 0; k < disjObj->fluentSet[j]->producers.size(); k++) {
+						a.push_back(disjObj->fluentSet[j]->producers[k]);
+					}
 				}
-			}
-			// Once A is calculated, the action processing method is invoked
-			if (!initialState) {
+				// Once A is calculated, the candidates are computed
+				if (!initialState) {
 #ifdef DEBUG_LANDMARKS_ON
-				for (unsigned int x = 0; x < a.size(); x++)
-					cout << "* Producer: " << a[x]->name << endl;
+					for (unsigned int x = 0; x < a.size(); x++)
+						cout << "* Producer: " << a[x]->name << endl;
 #endif
-				actionProcessing(&a, disjObj->node, level);
+					computeCandidates(&a, batch[i - first]);
+				}
 			}
+			verifyBatch(batch, level);
+			for (unsigned int i = first; i < last; i++)
+				actionProcessing(batch[i - first], disjObjs[level][i]->node, level);
+			first = last;
 		}
 		level--;
 	}
 }
 
-void LandmarkTree::actionProcessing(std::vector<std::shared_ptr<SASAction>>* a, std::shared_ptr<LTNode> g, int level) {
+// Computes the candidate landmarks for the set A of producers: the preconditions that are common
+// to all the actions in A, and the disjunctive sets built from the rest of their preconditions
+void LandmarkTree::computeCandidates(std::vector<std::shared_ptr<SASAction>>* a, LMCandidates& c) {
 	if (a->size() == 0) return;
-	std::vector<std::shared_ptr<USet>> d;		// Calculating I set: preconditions that
-	std::vector<std::shared_ptr<LMFluent>> i;	// are common to all the actions in A
 	std::vector<std::shared_ptr<LMFluent>> u;
 	unsigned int numFluents = rpg.getFluentListSize();
-  std::unique_ptr<int[]> common = std::make_unique<int[]>(numFluents);
+	std::unique_ptr<int[]> common = std::make_unique<int[]>(numFluents);
 	for (unsigned int n = 0; n < numFluents; n++) common[n] = 0;
 	for (unsigned int n = 0; n < a->size(); n++) {
 #ifdef DEBUG_LANDMARKS_ON
@@ -397,15 +427,53 @@ void LandmarkTree::actionProcessing(std::vector<std::shared_ptr<SASAction>>* a,
 		checkPreconditions(a->at(n), common);
 	}
 	for (unsigned int n = 0; n < numFluents; n++) {
-		if (common[n] == (int)a->size()) i.push_back(rpg.getFluentByIndex(n));
+		if (common[n] == (int)a->size()) c.fluents.push_back(rpg.getFluentByIndex(n));
 		else if (common[n] > 0) u.push_back(rpg.getFluentByIndex(n));
 	}
+	groupUSet(&c.sets, &u, a);
+}
+
+// Verifies the candidates of a batch in parallel. The verification of a fluent does not depend
+// on the producers it comes from, so each fluent is only verified once. The disjunctive sets are
+// verified if they are not in the graph yet, as they cannot be found afterwards
+void LandmarkTree::verifyBatch(std::vector<LMCandidates>& batch, int level) {
+	std::vector<std::shared_ptr<LMFluent>> fluents;
+	std::vector<std::pair<unsigned int, unsigned int>> sets;	// (Item in the batch, set)
+	for (unsigned int i = 0; i < batch.size(); i++) {
+		LMCandidates& c = batch[i];
+		for (std::shared_ptr<LMFluent>& p : c.fluents) {
+			if (fluentVerified[p->index] < 0) {
+				fluentVerified[p->index] = 0;
+				fluents.push_back(p);
+			}
+		}
+		c.verifiedSets.assign(c.sets.size(), -1);
+		for (unsigned int n = 0; n < c.sets.size(); n++) {
+			if (findDisjObject(c.sets[n], level) == nullptr)
+				sets.emplace_back(i, n);
+		}
+	}
+	unsigned int numFluents = (unsigned int)fluents.size();
+	std::vector<char> verified;
+	verifyCandidates(numFluents + (unsigned int)sets.size(), [&](LandmarkRPG& r, unsigned int n) {
+		if (n < numFluents) return verify(r, fluents[n]);
+		return verify(r, &(batch[sets[n - numFluents].first].sets[sets[n - numFluents].second]->fluentSet));
+	}, verified);
+	for (unsigned int n = 0; n < numFluents; n++)
+		fluentVerified[fluents[n]->index] = verified[n];
+	for (unsigned int n = 0; n < sets.size(); n++)
+		batch[sets[n].first].verifiedSets[sets[n].second] = verified[numFluents + n];
+}
+
+// Adds the verified candidates as landmarks of g
+void LandmarkTree::actionProcessing(LMCandidates& c, std::shared_ptr<LTNode> g, int level) {
+	std::vector<std::shared_ptr<LMFluent>>& i = c.fluents;
 	for (unsigned int n = 0; n < i.size(); n++) {	// Exploring candidate landmarks in I 
 		std::shared_ptr<LMFluent> p = i[n];
 #ifdef DEBUG_LANDMARKS_ON		
 		cout << " - Candidate: " << p->toString(task) << endl;
 #endif
-		if (verify(p)) {
+		if (fluentVerified[p->index] == 1) {
 			// Adding landmark p to N, and transition p->g in E
 			// The literal is stored only if it hasn't appeared before (it is ensured by checking literalNode) 
 			std::shared_ptr<LTNode> node;
@@ -447,12 +515,12 @@ void LandmarkTree::actionProcessing(std::vector<std::shared_ptr<SASAction>>* a,
 		}
 	}
 	// Exploring candidate disjunctive landmarks in D 
-	groupUSet(&d, &u, a);
+	std::vector<std::shared_ptr<USet>>& d = c.sets;
 	for (unsigned int n = 0; n < d.size(); n++) {
 		std::shared_ptr<USet> d2 = d[n];
 		std::shared_ptr<USet> d1 = findDisjObject(d2, level);
 		if (d1 == nullptr) {
-			if (verify(&(d2->fluentSet))) {
+			if (c.verifiedSets[n] == 1 || (c.verifiedSets[n] < 0 && verify(verifiers[0], &(d2->fluentSet)))) {
 				d2->node = std::make_shared<LTNode>(d2, nodes.size());
 				nodes.push_back(d2->node);
 				edges.emplace_back();
@@ -646,14 +714,12 @@ void LandmarkTree::analyzeSet(std::shared_ptr<USet> s, std::vector<std::shared_p
 	}
 }
 
-bool LandmarkTree::verify(std::shared_ptr<LMFluent> p) {
+bool LandmarkTree::verify(LandmarkRPG& r, std::shared_ptr<LMFluent> p) {
 	if (p->isGoal) return true;
-	LandmarkRPG r;
 	return r.verifyFluent(p->variable, p->value, state, task);
 }
 
-bool LandmarkTree::verify(std::vector<std::shared_ptr<LMFluent>>* v) {
-	LandmarkRPG r;
+bool LandmarkTree::verify(LandmarkRPG& r, std::vector<std::shared_ptr<LMFluent>>* v) {
 	std::vector<TVariable> var;
 	std::vector<TValue> val;
 	for (unsigned int i = 0; i < v->size(); i++) {
@@ -666,11 +732,31 @@ bool LandmarkTree::verify(std::vector<std::shared_ptr<LMFluent>>* v) {
 	return r.verifyFluents(&var, &val, state, task);
 }
 
-bool LandmarkTree::verify(std::vector<std::shared_ptr<SASAction>>* a) {
-	LandmarkRPG r;
+bool LandmarkTree::verify(LandmarkRPG& r, std::vector<std::shared_ptr<SASAction>>* a) {
 	return r.verifyActions(a, state, task);
 }
 
+// Verifies n independent candidates, distributing them among the threads. Each thread uses its
+// own LandmarkRPG, and the results are stored in the order of the candidates. Small batches are
+// verified serially in the calling thread
+void LandmarkTree::verifyCandidates(unsigned int n, const std::function<bool(LandmarkRPG&, unsigned int)>& check, std::vector<char>& result) {
+	result.assign(n, 0);
+	std::atomic<unsigned int> next(0);
+	auto worker = [&](LandmarkRPG* r) {
+		unsigned int i;
+		while ((i = next++) < n) {
+			result[i] = check(*r, i) ? 1 : 0;
+		}
+	};
+	unsigned int numThreads = std::min(n / MIN_CANDIDATES_PER_THREAD, (unsigned int)verifiers.size());
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++)
+		threads.emplace_back(worker, &verifiers[t]);
+	worker(&verifiers[0]);
+	for (std::thread& t : threads)
+		t.join();
+}
+
 void LandmarkTree::checkPreconditions(std::shared_ptr<SASAction> a, std::unique_ptr<int[]> &common) {
 	std::vector<int> changed;
 	for (SASCondition &c : a->startCond) {
@@ -757,10 +843,9 @@ int LandmarkTree::equalParameters(std::shared_ptr<LMFluent> l, std::vector<std::
 }
 
 void LandmarkTree::postProcessing() {
-	// P: Candidate landmarks that precede necessarily a given candidate landmark g
-	std::vector<std::shared_ptr<LMFluent>> p;
-	// A: Actions that produce a landmark g
-	std::vector<std::shared_ptr<SASAction>> a;
+	// A: Actions that produce a landmark g, for each ordering l <= n g between single literals
+	std::vector<std::vector<std::shared_ptr<SASAction>>> a;
+	std::vector<std::pair<unsigned int, unsigned int>> orderings;
 	// We analyze all the literal nodes g of the Landmark Tree
 	for (unsigned int i = 0; i < nodes.size(); i++) {	// Only single literals are processed
 		if (nodes[i]->single()) {
@@ -769,25 +854,32 @@ void LandmarkTree::postProcessing() {
 #ifdef DEBUG_LANDMARKS_ON		
 					cout << "PP: " << nodes[j]->toString(task) << " -> " << nodes[i]->toString(task) << endl;
 #endif
-					getActions(&a, nodes[j]->getFluent(), nodes[i]->getFluent());
-					// We check if the actions in A are necessary to reach the goals
-					if (!verify(&a)) {
+					orderings.emplace_back(j, i);
+					a.emplace_back();
+					getActions(&a.back(), nodes[j]->getFluent(), nodes[i]->getFluent());
+				}
+			}
+		}
+	}
+	// We check if the actions in A are necessary to reach the goals. The verifications are independent
+	std::vector<char> necessary;
+	verifyCandidates((unsigned int)a.size(), [&](LandmarkRPG& r, unsigned int n) { return verify(r, &a[n]); }, necessary);
+	for (unsigned int n = 0; n < orderings.size(); n++) {
+		if (!necessary[n]) {
+			unsigned int j = orderings[n].first, i = orderings[n].second;
 #ifdef DEBUG_LANDMARKS_ON		
-						cout << "Removed" << endl;
+			cout << "Removed " << nodes[j]->toString(task) << " -> " << nodes[i]->toString(task) << endl;
 #endif
-						matrix[j][i] = false;
-						// We also remove the ordering from the orderings list
-						unsigned int ord = 0;
-						while (ord < edges.size()) {
-							LMOrdering* e = &(edges[ord]);
-							if (e->node1->single() && e->node2->single() && e->node1->getIndex() == j && e->node2->getIndex() == i) {
-								edges.erase(edges.begin() + ord);
-							}
-							else {
-								ord++;
-							}
-						}
-					}
+			matrix[j][i] = false;
+			// We also remove the ordering from the orderings list
+			unsigned int ord = 0;
+			while (ord < edges.size()) {
+				LMOrdering* e = &(edges[ord]);
+				if (e->node1->single() && e->node2->single() && e->node1->getIndex() == j && e->node2->getIndex() == i) {
+					edges.erase(edges.begin() + ord);
+				}
+				else {
+					ord++;
 				}
 			}
 		}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <functional>
 #include "../planner/state.h"
 #include "temporalRPG.h"
 #include <memory>
@@ -122,11 +123,14 @@ public:
 	}
 };
 
+// Relaxed planning graph to verify landmark candidates. The scratch memory is kept between
+// verifications, so each thread must use its own LandmarkRPG
 class LandmarkRPG {
 private:
 	std::shared_ptr<SASTask> task;
-	std::unordered_map<TVarValue, bool> achievedFluent;
+	std::vector<uint64_t> achievedFluent;		// Bitset indexed by task->getVarValueIndex
   std::unique_ptr<bool[]> achievedAction;
+	unsigned int numActions;
 	std::unique_ptr<std::vector<TVarValue>> lastLevel;
 	std::unique_ptr<std::vector<TVarValue>> newLevel;
 	std::vector<TVarValue> remainingGoals;
@@ -134,25 +138,42 @@ private:
 	void initialize(std::shared_ptr<TState> s);
 	void addGoal(SASCondition* c);
 	inline bool fluentAchieved(TVariable v, TValue value) {
-		return fluentAchieved(SASTask::getVariableValueCode(v, value));
+		unsigned int i = task->getVarValueIndex(v, value);
+		return (achievedFluent[i >> 6] >> (i & 63)) & 1;
 	}
 	inline bool fluentAchieved(TVarValue vv) {
-		return achievedFluent.find(vv) != achievedFluent.end();
+		return fluentAchieved(SASTask::getVariableIndex(vv), SASTask::getValueIndex(vv));
 	}
-	bool isExecutable(std::shared_ptr<SASAction> a, TVariable v, TValue value);
-	bool isExecutable(std::shared_ptr<SASAction> a, std::vector<TVariable>* v, std::vector<TValue>* value);
-	bool isExecutable(std::shared_ptr<SASAction> a);
-	void addActionEffects(std::shared_ptr<SASAction> a);
+	inline void setAchieved(TVarValue vv) {
+		unsigned int i = task->getVarValueIndex(SASTask::getVariableIndex(vv), SASTask::getValueIndex(vv));
+		achievedFluent[i >> 6] |= 1ULL << (i & 63);
+	}
+	inline void clearAchieved(TVariable v, TValue value) {
+		unsigned int i = task->getVarValueIndex(v, value);
+		achievedFluent[i >> 6] &= ~(1ULL << (i & 63));
+	}
+	bool isExecutable(SASAction& a, TVariable v, TValue value);
+	bool isExecutable(SASAction& a, std::vector<TVariable>* v, std::vector<TValue>* value);
+	bool isExecutable(SASAction& a);
+	void addActionEffects(SASAction& a);
 	void swapLevels();
 	void clearMemory();
-	bool allowedAction(std::shared_ptr<SASAction> a, std::vector<std::shared_ptr<SASAction>>* actions);
+	bool allowedAction(SASAction& a, std::vector<std::shared_ptr<SASAction>>* actions);
 
 public:
+	LandmarkRPG() { numActions = 0; }
 	bool verifyFluent(TVariable v, TValue value, std::shared_ptr<TState> s, std::shared_ptr<SASTask> task);
 	bool verifyFluents(std::vector<TVariable>* v, std::vector<TValue>* value, std::shared_ptr<TState> s, std::shared_ptr<SASTask> task);
 	bool verifyActions(std::vector<std::shared_ptr<SASAction>>* actions, std::shared_ptr<TState> s, std::shared_ptr<SASTask> task);
 };
 
+class LMCandidates {		// Candidate landmarks for a set of producers
+public:
+	std::vector<std::shared_ptr<LMFluent>> fluents;		// Preconditions common to all the producers
+	std::vector<std::shared_ptr<USet>> sets;			// Disjunctive sets
+	std::vector<int8_t> verifiedSets;					// 1 = landmark, 0 = not a landmark, -1 = not verified
+};
+
 class LandmarkTree {
 private:
 	std::shared_ptr<TState> state;
@@ -165,14 +186,19 @@ private:
   std::unique_ptr<std::unique_ptr<bool[]>[]> matrix;
 	bool** mutexMatrix;
 	std::vector<LMOrdering> reasonableOrderingsGoalsList;
+	std::vector<LandmarkRPG> verifiers;		// One per thread
+	std::vector<int8_t> fluentVerified;		// By fluent index: 1 = landmark, 0 = not a landmark, -1 = not verified
 
 	void addGoalNode(SASCondition* c, std::shared_ptr<TState> state);
 	void exploreRPG();
-	void actionProcessing(std::vector<std::shared_ptr<SASAction>>* a, std::shared_ptr<LTNode> g, int level);
+	void computeCandidates(std::vector<std::shared_ptr<SASAction>>* a, LMCandidates& c);
+	void verifyBatch(std::vector<LMCandidates>& batch, int level);
+	void actionProcessing(LMCandidates& c, std::shared_ptr<LTNode> g, int level);
 	void checkPreconditions(std::shared_ptr<SASAction> a, std::unique_ptr<int[]> &common);
-	bool verify(std::shared_ptr<LMFluent> p);
-	bool verify(std::vector<std::shared_ptr<LMFluent>>* v);
-	bool verify(std::vector<std::shared_ptr<SASAction>>* a);
+	bool verify(LandmarkRPG& r, std::shared_ptr<LMFluent> p);
+	bool verify(LandmarkRPG& r, std::vector<std::shared_ptr<LMFluent>>* v);
+	bool verify(LandmarkRPG& r, std::vector<std::shared_ptr<SASAction>>* a);
+	void verifyCandidates(unsigned int n, const std::function<bool(LandmarkRPG&, unsigned int)>& check, std::vector<char>& result);
 	void groupUSet(std::vector<std::shared_ptr<USet>>* res, std::vector<std::shared_ptr<LMFluent>>* u, std::vector<std::shared_ptr<SASAction>>* a);
 	void analyzeSet(std::shared_ptr<USet> s, std::vector<std::shared_ptr<SASAction>>* a, std::vector<std::shared_ptr<USet>>* u1);
 	int equalParameters(std::shared_ptr<LMFluent> l, std::vector<std::shared_ptr<LMFluent>>* actionFluents);
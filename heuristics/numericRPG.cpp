@@ -1,4 +1,5 @@
 #include "numericRPG.h"
+#include "../sas/linearConditions.h"
 using namespace std;
 
 /********************************************************/
@@ -12,32 +13,76 @@ using namespace std;
 //#define NUMRPG_DEBUG
 
 // Constructor
-NumericRPG::NumericRPG(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, std::shared_ptr<SASTask> task, int limit)
+NumericRPG::NumericRPG()
+{
+	task = nullptr;
+	epoch = 0;
+	checkEpoch = 0;
+	limit = 0;
+}
+
+// Allocates the graph data for the given task. The graph is reused in every evaluation
+void NumericRPG::initialize(std::shared_ptr<SASTask> task)
 {
 	this->task = task;
+	unsigned int numActions = (unsigned int)task->actions.size();
+	unsigned int numNumVars = (unsigned int)task->numVariables.size();
+	epoch = 0;
+	checkEpoch = 0;
+	literalLevel.assign(task->numVarValues, MAX_INT32);
+	literalStamp.assign(task->numVarValues, 0);
+	lastActionLevel.assign(numActions, -1);
+	actionStamp.assign(numActions, 0);
+	checkedActions.assign(numActions, 0);
+	lastNumVarProducer.assign(numNumVars, -1);
+	numVarStamp.assign(numNumVars, 0);
+	reachedNumStamp.assign(numNumVars, 0);
+	numVarValue.resize(numNumVars);
+	goalLevel.assign(task->goals.size(), MAX_INT32);
+	goalStamp.assign(task->goals.size(), 0);
+	task->linearConditions->initializeBounds(linearBounds);
+}
+
+// Graph reset. Only the data of the previous evaluation is cleared
+void NumericRPG::reset()
+{
+	if (++epoch == 0) {	// Stamps overflow
+		std::fill(literalStamp.begin(), literalStamp.end(), 0);
+		std::fill(actionStamp.begin(), actionStamp.end(), 0);
+		std::fill(numVarStamp.begin(), numVarStamp.end(), 0);
+		std::fill(goalStamp.begin(), goalStamp.end(), 0);
+		epoch = 1;
+	}
+	remainingGoals.clear();
+	for (std::shared_ptr<SASAction> a : task->goals)
+		remainingGoals.push_back(a);
+	numVarProducers.clear();
+	actionLevel.clear();
+	nextLevel.clear();
+	reachedValues.clear();
+	reachedNumValues.clear();
+	openConditions.clear();
+	achievedNumericActions.clear();
+}
+
+// Builds the graph from the given frontier state
+void NumericRPG::build(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit)
+{
 	this->limit = limit > 100 ? 100 : limit;
-	initialize();
+	reset();
 	createFirstFluentLevel(fs, tilActions);
+	evaluateLinearConditions();
 	createFirstActionLevel();
 	expand();
 }
 
-// Graph initialization
-void NumericRPG::initialize()
+// Adds a new level where the action appears
+void NumericRPG::addActionLevel(std::shared_ptr<SASAction> a, int level)
 {
-	int numVars = task->variables.size();
-	int numValues = task->values.size();
-	int numNumVars = task->numVariables.size();
-	literalLevel.resize(numVars);
-	for (int i = 0; i < numVars; i++) {
-		literalLevel[i].resize(numValues, MAX_INT32);
-	}
-	actionLevel.resize(task->actions.size());
-	numVarProducers.resize(numNumVars);
-	numVarValue.resize(numNumVars);
-	for (std::shared_ptr<SASAction> a : task->goals)
-		remainingGoals.push_back(a);
-	goalLevel.resize(task->goals.size(), MAX_INT32);
+	int prev = inGraph(a) ? lastActionLevel[a->index] : -1;
+	actionStamp[a->index] = epoch;
+	lastActionLevel[a->index] = (int)actionLevel.size();
+	actionLevel.emplace_back(level, prev);
 }
 
 // Build the first fluent level of the graph
@@ -49,7 +94,7 @@ void NumericRPG::createFirstFluentLevel(std::shared_ptr<TState> fs, std::vector<
 	// Propositional values
 	for (unsigned int i = 0; i < fs->numSASVars; i++) {
 		TValue v = fs->state[i];
-		literalLevel[i][v] = 0;
+		setLiteralLevel(i, v, 0);
 #ifdef NUMRPG_DEBUG
 		cout << task->variables[i].name << "=" << task->values[v].name << endl;
 #endif
@@ -69,7 +114,7 @@ void NumericRPG::createFirstFluentLevel(std::shared_ptr<TState> fs, std::vector<
 			IntervalCalculations ic(a, 0, this, task);
 			ic.applyEndEffects(&v, nullptr);
 			for (SASCondition& c : a->endEff) {
-				literalLevel[c.var][c.value] = 0;
+				setLiteralLevel(c.var, c.value, 0);
 			}
 			for (TNumVarChange& c : v) {
 				updateNumericValueInterval(c.v, c.min, c.max);
@@ -89,6 +134,18 @@ void NumericRPG::updateNumericValueInterval(int var, float minValue, float maxVa
 	}
 }
 
+// Evaluates the linear numeric conditions of all the actions and goals in the current numeric state
+void NumericRPG::evaluateLinearConditions()
+{
+	const SASLinearConditions& lc = *task->linearConditions;
+	if (lc.empty()) return;
+	for (TVariable v = 0; v < numVarValue.size(); v++) {
+		linearBounds[SASLinearConditions::minBound(v)] = numVarValue[v].minValue;
+		linearBounds[SASLinearConditions::maxBound(v)] = numVarValue[v].maxValue;
+	}
+	lc.evaluate(linearBounds, linearRowHolds, linearActionHolds);
+}
+
 // Build the first action level of the graph
 void NumericRPG::createFirstActionLevel()
 {
@@ -106,6 +163,7 @@ void NumericRPG::createFirstActionLevel()
 				cout << a->name << endl;
 #endif
 				programActionEffects(a, 1);
+				goalStamp[a->index] = epoch;
 				goalLevel[a->index] = 0;
 				remainingGoals.erase(remainingGoals.begin() + i);
 			}
@@ -123,16 +181,8 @@ void NumericRPG::createFirstActionLevel()
 // Check if an action can be applied in the given level of the graph
 bool NumericRPG::isApplicable(std::shared_ptr<SASAction> a, int level)
 {
-	for (SASCondition& c : a->startCond) {
-		if (literalLevel[c.var][c.value] > level)
-			return false;
-	}
-	for (SASCondition& c : a->overCond) {
-		if (literalLevel[c.var][c.value] > level)
-			return false;
-	}
-	for (SASCondition& c : a->endCond) {
-		if (literalLevel[c.var][c.value] > level)
+	for (TVarValue c : task->actionTable->getAllConditions(task->actionTable->getIndex(*a))) {
+		if (getLiteralLevel(SASTask::getVariableIndex(c), SASTask::getValueIndex(c)) > level)
 			return false;
 	}
 	return true;
@@ -150,11 +200,11 @@ std::shared_ptr<bool[]> NumericRPG::calculateCondEffHold(std::shared_ptr<SASActi
 
 bool NumericRPG::checkCondEffectHold(SASConditionalEffect& e, int level, IntervalCalculations& ic) {
 	for (SASCondition& c : e.startCond) {
-		if (literalLevel[c.var][c.value] > level)
+		if (getLiteralLevel(c.var, c.value) > level)
 			return false;
 	}
 	for (SASCondition& c : e.endCond) {
-		if (literalLevel[c.var][c.value] > level)
+		if (getLiteralLevel(c.var, c.value) > level)
 			return false;
 	}
 	for (SASNumericCondition& c : e.startNumCond) {
@@ -172,8 +222,11 @@ bool NumericRPG::checkCondEffectHold(SASConditionalEffect& e, int level, Interva
 void NumericRPG::programActionEffects(std::shared_ptr<SASAction> a, int level)
 {
 	std::vector<TNumVarChange> svc, evc;
+	unsigned int index = task->actionTable->getIndex(*a);
+	bool batched = task->linearConditions->isBatched(index);
+	if (batched && !linearActionHolds[index]) return;
 	IntervalCalculations ic(a, level, this, task);
-	if (!ic.supportedNumericStartConditions(nullptr)) return;
+	if (!batched && !ic.supportedNumericStartConditions(nullptr)) return;
 	std::shared_ptr<bool[]> holdCondPrec = calculateCondEffHold(a, level, ic);
 	ic.applyStartEffects(&svc, holdCondPrec);
 	ic.applyEndEffects(&evc, holdCondPrec);
@@ -181,23 +234,15 @@ void NumericRPG::programActionEffects(std::shared_ptr<SASAction> a, int level)
 		return;
 	}
 	bool newEffects = false;
-	for (SASCondition& c : a->startEff) {
-		if (literalLevel[c.var][c.value] > level) {
-			literalLevel[c.var][c.value] = level;
-			nextLevel.emplace_back(c.var, c.value, a);
-			newEffects = true;
-#ifdef NUMRPG_DEBUG
-			cout << "\tEffect: " << task->variables[c.var].name << "=" << task->values[c.value].name << endl;
-#endif
-		}
-	}
-	for (SASCondition& c : a->endEff) {
-		if (literalLevel[c.var][c.value] > level) {
-			literalLevel[c.var][c.value] = level;
-			nextLevel.emplace_back(c.var, c.value, a);
+	for (TVarValue e : task->actionTable->getAllEffects(task->actionTable->getIndex(*a))) {
+		TVariable var = SASTask::getVariableIndex(e);
+		TValue value = SASTask::getValueIndex(e);
+		if (getLiteralLevel(var, value) > level) {
+			setLiteralLevel(var, value, level);
+			nextLevel.emplace_back(var, value, a);
 			newEffects = true;
 #ifdef NUMRPG_DEBUG
-			cout << "\tEffect: " << task->variables[c.var].name << "=" << task->values[c.value].name << endl;
+			cout << "\tEffect: " << task->variables[var].name << "=" << task->values[value].name << endl;
 #endif
 		}
 	}
@@ -216,8 +261,8 @@ void NumericRPG::programActionEffects(std::shared_ptr<SASAction> a, int level)
 			if (holdCondPrec[i]) {
 				SASConditionalEffect& e = a->conditionalEff[i];
 				for (SASCondition& c : e.startEff) {
-					if (literalLevel[c.var][c.value] > level) {
-						literalLevel[c.var][c.value] = level;
+					if (getLiteralLevel(c.var, c.value) > level) {
+						setLiteralLevel(c.var, c.value, level);
 						nextLevel.emplace_back(c.var, c.value, a);
 						newEffects = true;
 #ifdef NUMRPG_DEBUG
@@ -226,8 +271,8 @@ void NumericRPG::programActionEffects(std::shared_ptr<SASAction> a, int level)
 					}
 				}
 				for (SASCondition& c : e.endEff) {
-					if (literalLevel[c.var][c.value] > level) {
-						literalLevel[c.var][c.value] = level;
+					if (getLiteralLevel(c.var, c.value) > level) {
+						setLiteralLevel(c.var, c.value, level);
 						nextLevel.emplace_back(c.var, c.value, a);
 						newEffects = true;
 #ifdef NUMRPG_DEBUG
@@ -239,18 +284,18 @@ void NumericRPG::programActionEffects(std::shared_ptr<SASAction> a, int level)
 		}
 	}
 	if (newEffects) { // Action generates new values
-		if (actionLevel[a->index].empty() && (a->endNumEff.size() > 0 || a->startNumEff.size() > 0))
+		if (!inGraph(a) && (a->endNumEff.size() > 0 || a->startNumEff.size() > 0))
 			achievedNumericActions.push_back(a);
-		actionLevel[a->index].push_back(level - 1);			   // Action added to the current level
+		addActionLevel(a, level - 1);			   // Action added to the current level
 #ifdef NUMRPG_DEBUG
 		//cout << "\tAction added to level" << endl;
 		cout << a->name << endl;
 #endif
 	}
-	else if (actionLevel[a->index].empty() && a->endNumEff.empty() && a->startNumEff.empty()) {
+	else if (!inGraph(a) && a->endNumEff.empty() && a->startNumEff.empty()) {
 		// Action does not produces new values, but appears the first time and has no numeric effects ->
 		// add to the RPG not to check it again
-		actionLevel[a->index].push_back(level - 1);			   // Action added to the current level
+		addActionLevel(a, level - 1);			   // Action added to the current level
 #ifdef NUMRPG_DEBUG
 		//cout << "\tAction added to level" << endl;
 		cout << a->name << endl;
@@ -276,7 +321,6 @@ void NumericRPG::programNumericEffect(TVariable v, int level, TFloatValue min, T
 void NumericRPG::expand()
 {
 	int currentLevel = 0;
-	std::unordered_set<int> checkedActions;
 	while (remainingGoals.size() > 0 && nextLevel.size() > 0) {
 		currentLevel++;
 #ifdef NUMRPG_DEBUG
@@ -284,6 +328,7 @@ void NumericRPG::expand()
 #endif
 		if (!updateNumericValues(currentLevel))		// Update numeric values
 			break;									// Unreachable goals
+		evaluateLinearConditions();
 		int i = 0;
 		while (i < remainingGoals.size()) {
 			if (checkGoal(remainingGoals[i], currentLevel)) { // Goal achieved
@@ -298,26 +343,25 @@ void NumericRPG::expand()
 
 		for (std::shared_ptr<SASAction> a : achievedNumericActions) {
 			programActionEffects(a, currentLevel + 1);
-			checkedActions.insert(a->index);
+			checkedActions[a->index] = checkEpoch;
 		}
 
 		for (TVarValue vv : reachedValues) {	// Add actions that require this proposition
-			for (std::shared_ptr<SASAction> a : task->requirers[task->getVariableIndex(vv)][task->getValueIndex(vv)]) {
-				if (checkedActions.find(a->index) == checkedActions.end()) {
-					checkAction(a, currentLevel);
-					checkedActions.insert(a->index);
+			for (uint32_t a : task->getRequirers(task->getVariableIndex(vv), task->getValueIndex(vv))) {
+				if (checkedActions[a] != checkEpoch) {
+					checkAction(task->actions[a], currentLevel);
+					checkedActions[a] = checkEpoch;
 				}
 			}
 		}
-		for (const TVariable& v : reachedNumValues) { // Add actions that need this numeric value
-			for (std::shared_ptr<SASAction> a : task->numRequirers[v]) {
-				if (checkedActions.find(a->index) == checkedActions.end()) {
-					checkAction(a, currentLevel);
-					checkedActions.insert(a->index);
+		for (TVariable v : reachedNumValues) { // Add actions that need this numeric value
+			for (uint32_t a : task->getNumRequirers(v)) {
+				if (checkedActions[a] != checkEpoch) {
+					checkAction(task->actions[a], currentLevel);
+					checkedActions[a] = checkEpoch;
 				}
 			}
 		}
-		checkedActions.clear();
 	}
 #ifdef NUMRPG_DEBUG
 	cout << "Remaining goals: " << remainingGoals.size() << endl;
@@ -330,15 +374,29 @@ bool NumericRPG::updateNumericValues(int level)
 	bool onlyNumericVariables = true;
 	reachedValues.clear();
 	reachedNumValues.clear();
+	if (++checkEpoch == 0) {	// Stamps overflow
+		std::fill(checkedActions.begin(), checkedActions.end(), 0);
+		std::fill(reachedNumStamp.begin(), reachedNumStamp.end(), 0);
+		checkEpoch = 1;
+	}
 	for (NumericRPGEffect& c : nextLevel)
 	{
 		if (c.numeric) {
 			bool changeMin = c.minValue < numVarValue[c.var].minValue;
 			bool changeMax = c.maxValue > numVarValue[c.var].maxValue;
 			if (changeMin || changeMax) {
-				numVarProducers[c.var].resize(level);
-				NumericRPGproducers& prod = numVarProducers[c.var][level - 1];
-				reachedNumValues.insert(c.var);
+				int last = numVarStamp[c.var] == epoch ? lastNumVarProducer[c.var] : -1;
+				if (last == -1 || numVarProducers[last].level != level - 1) {
+					numVarProducers.emplace_back(c.var, level - 1, last);
+					last = (int)numVarProducers.size() - 1;
+					numVarStamp[c.var] = epoch;
+					lastNumVarProducer[c.var] = last;
+				}
+				NumericRPGproducers& prod = numVarProducers[last];
+				if (reachedNumStamp[c.var] != checkEpoch) {
+					reachedNumStamp[c.var] = checkEpoch;
+					reachedNumValues.push_back(c.var);
+				}
 				if (changeMin) {
 					numVarValue[c.var].minValue = c.minValue;
 					prod.minProducer = c.a;
@@ -368,12 +426,12 @@ bool NumericRPG::updateNumericValues(int level)
 		if (--limit <= 0) 
 			return false;
 		for (TVariable v : reachedNumValues) {
-			for (std::shared_ptr<SASAction> a : task->numRequirers[v]) {
-				if (actionLevel[a->index].empty())
+			for (uint32_t a : task->getNumRequirers(v)) {
+				if (actionStamp[a] != epoch)
 					return true;
 			}
 			for (std::shared_ptr<SASAction> g : task->numGoalRequirers[v]) {
-				if (goalLevel[g->index] == MAX_INT32)
+				if (getGoalLevel(g) == MAX_INT32)
 					return true;
 			}
 		}
@@ -385,7 +443,7 @@ bool NumericRPG::updateNumericValues(int level)
 // Check if an action can be inserted in the graph
 void NumericRPG::checkAction(std::shared_ptr<SASAction> a, int level)
 {
-	if (actionLevel[a->index].size() > 0 && a->endNumEff.empty() && a->startNumEff.empty())
+	if (inGraph(a) && a->endNumEff.empty() && a->startNumEff.empty())
 		return;	// Action already in the RPG without numeric effects
 	if (!isApplicable(a, level))
 		return;	// Action not applicable
@@ -400,38 +458,48 @@ bool NumericRPG::checkGoal(std::shared_ptr<SASAction> a, int level)
 {
 	if (!isApplicable(a, level))
 		return false;	// Action not applicable
-	IntervalCalculations ic(a, level, this, task);
-	if (!ic.supportedNumericStartConditions(nullptr))
-		return false;
+	unsigned int index = task->actionTable->getIndex(*a);
+	if (task->linearConditions->isBatched(index)) {
+		if (!linearActionHolds[index])
+			return false;
+	}
+	else {
+		IntervalCalculations ic(a, level, this, task);
+		if (!ic.supportedNumericStartConditions(nullptr))
+			return false;
+	}
 #ifdef NUMRPG_DEBUG
 	cout << "Goal " << a->index << " achieved" << endl;
 #endif
+	goalStamp[a->index] = epoch;
 	goalLevel[a->index] = level;
 	return true;
 }
 
 // Heuristic evaluation: length of the relaxed plan
-int NumericRPG::evaluate()
+int NumericRPG::evaluate(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit)
 {
+	build(fs, tilActions, limit);
 	if (remainingGoals.size() > 0) return MAX_UINT16;
 	int h = 0, level;
 	for (std::shared_ptr<SASAction> g : task->goals) {
-		addSubgoals(g, goalLevel[g->index], nullptr);
+		addSubgoals(g, getGoalLevel(g), nullptr);
 	}
 	std::shared_ptr<SASAction> a;
+	NumericRPGCondition c;
 	while (openConditions.size() > 0) {
-		std::shared_ptr<NumericRPGCondition> c = std::dynamic_pointer_cast<NumericRPGCondition>(openConditions.poll());
-		if (c->type == 'V') {
-			a = searchBestAction(c->var, c->value, c->level, &level);
+		openConditions.poll(c);
+		if (c.type == 'V') {
+			a = searchBestAction(c.var, c.value, c.level, &level);
 		}
 		else {
-			level = c->level; 
-			a = c->producer;
+			level = c.level; 
+			a = c.producer;
 		}
 		if (a != nullptr) {
             // h++;
             h += a->startNumEff[0].exp.value;
-            addSubgoals(a, level, c->type != 'V' ? c : nullptr);
+            addSubgoals(a, level, c.type != 'V' ? &c : nullptr);
 		}
 	}
 #ifdef NUMRPG_DEBUG
@@ -441,29 +509,31 @@ int NumericRPG::evaluate()
 }
 
 // Evaluation of the initial plan
-int NumericRPG::evaluateInitialPlan(/*bool* usefulActions*/) {
+int NumericRPG::evaluateInitialPlan(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit) {
+	build(fs, tilActions, limit);
 	if (remainingGoals.size() > 0) return MAX_UINT16;
 	int h = 0, level;
 	for (std::shared_ptr<SASAction> g : task->goals) {
-		addSubgoals(g, goalLevel[g->index], nullptr);
+		addSubgoals(g, getGoalLevel(g), nullptr);
 	}
 	std::shared_ptr<SASAction> a;
+	NumericRPGCondition c;
 	while (openConditions.size() > 0) {
-		std::shared_ptr<NumericRPGCondition> c = std::dynamic_pointer_cast<NumericRPGCondition>(openConditions.poll());
+		openConditions.poll(c);
 #ifdef NUMRPG_DEBUG
-		cout << "Condition: " << task->variables[c->var].name << "=" << task->values[c->value].name << endl;
+		cout << "Condition: " << task->variables[c.var].name << "=" << task->values[c.value].name << endl;
 #endif
-		if (c->type == 'V') {
-			a = searchBestAction(c->var, c->value, c->level, &level);
+		if (c.type == 'V') {
+			a = searchBestAction(c.var, c.value, c.level, &level);
 		}
 		else {
-			level = c->level;
-			a = c->producer;
+			level = c.level;
+			a = c.producer;
 		}
 		if (a != nullptr) {
 			h++;
 			//usefulActions[a->index] = true;
-			addSubgoals(a, level, c->type != 'V' ? c : nullptr);
+			addSubgoals(a, level, c.type != 'V' ? &c : nullptr);
 		}
 	}
 #ifdef NUMRPG_DEBUG
@@ -473,7 +543,7 @@ int NumericRPG::evaluateInitialPlan(/*bool* usefulActions*/) {
 }
 
 // Add the conditions of an action as new subgoals for the relaxed plan
-void NumericRPG::addSubgoals(std::shared_ptr<SASAction> a, int level, std::shared_ptr<NumericRPGCondition> cp)
+void NumericRPG::addSubgoals(std::shared_ptr<SASAction> a, int level, NumericRPGCondition* cp)
 {
 #ifdef NUMRPG_DEBUG
 	cout << "Adding subgoals of action " << a->name << endl;
@@ -484,31 +554,31 @@ void NumericRPG::addSubgoals(std::shared_ptr<SASAction> a, int level, std::share
 		addSubgoal(&c);
 	for (SASCondition& c : a->endCond)
 		addSubgoal(&c);
-	std::vector<std::shared_ptr<NumericRPGCondition>> numCond;
+	numCond.clear();
 	for (SASNumericCondition& c: a->startNumCond)
-		addSubgoal(a, &c, level, &numCond);
+		addSubgoal(a, &c, level);
 	for (SASNumericCondition& c : a->overNumCond)
-		addSubgoal(a, &c, level, &numCond);
+		addSubgoal(a, &c, level);
 	for (SASNumericCondition& c : a->endNumCond)
-		addSubgoal(a, &c, level, &numCond);
+		addSubgoal(a, &c, level);
 	bool needToAddNumVarCond = cp != nullptr;
-	for (std::shared_ptr<NumericRPGCondition> c : numCond) {
+	for (NumericRPGCondition& c : numCond) {
 		openConditions.add(c);
-		if (needToAddNumVarCond && (c->level == level - 1 || (c->type != 'V' && c->var == cp->var)))
+		if (needToAddNumVarCond && (c.level == level - 1 || (c.type != 'V' && c.var == cp->var)))
 			needToAddNumVarCond = false;
 #ifdef NUMRPG_DEBUG
-		cout << "* Level " << (c->level + 1) << ": " << task->numVariables[c->var].name << " (" << c->type << ")" << endl;
+		cout << "* Level " << (c.level + 1) << ": " << task->numVariables[c.var].name << " (" << c.type << ")" << endl;
 #endif
 	}
 	if (needToAddNumVarCond) {
 		numCond.clear();
-		int varLevel = cp->type == '+' ? findMaxNumVarLevel(cp->var, level) : findMinNumVarLevel(cp->var, level);
-		if (varLevel >= 0) {
-			addNumericSubgoal(cp->var, varLevel, cp->type == '+', &numCond);
-			for (std::shared_ptr<NumericRPGCondition> c : numCond) {
+		int entry = cp->type == '+' ? findMaxNumVarLevel(cp->var, level) : findMinNumVarLevel(cp->var, level);
+		if (entry >= 0) {
+			addNumericSubgoal(entry, cp->type == '+');
+			for (NumericRPGCondition& c : numCond) {
 				openConditions.add(c);
 #ifdef NUMRPG_DEBUG
-				cout << "* Level " << (c->level + 1) << ": " << task->numVariables[c->var].name << " (" << c->type << ")" << endl;
+				cout << "* Level " << (c.level + 1) << ": " << task->numVariables[c.var].name << " (" << c.type << ")" << endl;
 #endif
 			}
 		}
@@ -518,10 +588,10 @@ void NumericRPG::addSubgoals(std::shared_ptr<SASAction> a, int level, std::share
 // Add the given condition of an action as new subgoal for the relaxed plan
 void NumericRPG::addSubgoal(SASCondition* c)
 {
-	int level = literalLevel[c->var][c->value];
+	int level = getLiteralLevel(c->var, c->value);
 	if (level > 0) {	// Not solved yet
-		literalLevel[c->var][c->value] = 0;		// Not to repeat it again
-		openConditions.add(std::make_shared<NumericRPGCondition>(c, level));
+		setLiteralLevel(c->var, c->value, 0);		// Not to repeat it again
+		openConditions.add(NumericRPGCondition(c, level));
 #ifdef NUMRPG_DEBUG
 		cout << "* Level " << level << ": " << task->variables[c->var].name << "=" << task->values[c->value].name << endl;
 #endif
@@ -529,137 +599,136 @@ void NumericRPG::addSubgoal(SASCondition* c)
 }
 
 // Add the given numeric condition of an action as new subgoal for the relaxed plan
-void NumericRPG::addSubgoal(std::shared_ptr<SASAction> a, SASNumericCondition* c, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond)
+void NumericRPG::addSubgoal(std::shared_ptr<SASAction> a, SASNumericCondition* c, int level)
 {
 	switch (c->comp) {
 	case '-': break;
 	case '>': // >
 	case 'G': // x >= y
-		addMaxValueSubgoal(a, &(c->terms.at(0)), level, numCond);
-		addMinValueSubgoal(a, &(c->terms.at(1)), level, numCond);
+		addMaxValueSubgoal(a, &(c->terms.at(0)), level);
+		addMinValueSubgoal(a, &(c->terms.at(1)), level);
 		break;
 	case '<':
 	case 'L':
-		addMinValueSubgoal(a, &(c->terms.at(0)), level, numCond);
-		addMaxValueSubgoal(a, &(c->terms.at(1)), level, numCond);
+		addMinValueSubgoal(a, &(c->terms.at(0)), level);
+		addMaxValueSubgoal(a, &(c->terms.at(1)), level);
 		break;
 	default:
-		addMinValueSubgoal(a, &(c->terms.at(0)), level, numCond);
-		addMaxValueSubgoal(a, &(c->terms.at(0)), level, numCond);
-		addMinValueSubgoal(a, &(c->terms.at(1)), level, numCond);
-		addMaxValueSubgoal(a, &(c->terms.at(1)), level, numCond);
+		addMinValueSubgoal(a, &(c->terms.at(0)), level);
+		addMaxValueSubgoal(a, &(c->terms.at(0)), level);
+		addMinValueSubgoal(a, &(c->terms.at(1)), level);
+		addMaxValueSubgoal(a, &(c->terms.at(1)), level);
 	}
 }
 
 // Add the given (maximize) numeric condition of an action as new subgoal for the relaxed plan
-void NumericRPG::addMaxValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond)
+void NumericRPG::addMaxValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level)
 {
 	if (e->type == 'V') {
-		int varLevel = findMaxNumVarLevel(e->var, level);
-		if (varLevel >= 0) {
-			addNumericSubgoal(e->var, varLevel, true, numCond);
+		int entry = findMaxNumVarLevel(e->var, level);
+		if (entry >= 0) {
+			addNumericSubgoal(entry, true);
 		}
 	}
 	else {
 		for (SASNumericExpression& t : e->terms) {
-			addMaxValueSubgoal(a, &t, level, numCond);
+			addMaxValueSubgoal(a, &t, level);
 		}
 	}
 }
 
 // Add the given (minimize) numeric condition of an action as new subgoal for the relaxed plan
-void NumericRPG::addMinValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond)
+void NumericRPG::addMinValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level)
 {
 	if (e->type == 'V') {
-		int varLevel = findMinNumVarLevel(e->var, level);
-		if (varLevel > 0) {
-			addNumericSubgoal(e->var, varLevel, false, numCond);
+		int entry = findMinNumVarLevel(e->var, level);
+		if (entry >= 0 && numVarProducers[entry].level > 0) {
+			addNumericSubgoal(entry, false);
 		}
 	}
 	else {
 		for (SASNumericExpression& t : e->terms) {
-			addMaxValueSubgoal(a, &t, level, numCond);
+			addMaxValueSubgoal(a, &t, level);
 		}
 	}
 }
 
-// Add the given condition of an action as new subgoal for the relaxed plan
-void NumericRPG::addNumericSubgoal(TVariable v, int level, bool max, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond) {
-	TVarValue vv = task->getVariableValueCode(v, level);
-	if (numericSubgoals.find(vv) != numericSubgoals.end()) return;
-	numericSubgoals.insert(vv);
-	NumericRPGproducers& prod = numVarProducers[v][level];
+// Add the given change of a numeric variable (entry in numVarProducers) as new subgoal for the relaxed plan
+void NumericRPG::addNumericSubgoal(int entry, bool max) {
+	NumericRPGproducers& prod = numVarProducers[entry];
+	if (prod.subgoal) return;
+	prod.subgoal = true;
 	std::shared_ptr<SASAction> a = max ? prod.maxProducer : prod.minProducer;
-	numCond->push_back(std::make_shared<NumericRPGCondition>(v, max, level, a));
+	numCond.emplace_back(prod.var, max, prod.level, a);
 }
 
 // Searches the best action to support the condition
 std::shared_ptr<SASAction> NumericRPG::searchBestAction(TVariable v, TValue value, int level, int* actionLevel)
 {
-	std::shared_ptr<SASAction> best = nullptr;
-	for (std::shared_ptr<SASAction> a : task->producers[v][value]) {
-		int prodActionLevel = findLevel(a->index, level);
+	int best = -1;
+	for (uint32_t a : task->getProducers(v, value)) {
+		int prodActionLevel = findLevel(a, level);
 		if (prodActionLevel != -1) {
 			if (prodActionLevel == 0) {
 				*actionLevel = 0;
-				return a;
+				return task->actions[a];
 			}
-			else if (best == nullptr || prodActionLevel < *actionLevel) {
+			else if (best == -1 || prodActionLevel < *actionLevel) {
 				best = a;
 				*actionLevel = prodActionLevel;
 			}
 		}
 	}
-	for (SASConditionalProducer& cp : task->condProducers[v][value]) {
-		int prodActionLevel = findLevel(cp.a->index, level);
+	for (const SASConditionalProducerIndex& cp : task->getCondProducers(v, value)) {
+		int prodActionLevel = findLevel(cp.action, level);
 		if (prodActionLevel != -1) {
 			if (prodActionLevel == 0) {
 				*actionLevel = 0;
-				return cp.a;
+				return task->actions[cp.action];
 			}
-			else if (best == nullptr || prodActionLevel < *actionLevel) {
-				best = cp.a;
+			else if (best == -1 || prodActionLevel < *actionLevel) {
+				best = cp.action;
 				*actionLevel = prodActionLevel;
 			}
 		}
 	}
-	return best;
+	return best == -1 ? nullptr : task->actions[best];
 }
 
-// Check the last level (before maxLevel) where v changes its lower value
+// Check the last level (before maxLevel) where v changes its lower value. Returns its entry in numVarProducers
 int NumericRPG::findMinNumVarLevel(TVariable v, int maxLevel)
 {
-	std::vector<NumericRPGproducers>& prod = numVarProducers[v];
-	int level = maxLevel;
-	if (prod.size() < level) level = (int)prod.size();
-	for (int i = level - 1; i >= 0; i--) {
-		if (prod[i].minProducer != nullptr)
+	int i = numVarStamp[v] == epoch ? lastNumVarProducer[v] : -1;
+	while (i != -1) {
+		NumericRPGproducers& prod = numVarProducers[i];
+		if (prod.level < maxLevel && prod.minProducer != nullptr)
 			return i;
+		i = prod.prev;
 	}
 	return -1;
 }
 
-// Check the last level (before maxLevel) where v changes its higher value
+// Check the last level (before maxLevel) where v changes its higher value. Returns its entry in numVarProducers
 int NumericRPG::findMaxNumVarLevel(TVariable v, int maxLevel)
 {
-	std::vector<NumericRPGproducers>& prod = numVarProducers[v];
-	int level = (int)prod.size();
-	if (level > maxLevel) level = maxLevel;
-	for (int i = level - 1; i >= 0; i--) {
-		if (prod[i].maxProducer != nullptr)
+	int i = numVarStamp[v] == epoch ? lastNumVarProducer[v] : -1;
+	while (i != -1) {
+		NumericRPGproducers& prod = numVarProducers[i];
+		if (prod.level < maxLevel && prod.maxProducer != nullptr)
 			return i;
+		i = prod.prev;
 	}
 	return -1;
 }
 
-// Check the last level (before maxLevel) where v changes its value
+// Check the last level (before maxLevel) where the action appears
 int NumericRPG::findLevel(int actionIndex, int maxLevel)
 {
-	std::vector<int>& levels = actionLevel[actionIndex];
-	for (int i = (int)levels.size() - 1; i >= 0; i--)
-	{ 
-		if (levels[i] < maxLevel)
-			return levels[i];
+	int i = actionStamp[actionIndex] == epoch ? lastActionLevel[actionIndex] : -1;
+	while (i != -1) {
+		if (actionLevel[i].level < maxLevel)
+			return actionLevel[i].level;
+		i = actionLevel[i].prev;
 	}
 	return -1;
 }
@@ -10,7 +10,6 @@
 /********************************************************/
 
 #include <vector>
-#include <unordered_set>
 #include "../utils/priorityQueue.h"
 #include "../sas/sasTask.h"
 #include "../planner/state.h"
@@ -46,7 +45,7 @@ public:
 };
 
 // Numeric condition
-class NumericRPGCondition : public PriorityQueueItem {
+class NumericRPGCondition {
 public:
 	char type;	// 'V': sas variable, '-': numeric var (minimum value required), '+': numeric var (maximum value required)
 	TVariable var;
@@ -54,6 +53,7 @@ public:
 	int level;
 	std::shared_ptr<SASAction> producer;	// Only for numeric conditions
 
+	NumericRPGCondition() { }
 	NumericRPGCondition(SASCondition* c, int l) {
 		type = 'V';
 		var = c->var;
@@ -66,44 +66,98 @@ public:
 		level = l;
 		producer = p;
 	}
-	inline int compare(std::shared_ptr<PriorityQueueItem> other) {
-		return std::dynamic_pointer_cast<NumericRPGCondition>(other)->level - level;
+	inline int compare(const NumericRPGCondition& other) const {
+		return other.level - level;
 	}
-	virtual ~NumericRPGCondition() { }
 };
 
-// Actions that produce a given value interval for a variable
+// Actions that produce a given value interval for a variable in a level of the graph
 class NumericRPGproducers {
 public:
+	TVariable var;
+	int level;
 	std::shared_ptr<SASAction> minProducer;
 	float minValue;
 	std::shared_ptr<SASAction> maxProducer;
 	float maxValue;
+	int prev;			// Entry of the previous level where the variable changed (-1 if none)
+	bool subgoal;		// Already added as a subgoal in the relaxed plan
+
+	NumericRPGproducers(TVariable v, int l, int p) {
+		var = v;
+		level = l;
+		minProducer = maxProducer = nullptr;
+		prev = p;
+		subgoal = false;
+	}
+};
+
+// Level where an action appears in the graph
+class NumericRPGActionLevel {
+public:
+	int level;
+	int prev;			// Entry of the previous level where the action appeared (-1 if none)
 
-	NumericRPGproducers() { minProducer = maxProducer = nullptr; }
+	NumericRPGActionLevel(int l, int p) {
+		level = l;
+		prev = p;
+	}
 };
 
-// Numeric relaxed planning graph
+// Numeric relaxed planning graph. It is created once and reused in every evaluation: the
+// data is stored in flat arrays, whose entries are only valid if their stamp matches the
+// current evaluation, so the graph is cleared without visiting all the (variable, value) pairs
 class NumericRPG : public FluentIntervalData {
 private:
 	std::shared_ptr<SASTask> task;
+	unsigned int epoch;									   // Current evaluation
+	unsigned int checkEpoch;							   // Current expansion level (to check actions and numeric variables once per level)
 	std::vector<std::shared_ptr<SASAction>> remainingGoals;
-	std::vector< std::vector<NumericRPGproducers> > numVarProducers; // For each numeric variable, the actions that updated its value interval
+	std::vector<NumericRPGproducers> numVarProducers;	   // Changes of the value intervals of the numeric variables
+	std::vector<int> lastNumVarProducer;				   // For each numeric variable, its last entry in numVarProducers
+	std::vector<unsigned int> numVarStamp;
 	std::vector<TInterval> numVarValue;					   // Last value interval for each variable
-	std::vector< std::vector<int> > actionLevel;		   // Levels where the action appears
-	std::vector< std::vector<int> > literalLevel;		   // Level of each pair (variable, value)
+	std::vector<NumericRPGActionLevel> actionLevel;		   // Levels where the actions appear
+	std::vector<int> lastActionLevel;					   // For each action, its last entry in actionLevel
+	std::vector<unsigned int> actionStamp;
+	std::vector<unsigned int> checkedActions;			   // Actions checked in the current level (checkEpoch)
+	std::vector<int> literalLevel;						   // Level of each pair (variable, value), indexed by task->getVarValueIndex
+	std::vector<unsigned int> literalStamp;
 	std::vector<NumericRPGEffect> nextLevel;
 	std::vector<TVarValue> reachedValues;
-	std::unordered_set<TVariable> reachedNumValues;
+	std::vector<TVariable> reachedNumValues;
+	std::vector<unsigned int> reachedNumStamp;			   // Numeric variables reached in the current level (checkEpoch)
 	std::vector<int> goalLevel;
-	PriorityQueue openConditions;
+	std::vector<unsigned int> goalStamp;
+	ValuePriorityQueue<NumericRPGCondition> openConditions;
+	std::vector<NumericRPGCondition> numCond;
 	std::vector<std::shared_ptr<SASAction>> achievedNumericActions;
-	std::unordered_set<TVarValue> numericSubgoals;
+	std::vector<float> linearBounds;					   // Bounds of the numeric variables for the batched evaluation of linear conditions
+	std::vector<uint8_t> linearRowHolds;
+	std::vector<uint8_t> linearActionHolds;				   // For each batched action or goal, true if its start numeric conditions hold
 	int limit;
 
-	void initialize();
+	void reset();
+	void build(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit);
+	inline int getLiteralLevel(TVariable var, TValue value) {
+		unsigned int i = task->getVarValueIndex(var, value);
+		return literalStamp[i] == epoch ? literalLevel[i] : MAX_INT32;
+	}
+	inline void setLiteralLevel(TVariable var, TValue value, int level) {
+		unsigned int i = task->getVarValueIndex(var, value);
+		literalStamp[i] = epoch;
+		literalLevel[i] = level;
+	}
+	inline bool inGraph(std::shared_ptr<SASAction> a) {
+		return actionStamp[a->index] == epoch;
+	}
+	inline int getGoalLevel(std::shared_ptr<SASAction> g) {
+		return goalStamp[g->index] == epoch ? goalLevel[g->index] : MAX_INT32;
+	}
+	void addActionLevel(std::shared_ptr<SASAction> a, int level);
 	void createFirstFluentLevel(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions);
 	void updateNumericValueInterval(int var, float minValue, float maxValue);
+	void evaluateLinearConditions();
 	void createFirstActionLevel();
 	bool isApplicable(std::shared_ptr<SASAction> a, int level);
 	void programActionEffects(std::shared_ptr<SASAction> a, int level);
@@ -112,23 +166,24 @@ private:
 	bool updateNumericValues(int level);
 	void checkAction(std::shared_ptr<SASAction> a, int level);
 	bool checkGoal(std::shared_ptr<SASAction> a, int level);
-	void addSubgoals(std::shared_ptr<SASAction> a, int level, std::shared_ptr<NumericRPGCondition> cp);
+	void addSubgoals(std::shared_ptr<SASAction> a, int level, NumericRPGCondition* cp);
 	void addSubgoal(SASCondition* c);
-	void addSubgoal(std::shared_ptr<SASAction> a, SASNumericCondition* c, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond);
+	void addSubgoal(std::shared_ptr<SASAction> a, SASNumericCondition* c, int level);
 	std::shared_ptr<SASAction> searchBestAction(TVariable v, TValue value, int level, int* actionLevel);
 	int findLevel(int actionIndex, int maxLevel);
 	int findMinNumVarLevel(TVariable v, int maxLevel);
 	int findMaxNumVarLevel(TVariable v, int maxLevel);
-	void addMinValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond);
-	void addMaxValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond);
-	void addNumericSubgoal(TVariable v, int level, bool max, std::vector<std::shared_ptr<NumericRPGCondition>>* numCond);
-  std::shared_ptr<bool[]> calculateCondEffHold(std::shared_ptr<SASAction> a, int level, IntervalCalculations& ic);
+	void addMinValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level);
+	void addMaxValueSubgoal(std::shared_ptr<SASAction> a, SASNumericExpression* e, int level);
+	void addNumericSubgoal(int entry, bool max);
+	std::shared_ptr<bool[]> calculateCondEffHold(std::shared_ptr<SASAction> a, int level, IntervalCalculations& ic);
 	bool checkCondEffectHold(SASConditionalEffect& e, int level, IntervalCalculations& ic);
 
 public:
-	NumericRPG(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, std::shared_ptr<SASTask> task, int limit);
-	int evaluate();
-	int evaluateInitialPlan(/*bool* usefulActions*/);
+	NumericRPG();
+	void initialize(std::shared_ptr<SASTask> task);
+	int evaluate(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit);
+	int evaluateInitialPlan(std::shared_ptr<TState> fs, std::vector<std::shared_ptr<SASAction>>* tilActions, int limit);
 	TFloatValue getMinValue(TVariable v, int numState);
 	TFloatValue getMaxValue(TVariable v, int numState);
 };
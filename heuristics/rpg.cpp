@@ -71,13 +71,13 @@ void RPG::expand() {
 #ifdef DEBUG_RPG_ON
 			cout << "(" << task->variables[var].name << "," << task->values[value].name << ")" << endl;
 #endif
-			vector<std::shared_ptr<SASAction>>& actions = task->requirers[var][value];
+			std::span<const uint32_t> actions = task->getRequirers(var, value);
 #ifdef DEBUG_RPG_ON
 			cout << actions.size() << " actions" << endl;
 #endif
-			for (unsigned int j = 0; j < actions.size(); j++) {
-				std::shared_ptr<SASAction> a = actions[j];
-				if (actionLevels[a->index] == MAX_INT32 && isExecutable(a)) {
+			for (uint32_t index : actions) {
+				std::shared_ptr<SASAction>& a = task->actions[index];
+				if (actionLevels[index] == MAX_INT32 && isExecutable(a)) {
 #ifdef DEBUG_RPG_ON
 					cout << "[" << numLevels << "] " << a->name << endl;
 #endif
@@ -107,29 +107,20 @@ void RPG::expand() {
 }
 
 bool RPG::isExecutable(std::shared_ptr<SASAction> a) {
-	for (unsigned int i = 0; i < a->startCond.size(); i++) {
-		if (literalLevels[a->startCond[i].var][a->startCond[i].value] == MAX_INT32)
+	const SASActionTable& table = *task->actionTable;
+	unsigned int index = table.getIndex(*a);
+	std::span<const TVarValue> cond = forceAtEndConditions ? table.getAllConditions(index) : table.getStartOverConditions(index);
+	for (TVarValue c : cond) {
+		if (literalLevels[SASTask::getVariableIndex(c)][SASTask::getValueIndex(c)] == MAX_INT32)
 			return false;
 	}
-	for (unsigned int i = 0; i < a->overCond.size(); i++) {
-		if (literalLevels[a->overCond[i].var][a->overCond[i].value] == MAX_INT32)
-			return false;
-	}
-	if (forceAtEndConditions) {
-		for (unsigned int i = 0; i < a->endCond.size(); i++) {
-			if (literalLevels[a->endCond[i].var][a->endCond[i].value] == MAX_INT32)
-				return false;
-		}
-	}
 	return true;
 }
 
 void RPG::addEffects(std::shared_ptr<SASAction> a) {
-	for (unsigned int i = 0; i < a->startEff.size(); i++) {
-		addEffect(a->startEff[i].var, a->startEff[i].value);
-	}
-	for (unsigned int i = 0; i < a->endEff.size(); i++) {
-		addEffect(a->endEff[i].var, a->endEff[i].value);
+	const SASActionTable& table = *task->actionTable;
+	for (TVarValue e : table.getAllEffects(table.getIndex(*a))) {
+		addEffect(SASTask::getVariableIndex(e), SASTask::getValueIndex(e));
 	}
 }
 
@@ -183,11 +174,10 @@ uint16_t RPG::computeHeuristic(bool mutex, PriorityQueue* openConditions) {
 		if (gLevel == MAX_INT32) return MAX_UINT16;
 		literalLevels[g->var][g->value] = -gLevel;
 		reachedValues.push_back(SASTask::getVariableValueCode(g->var, g->value));
-		vector<std::shared_ptr<SASAction>>& prod = task->producers[g->var][g->value];
 		std::shared_ptr<SASAction> bestAction = nullptr;
 		bestCost = MAX_UINT16;
-		for (unsigned int i = 0; i < prod.size(); i++) {
-			std::shared_ptr<SASAction> a = prod[i];
+		for (uint32_t index : task->getProducers(g->var, g->value)) {
+			std::shared_ptr<SASAction>& a = task->actions[index];
 #ifdef DEBUG_RPG_ON
 			cout << a->name << ", dif. " << getDifficulty(a) << endl;
 #endif			
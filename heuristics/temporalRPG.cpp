@@ -57,12 +57,12 @@ void TemporalRPG::build(std::shared_ptr<TState> state) {
 	float auxLevel;
 	while (qPNormal.size() > 0) {
 		std::shared_ptr<FluentLevel> fl = std::dynamic_pointer_cast<FluentLevel>(qPNormal.poll());
-		std::vector<std::shared_ptr<SASAction>>& req = task->requirers[fl->variable][fl->value];
+		std::span<const uint32_t> req = task->getRequirers(fl->variable, fl->value);
 #ifdef DEBUG_TEMPORALRPG_ON
 		cout << "EXTR.: " << fl->toString(task) << ", " << req.size() << " requirers" << endl;
 #endif
-		for (unsigned int i = 0; i < req.size(); i++) {
-			std::shared_ptr<SASAction> a = req[i];
+		for (uint32_t index : req) {
+			std::shared_ptr<SASAction>& a = task->actions[index];
 			if (visitedAction[a->index] == 0) {
 				if (verifyFluent && actionProducesFluent(a)) visitedAction[a->index] = 1;
 				else {
@@ -4,7 +4,8 @@
 #include "grounder/grounder.h"
 #include "sas/sasTranslator.h"
 #include "planner/plannerSetting.h"
-#include "planner/z3Checker.h"
+#include "planner/lpChecker.h"
+#include "planner/planOptimizer.h"
 #include "planner/printPlan.h"
 #include "parser/parser.h"
 
@@ -27,43 +28,73 @@ struct PlannerParameters {
     bool keepStaticData;
     bool noSAS;
     bool generateMutexFile;
+    unsigned int z3Timeout;
+    char* z3Logic;
     clock_t startTime;
     PlannerParameters() :
         total_time(0), domainFileName(nullptr), problemFileName(nullptr), generateGroundedDomain(false),
-        keepStaticData(false), noSAS(false), generateMutexFile(false), startTime(clock()) {
+        keepStaticData(false), noSAS(false), generateMutexFile(false), z3Timeout(0), z3Logic(nullptr), startTime(clock()) {
     }
 };
 
 // Prints the command-line arguments of the planner
 void printUsage() {
-    cout << "Usage: NextFLAP <domain_file> <problem_file> [-ground] [-static] [-mutex]" << endl;
+    cout << "Usage: NextFLAP <domain_file> <problem_file> [-ground] [-static] [-mutex] [-z3timeout <ms>] [-z3logic <logic>]" << endl;
     cout << " -ground: generates the GroundedDomain.pddl and GroundedProblem.pddl files." << endl;
     cout << " -static: keeps the static data in the planning task." << endl;
     cout << " -nsas: does not make translation to SAS (finite-domain variables)." << endl;
     cout << " -mutex: generates the mutex.txt file with the list of static mutex facts." << endl;
+    cout << " -z3timeout: time limit (in milliseconds) for each Z3 check." << endl;
+    cout << " -z3logic: Z3 solver logic (e.g. QF_LRA, QF_LIA). By default, it depends on the plan constraints." << endl;
+}
+
+// Resident memory and peak resident memory of the process at the start of a stage
+struct StageMemory {
+    size_t resident;
+    size_t peak;
+    StageMemory() : resident(getCurrentMemoryKB()), peak(getPeakMemoryKB()) {
+    }
+};
+
+// Prints the resident memory of the process at the end of a stage, and its change since the
+// start of the stage (negative if the stage released more than it allocated). The peak is the
+// high-water mark of the process, so the stage only raised it by the printed increase, which
+// includes the temporary allocations released before the end of the stage
+void printStageMemory(const char* stage, const StageMemory& start) {
+    size_t memory = getCurrentMemoryKB(), peak = getPeakMemoryKB();
+    if (memory > 0)
+        cout << ";" << stage << " memory: " << (memory / 1024.0f) << " MB (" << showpos
+            << (((long)memory - (long)start.resident) / 1024.0f) << noshowpos << " MB)" << endl;
+    if (peak > 0)
+        cout << ";" << stage << " peak memory: " << (peak / 1024.0f) << " MB (" << showpos
+            << ((peak - start.peak) / 1024.0f) << noshowpos << " MB)" << endl;
 }
 
 // Parses the domain and problem files
 void parseStage(PlannerParameters* parameters, std::unique_ptr<ParsedTask> &parsedTask) {
     clock_t t = clock();
+    StageMemory memory;
     Parser parser;
     parser.parseDomain(parameters->domainFileName);
     parser.parseProblem(parameters->problemFileName, parsedTask);
     float time = toSeconds(t);
     parameters->total_time += time;
     cout << ";Parsing time: " << time << endl;
+    printStageMemory("Parsing", memory);
     return;
 }
 
 // Preprocesses the parsed task
 void preprocessStage(std::unique_ptr<ParsedTask> & parsedTask, PlannerParameters* parameters, std::unique_ptr<PreprocessedTask> &prepTask) {
     clock_t t = clock();
+    StageMemory memory;
     Preprocess preprocess(parsedTask);
     preprocess.preprocessTask(prepTask);
     float time = toSeconds(t);
     parameters->total_time += time;
     //cout << prepTask->toString() << endl;
     cout << ";Preprocessing time: " << time << endl;
+    printStageMemory("Preprocessing", memory);
     return;
 }
 
@@ -71,12 +102,21 @@ void preprocessStage(std::unique_ptr<ParsedTask> & parsedTask, PlannerParameters
 void groundingStage(std::unique_ptr<PreprocessedTask> & prepTask,
     PlannerParameters* parameters, std::unique_ptr<GroundedTask> &gTask) {
     clock_t t = clock();
+    StageMemory memory;
     Grounder grounder(prepTask);
     grounder.groundTask(parameters->keepStaticData, gTask);
     float time = toSeconds(t);
     parameters->total_time += time;
     //cout << gTask->toString() << endl;
     cout << ";Grounding time: " << time << endl;
+    printStageMemory("Grounding", memory);
+    if (grounder.getNumGroundedActions() > 0) {
+        cout << ";Irrelevant actions removed: " << grounder.getNumIrrelevantActions() << " of " << grounder.getNumGroundedActions()
+            << " (" << (100.0 * grounder.getNumIrrelevantActions() / grounder.getNumGroundedActions()) << "%)" << endl;
+    }
+    if (grounder.getNumDuplicateActions() + grounder.getNumDominatedActions() > 0)
+        cout << ";Redundant actions removed: " << grounder.getNumDuplicateActions() << " duplicate, "
+            << grounder.getNumDominatedActions() << " dominated" << endl;
     if (parameters->generateGroundedDomain) {
         cout << ";" << gTask->actions.size() << " grounded actions" << endl;
         gTask->writePDDLDomain();
@@ -88,12 +128,14 @@ void groundingStage(std::unique_ptr<PreprocessedTask> & prepTask,
 // SAS translation stage
 void sasTranslationStage(std::unique_ptr<GroundedTask> &gTask, PlannerParameters* parameters, std::shared_ptr<SASTask> sTask) {
     clock_t t = clock();
+    StageMemory memory;
     SASTranslator translator;
     translator.translate(gTask, parameters->noSAS,
         parameters->generateMutexFile, parameters->keepStaticData, sTask);
     float time = toSeconds(t);
     parameters->total_time += time;
     cout << ";SAS translation time: " << time << endl;
+    printStageMemory("SAS translation", memory);
     //cout << sasTask->toString() << endl;
     /*for (SASAction& a : sasTask->actions) {
         cout << sasTask->toStringAction(a) << endl;
@@ -112,14 +154,16 @@ void doPreprocess(PlannerParameters* parameters, std::unique_ptr<GroundedTask> &
         preprocessStage(parsedTask, parameters, prepTask);
         if (prepTask != nullptr) {
            groundingStage(prepTask, parameters, gTask);
+           prepTask = nullptr;                     // The grounded task only refers to the parsed task
             if (gTask != nullptr) {
                 //cout << gTask->toString() << endl;
-                sasTranslationStage(gTask, parameters, sTask);
-                // delete gTask;
+                sasTranslationStage(gTask, parameters, sTask);  // The translator releases the grounded task
             }
-            // delete prepTask;
         }
     }
+    size_t peak = getPeakMemoryKB();
+    if (peak > 0)
+        cout << ";Peak memory: " << (peak / 1024.0f) << " MB" << endl;
     return;
 }
 
@@ -131,6 +175,9 @@ void startPlanning(PlannerParameters* parameters) {
     if (sTask == nullptr)
         return;
     clock_t t = clock();
+    Z3Checker::settings.timeout = parameters->z3Timeout;
+    if (parameters->z3Logic != nullptr)
+        Z3Checker::settings.logic = parameters->z3Logic;
     PlannerSetting planner(sTask);
     std::shared_ptr<Plan> solution;
     float bestMakespan = FLOAT_INFINITY;
@@ -140,11 +187,21 @@ void startPlanning(PlannerParameters* parameters) {
         float time = toSeconds(t);
         if (solution != nullptr) {
             //cout << ";Checking solution" << endl;
-            Z3Checker checker;
+            PlanScheduler scheduler;
+            PlanOptimizer optimizer(sTask);
+            LPChecker checker;
             TControVarValues cvarValues;
             float solutionMakespan;
+            bool scheduled;
 
-            if (checker.checkPlan(solution, OPTIMIZE_MAKESPAN, &cvarValues)) {
+            // The solution has been validated during the search. The solver is only used
+            // when the earliest-start schedule is not applicable (time-dependent numeric values)
+            if (scheduler.schedule(solution)) {
+                solution = optimizer.optimize(solution);
+                scheduled = true;
+            }
+            else scheduled = checker.checkPlan(solution, OPTIMIZE_MAKESPAN, &cvarValues);
+            if (scheduled) {
                 solutionMakespan = PrintPlan::getMakespan(solution);
                 if (solutionMakespan < bestMakespan ||
                     (abs(solutionMakespan - bestMakespan) < EPSILON && solution->g < bestNumSteps)) {
@@ -152,11 +209,17 @@ void startPlanning(PlannerParameters* parameters) {
                     bestMakespan = solutionMakespan;
                     bestNumSteps = solution->g;
                     cout << ";Solution found in " << time << endl;
+                    if (optimizer.removedSteps > 0)
+                        cout << ";Post-optimization: " << optimizer.removedSteps << " redundant steps removed" << endl;
                     break;
                 }
             }
         }
     } while (solution != nullptr);
+    if (Z3Checker::stats.numChecks > 0)
+        Z3Checker::stats.print();
+    if (HeuristicCache::stats.lookups > 0)
+        HeuristicCache::stats.print();
 }
 
 // Main method
@@ -187,6 +250,10 @@ int main(int argc, char* argv[]) {
                     parameters.noSAS = true;
                 else if (compareStr(argv[param], "-mutex"))
                     parameters.generateMutexFile = true;
+                else if (compareStr(argv[param], "-z3timeout") && param + 1 < argc)
+                    parameters.z3Timeout = (unsigned int)atoi(argv[++param]);
+                else if (compareStr(argv[param], "-z3logic") && param + 1 < argc)
+                    parameters.z3Logic = argv[++param];
                 else {
                     parameters.domainFileName = nullptr;
                     break;
@@ -12,7 +12,10 @@ using namespace std;
 // Evaluates the value [min, max] of a numeric expression
 void IntervalCalculations::evaluateExpression(SASNumericExpression* e, TFloatValue* min, TFloatValue* max)
 {
-	if (e->type == 'N') {		// Constant number
+	if (e->codeLength > 0) {	// Compiled expression
+		code->evaluate(e, fluentValues.data(), cvarValues.data(), duration, min, max);
+	}
+	else if (e->type == 'N') {		// Constant number
 		*min = e->value;
 		*max = e->value;
 	}
@@ -143,6 +146,7 @@ bool IntervalCalculations::supportedCondition(SASNumericCondition* c)
 IntervalCalculations::IntervalCalculations(std::shared_ptr<SASAction> a, int numState, FluentIntervalData* fluentData, std::shared_ptr<SASTask> task)
 {
 	this->a = a;
+	this->code = task->expressionCode.get();
 	fluentValues.resize(task->numVariables.size());
 	for (TVariable v = 0; v < fluentValues.size(); v++) {
 		fluentValues[v].minValue = fluentData->getMinValue(v, numState);
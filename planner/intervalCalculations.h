@@ -31,6 +31,7 @@ public:
 class IntervalCalculations {
 private:
     std::shared_ptr<SASAction> a;
+    const SASExpressionCode* code;
     std::vector<TInterval> fluentValues;
     TInterval duration;
     std::vector<TInterval> cvarValues;
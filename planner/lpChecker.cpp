@@ -0,0 +1,389 @@
+#include "lpChecker.h"
+
+/********************************************************/
+/* Plan validity checking through a built-in simplex    */
+/* solver. Used when all the numeric constraints of the */
+/* plan are linear; otherwise, Z3 is called.            */
+/********************************************************/
+
+// The model is equivalent to the one in Z3Checker, but times are expressed in
+// seconds. Orderings keep a margin of one millisecond, as the integer times in Z3.
+// The slack of the strict numeric comparisons must be at least the strictness
+// column, which is maximized: they hold if it can be positive. Infeasible models
+// are therefore rejected without calling Z3, which is only used for nonlinear
+// plans, integer control variables or numerical problems. If the plan extends the last checked one, only the
+// new steps are added to the model.
+
+#define LP_STRICT_TOL	(10 * SIMPLEX_FEAS_TOL)	// Smaller strictness values cannot be told from zero
+
+using namespace std;
+
+// Adds factor * e to this expression
+void LPExpression::add(const LPExpression& e, double factor)
+{
+	constant += e.constant * factor;
+	for (const pair<unsigned int, double>& t : e.terms)
+		terms.emplace_back(t.first, t.second * factor);
+}
+
+// Checks the plan. If optimizeMakespan is true, the plan end time is minimized
+bool LPChecker::checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TControVarValues* cvarValues)
+{
+	planComponents.calculate(p);
+	TStep numSteps = (TStep)planComponents.size(), firstStep = (TStep)stepVars.size();
+	std::shared_ptr<Plan> last = lastPlan.lock();
+	if (last == nullptr || firstStep == 0 || firstStep > numSteps || planComponents.get(firstStep - 1) != last) {
+		clearModel();
+		firstStep = 0;
+		strictness = lp.addVariable(0, EPSILON);
+	}
+	for (TStep s = firstStep; s < numSteps; s++) {
+		defineVariables(planComponents.get(s), s);
+	}
+	bool linear = true;
+	for (TStep s = firstStep; s < numSteps && linear; s++) {
+		linear = defineConstraints(planComponents.get(s), s);
+	}
+	char res = SIMPLEX_LIMIT;
+	if (linear) {
+		defineOrderings(firstStep);
+		res = solve(numSteps, optimizeMakespan);
+	}
+	if (res == SIMPLEX_INFEASIBLE) return false;
+	if (res != SIMPLEX_OPTIMAL) {	// Nonlinear constraints or numerical problems
+		clearModel();
+		Z3Checker checker;
+		return checker.checkPlan(p, optimizeMakespan, cvarValues);
+	}
+	lastPlan = p;
+	updatePlan(p, cvarValues);
+	return true;
+}
+
+// Solves the model. If there are strict comparisons, the strictness is maximized first,
+// and then kept positive while the makespan is minimized
+char LPChecker::solve(TStep numSteps, bool optimizeMakespan)
+{
+	TLinearTerms objective;
+	if (strictRows) {
+		objective.emplace_back(strictness, -1);
+		lp.setObjective(objective);
+		char res = lp.solve();
+		if (res != SIMPLEX_OPTIMAL) return res;
+		if (lp.getValue(strictness) <= LP_STRICT_TOL) return SIMPLEX_INFEASIBLE;
+		if (!optimizeMakespan) return res;
+		lp.addRow({ {strictness, 1} }, LP_STRICT_TOL, SIMPLEX_INFINITY);
+		objective.clear();
+	}
+	if (optimizeMakespan)
+		objective.emplace_back(getPointVar(stepToEndPoint(numSteps - 1)), 1);
+	lp.setObjective(objective);
+	return lp.solve();
+}
+
+// Removes the current model
+void LPChecker::clearModel()
+{
+	lp.clear();
+	strictRows = false;
+	stepVars.clear();
+	nextPoints.clear();
+	prevPoints.clear();
+	lastPlan.reset();
+}
+
+// Defines the LP columns for the given step
+void LPChecker::defineVariables(std::shared_ptr<Plan> p, TStep s)
+{
+	stepVars.emplace_back();
+	LPStepVariables& vars = stepVars.back();
+	vars.duration = lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY);
+	if (p->action->isTIL)
+		vars.startTime = lp.addVariable(0, 0);
+	else if (s == 0)
+		vars.startTime = lp.addVariable(-EPSILON, -EPSILON);
+	else
+		vars.startTime = lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY);
+	vars.endTime = lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY);
+	if (p->cvarValues != nullptr) {
+		for (unsigned int cv = 0; cv < p->cvarValues->size(); cv++)
+			vars.controlVars.push_back(lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY));
+	}
+	if (p->startPoint.numVarValues != nullptr) {
+		for (TFluentInterval& i : *(p->startPoint.numVarValues))
+			vars.startFluent[i.numVar] = lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY);
+	}
+	if (p->endPoint.numVarValues != nullptr) {
+		for (TFluentInterval& i : *(p->endPoint.numVarValues))
+			vars.endFluent[i.numVar] = lp.addVariable(-SIMPLEX_INFINITY, SIMPLEX_INFINITY);
+	}
+}
+
+// Defines the constraints of the given step, except the orderings. Returns false
+// if a nonlinear constraint or an integer control variable is found
+bool LPChecker::defineConstraints(std::shared_ptr<Plan> p, TStep s)
+{
+	std::shared_ptr<SASAction> a = p->action;
+	TTimePoint start = stepToStartPoint(s), end = stepToEndPoint(s);
+
+	if (p->cvarValues != nullptr) {			// The LP columns are continuous
+		for (unsigned int cv = 0; cv < p->cvarValues->size(); cv++) {
+			if (a->controlVars[cv].type == 'I') return false;
+		}
+	}
+
+	for (SASNumericCondition& c : a->startNumCond) {    // Fluents and control vars. conditions
+		if (!defineNumericContraint(c, start)) return false;
+	}
+	for (SASNumericCondition& c : a->overNumCond) {
+		if (!defineNumericContraint(c, start) || !defineNumericContraint(c, end)) return false;
+	}
+	for (SASNumericCondition& c : a->endNumCond) {
+		if (!defineNumericContraint(c, end)) return false;
+	}
+	for (SASControlVar& cv : a->controlVars) {
+		for (SASControlVarCondition& c : cv.conditions) {
+			if (!c.inActionPrec && !defineNumericContraint(c.condition, start)) return false;
+		}
+	}
+	if (p->holdCondEff != nullptr) {
+		for (unsigned int numEff : *p->holdCondEff) {
+			SASConditionalEffect& e = a->conditionalEff[numEff];
+			for (SASNumericCondition& c : e.startNumCond) {
+				if (!defineNumericContraint(c, start)) return false;
+			}
+			for (SASNumericCondition& c : e.endNumCond) {
+				if (!defineNumericContraint(c, end)) return false;
+			}
+			for (SASNumericEffect& c : e.startNumEff) {
+				if (!defineNumericEffect(c, start)) return false;
+			}
+			for (SASNumericEffect& c : e.endNumEff) {
+				if (!defineNumericEffect(c, end)) return false;
+			}
+		}
+	}
+	for (SASNumericEffect& e : a->startNumEff) {
+		if (!defineNumericEffect(e, start)) return false;
+	}
+	for (SASNumericEffect& e : a->endNumEff) {
+		if (!defineNumericEffect(e, end)) return false;
+	}
+	for (SASDurationCondition& d : a->duration.conditions) {    // Action duration
+		if (!defineDurationConstraint(d, s)) return false;
+	}
+	if (!a->duration.conditions.empty()) {	// end - start - duration = 0
+		LPStepVariables& vars = stepVars[s];
+		lp.addRow({ {vars.endTime, 1}, {vars.startTime, -1}, {vars.duration, -1} }, 0, 0);
+	}
+	return true;
+}
+
+// Adds the orderings of the steps from firstStep. Orderings implied by
+// other two orderings are skipped, as the plan orderings are transitively closed
+void LPChecker::defineOrderings(TStep firstStep)
+{
+	unsigned int numPoints = (unsigned int)stepVars.size() * 2, numWords = (numPoints + 63) >> 6;
+	nextPoints.resize(numPoints);
+	prevPoints.resize(numPoints);
+	for (unsigned int i = 0; i < numPoints; i++) {
+		nextPoints[i].resize(numWords, 0);
+		prevPoints[i].resize(numWords, 0);
+	}
+	std::vector<TOrdering> newOrderings;
+	for (TStep s = firstStep; s < stepVars.size(); s++) {
+		for (TOrdering o : planComponents.get(s)->orderings) {
+			TTimePoint tp1 = firstPoint(o), tp2 = secondPoint(o);
+			if (tp1 + 1 != tp2 || (tp1 & 1) == 1) {
+				nextPoints[tp1][tp2 >> 6] |= 1ULL << (tp2 & 63);
+				prevPoints[tp2][tp1 >> 6] |= 1ULL << (tp1 & 63);
+				newOrderings.push_back(o);
+			}
+		}
+	}
+	for (TOrdering o : newOrderings) {
+		TTimePoint tp1 = firstPoint(o), tp2 = secondPoint(o);
+		bool implied = false;
+		for (unsigned int w = 0; w < numWords && !implied; w++)
+			implied = (nextPoints[tp1][w] & prevPoints[tp2][w]) != 0;
+		if (!implied)
+			lp.addRow({ {getPointVar(tp2), 1}, {getPointVar(tp1), -1} }, EPSILON, SIMPLEX_INFINITY);
+	}
+}
+
+// Returns the column of a time point
+unsigned int LPChecker::getPointVar(TTimePoint tp)
+{
+	LPStepVariables& vars = stepVars[timePointToStep(tp)];
+	return (tp & 1) == 0 ? vars.startTime : vars.endTime;
+}
+
+// Returns the column of the fluent that supports the given variable in a time point
+unsigned int LPChecker::getProductorVar(TVariable var, TTimePoint tp)
+{
+	TStep s = timePointToStep(tp);
+	std::shared_ptr<Plan> p = planComponents.get(s);
+	unsigned int col = 0;
+	if ((tp & 1) == 1) { // End point
+		for (TNumericCausalLink& cl : p->endPoint.numCausalLinks) {
+			if (cl.var == var && getFluent(cl.var, cl.timePoint, &col)) return col;
+		}
+	}
+	for (TNumericCausalLink& cl : p->startPoint.numCausalLinks) {
+		if (cl.var == var && getFluent(cl.var, cl.timePoint, &col)) return col;
+	}
+	for (TNumericCausalLink& cl : p->endPoint.numCausalLinks) {
+		if (cl.var == var && getFluent(cl.var, cl.timePoint, &col)) return col;
+	}
+	throwError("Error: numeric causal link not defined for fluent " + std::to_string(var) + " in timepoint " +
+		std::to_string(tp) + "(action " + p->action->name + ")");
+	return col;
+}
+
+// Gets the column of a fluent in a time point. Returns false if it has not been defined
+bool LPChecker::getFluent(TVariable var, TTimePoint tp, unsigned int* col)
+{
+	LPStepVariables& vars = stepVars[timePointToStep(tp)];
+	std::unordered_map<TVariable, unsigned int>& fluents = (tp & 1) == 0 ? vars.startFluent : vars.endFluent;
+	auto it = fluents.find(var);
+	if (it == fluents.end()) return false;
+	*col = it->second;
+	return true;
+}
+
+// Builds a linear expression. Returns false if the expression is not linear
+bool LPChecker::getNumericExpression(SASNumericExpression& e, TTimePoint tp, LPExpression& res)
+{
+	switch (e.type) {
+	case 'N':   // GE_NUMBER (rounded as in Z3Checker)
+		res.constant += (int)(e.value * 1000) / 1000.0;
+		return true;
+	case 'V':   // GE_VAR
+		res.terms.emplace_back(getProductorVar(e.var, tp), 1);
+		return true;
+	case 'D': // GE_DURATION
+		res.terms.emplace_back(stepVars[timePointToStep(tp)].duration, 1);
+		return true;
+	case 'C': // GE_CONTROL_VAR
+		res.terms.emplace_back(stepVars[timePointToStep(tp)].controlVars[e.var], 1);
+		return true;
+	case '+':
+	case '-':
+	case '*':
+	case '/': {
+		LPExpression left, right;
+		if (!getNumericExpression(e.terms[0], tp, left) || !getNumericExpression(e.terms[1], tp, right))
+			return false;
+		if (e.type == '+' || e.type == '-') {
+			res.add(left, 1);
+			res.add(right, e.type == '+' ? 1 : -1);
+		}
+		else if (e.type == '*' && left.terms.empty()) res.add(right, left.constant);
+		else if (right.terms.empty() && (e.type == '*' || right.constant != 0))
+			res.add(left, e.type == '*' ? right.constant : 1 / right.constant);
+		else return false;
+		return true;
+	}
+	}
+	return false;
+}
+
+// Adds the constraint (e comp 0) to the model
+bool LPChecker::addConstraint(LPExpression& e, char comp)
+{
+	double lo = -SIMPLEX_INFINITY, hi = SIMPLEX_INFINITY;
+	switch (comp) {
+	case '=': lo = hi = 0;			break;
+	case '<': hi = 0;				break;
+	case 'L': hi = 0;				break;
+	case '>': lo = 0;				break;
+	case 'G': lo = 0;				break;
+	case 'N': return false;			// Disjunctive constraint
+	default:  return true;			// Dummy comparator
+	}
+	if (comp == '<' || comp == '>') {	// e + strictness <= 0 or e - strictness >= 0
+		e.terms.emplace_back(strictness, comp == '<' ? 1 : -1);
+		strictRows = true;
+	}
+	if (lo > -SIMPLEX_INFINITY) lo -= e.constant;
+	if (hi < SIMPLEX_INFINITY) hi -= e.constant;
+	lp.addRow(e.terms, lo, hi);
+	return true;
+}
+
+// Defines a numeric condition in a time point
+bool LPChecker::defineNumericContraint(SASNumericCondition& prec, TTimePoint tp)
+{
+	if (prec.comp == '-') return true;
+	LPExpression e;
+	if (!getNumericExpression(prec.terms[0], tp, e)) return false;
+	LPExpression right;
+	if (!getNumericExpression(prec.terms[1], tp, right)) return false;
+	e.add(right, -1);
+	return addConstraint(e, prec.comp);
+}
+
+// Defines a duration constraint
+bool LPChecker::defineDurationConstraint(SASDurationCondition& d, TStep s)
+{
+	TTimePoint tp = d.time != 'E' ? stepToStartPoint(s) : stepToEndPoint(s);
+	LPExpression e;
+	e.terms.emplace_back(stepVars[s].duration, 1);
+	LPExpression right;
+	if (!getNumericExpression(d.exp, tp, right)) return false;
+	e.add(right, -1);
+	return addConstraint(e, d.comp);
+}
+
+// Defines a numeric effect in a time point
+bool LPChecker::defineNumericEffect(SASNumericEffect& e, TTimePoint tp)
+{
+	unsigned int col;
+	LPExpression exp, res;
+	if (!getFluent(e.var, tp, &col) || !getNumericExpression(e.exp, tp, exp)) return false;
+	res.terms.emplace_back(col, 1);
+	switch (e.op) {
+	case '=':
+		res.add(exp, -1);
+		break;
+	case '+':
+	case '-':
+		res.terms.emplace_back(getProductorVar(e.var, tp), -1);
+		res.add(exp, e.op == '+' ? -1 : 1);
+		break;
+	case '*':
+	case '/':
+		if (!exp.terms.empty() || (e.op == '/' && exp.constant == 0)) return false;
+		res.terms.emplace_back(getProductorVar(e.var, tp), e.op == '*' ? -exp.constant : -1 / exp.constant);
+		break;
+	}
+	return addConstraint(res, '=');
+}
+
+// Updates the plan times with the values found by the solver
+void LPChecker::updatePlan(std::shared_ptr<Plan> p, TControVarValues* cvarValues)
+{
+	for (TStep s = 0; s < planComponents.size(); s++) {
+		TTimePoint startPoint = stepToStartPoint(s), endPoint = startPoint + 1;
+		TFloatValue startTime = round3d(lp.getValue(stepVars[s].startTime));
+		TFloatValue endTime = round3d(lp.getValue(stepVars[s].endTime));
+		std::shared_ptr<Plan> pc = planComponents.get(s);
+		if (cvarValues != nullptr && pc->cvarValues != nullptr) {
+			std::vector<float> valuesList;
+			for (unsigned int cv = 0; cv < pc->action->controlVars.size(); cv++)
+				valuesList.push_back((float)lp.getValue(stepVars[s].controlVars[cv]));
+			(*cvarValues)[s] = valuesList;
+		}
+		if (p == pc) {
+			p->setTime(startTime, endTime, p->fixedInit);
+		}
+		else {
+			if (abs(startTime - pc->startPoint.updatedTime) > EPSILON / 2) {
+				p->addPlanUpdate(startPoint, startTime);
+			}
+			if (abs(endTime - pc->endPoint.updatedTime) > EPSILON / 2) {
+				p->addPlanUpdate(endPoint, endTime);
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef LP_CHECKER_H
+#define LP_CHECKER_H
+
+#include <vector>
+#include <unordered_map>
+#include "plan.h"
+#include "planComponents.h"
+#include "simplex.h"
+#include "z3Checker.h"
+
+/********************************************************/
+/* Plan validity checking through a built-in simplex    */
+/* solver. Used when all the numeric constraints of the */
+/* plan are linear; otherwise, Z3 is called.            */
+/********************************************************/
+
+class LPStepVariables {
+public:
+	unsigned int duration, startTime, endTime;			// Columns in the LP
+	std::vector<unsigned int> controlVars;				// Control vars
+	std::unordered_map<TVariable, unsigned int> startFluent; // At start numeric vble. -> column
+	std::unordered_map<TVariable, unsigned int> endFluent;	 // At end numeric vble. -> column
+};
+
+class LPExpression {
+public:
+	TLinearTerms terms;
+	double constant;
+	LPExpression() { constant = 0; }
+	LPExpression(double c) { constant = c; }
+	void add(const LPExpression& e, double factor);
+};
+
+class LPChecker {
+private:
+	SimplexSolver lp;
+	PlanComponents planComponents;
+	std::vector<LPStepVariables> stepVars;
+	std::weak_ptr<Plan> lastPlan;								// Last plan modelled in the LP (for warm start)
+	std::vector<std::vector<uint64_t>> nextPoints;			// Orderings included in the model, by rows and columns
+	std::vector<std::vector<uint64_t>> prevPoints;
+	unsigned int strictness;									// Column of the margin of the strict comparisons
+	bool strictRows;											// The model has strict comparisons
+
+	char solve(TStep numSteps, bool optimizeMakespan);
+	void clearModel();
+	void defineVariables(std::shared_ptr<Plan> p, TStep s);
+	bool defineConstraints(std::shared_ptr<Plan> p, TStep s);
+	void defineOrderings(TStep firstStep);
+	unsigned int getPointVar(TTimePoint tp);
+	unsigned int getProductorVar(TVariable var, TTimePoint tp);
+	bool getFluent(TVariable var, TTimePoint tp, unsigned int* col);
+	bool getNumericExpression(SASNumericExpression& e, TTimePoint tp, LPExpression& res);
+	bool addConstraint(LPExpression& e, char comp);
+	bool defineNumericContraint(SASNumericCondition& prec, TTimePoint tp);
+	bool defineDurationConstraint(SASDurationCondition& d, TStep s);
+	bool defineNumericEffect(SASNumericEffect& e, TTimePoint tp);
+	void updatePlan(std::shared_ptr<Plan> p, TControVarValues* cvarValues);
+
+public:
+	LPChecker() { strictness = 0; strictRows = false; }
+	bool checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TControVarValues* cvarValues = nullptr);
+};
+
+#endif
@@ -89,6 +89,7 @@ public:
 	int g;									// Plan length
 	int h;									// Heuristic value
 	int hLand;
+	std::vector<uint64_t> landmarkStatus;	// Checked and open landmarks after the plan (see LandmarkHeuristic)
 	std::shared_ptr<TState> fs;								// Frontier state
 	bool z3Checked;							// Plan checked by z3 solver?
 	bool invalid;							// Invalid plan (after z3 checking)
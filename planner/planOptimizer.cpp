@@ -0,0 +1,450 @@
+#include "planOptimizer.h"
+#include "printPlan.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#define MIN_CANDIDATES_PER_THREAD	16	// Below this, spawning threads costs more than the simulations
+
+/********************************************************/
+/* Post-processing of a scheduled solution plan:        */
+/* removal of redundant steps, relaxation of the        */
+/* orderings and rescheduling.                          */
+/********************************************************/
+
+// A step is redundant if the plan is still valid without it, which is checked by
+// simulating the plan in the current time order. The new orderings only keep, for
+// each variable, the relative order between accesses that do not commute (writes
+// with respect to reads and other writes; increase/decrease effects commute among
+// them). Every condition is then supported by the same effects as in the simulated
+// plan, so any schedule that respects these orderings is valid. The fluents in the
+// duration expressions are also reads, as the scheduled durations depend on them.
+// The optimized plan is checked again with its final schedule, and its causal links
+// are rebuilt from it.
+
+using namespace std;
+
+// Constructor
+PlanOptimizer::PlanOptimizer(std::shared_ptr<SASTask> task)
+{
+	this->task = task;
+	removedSteps = 0;
+}
+
+// Optimizes a solution plan, which must be already scheduled. Returns the same plan
+// if it cannot be improved
+std::shared_ptr<Plan> PlanOptimizer::optimize(std::shared_ptr<Plan> p)
+{
+	removedSteps = 0;
+	planComponents.calculate(p);
+	TStep numSteps = (TStep)planComponents.size();
+	startTimes.resize(numSteps);
+	endTimes.resize(numSteps);
+	std::vector<TStep> candidates;
+	for (TStep s = 0; s < numSteps; s++) {
+		std::shared_ptr<Plan> pc = planComponents.get(s);
+		if (!optimizableStep(pc)) return p;
+		startTimes[s] = pc->startPoint.updatedTime;
+		endTimes[s] = pc->endPoint.updatedTime;
+		if (s > 0 && !pc->action->isTIL && !pc->action->isGoal)
+			candidates.push_back(s);
+	}
+	std::vector<bool> removed(numSteps, false), valid;
+	while (!candidates.empty()) {		// Redundant steps elimination
+		checkCandidates(candidates, removed, valid);
+		std::vector<TStep> validCandidates;
+		for (unsigned int i = 0; i < candidates.size(); i++)
+			if (valid[i]) validCandidates.push_back(candidates[i]);
+		if (validCandidates.empty()) break;
+		removed[validCandidates[0]] = true;			// Removals can interfere, so the rest are checked again
+		removedSteps++;
+		validCandidates.erase(validCandidates.begin());
+		candidates.swap(validCandidates);
+	}
+	std::shared_ptr<Plan> result = buildPlan(removed);		// Orderings relaxation and rescheduling
+	if (result == nullptr || !scheduler.schedule(result) || !validSchedule(result, removed)) {
+		removedSteps = 0;
+		return p;
+	}
+	if (removedSteps == 0 && PrintPlan::getMakespan(result) > PrintPlan::getMakespan(p) - EPSILON / 2) return p;
+	addCausalLinks(removed);
+	return result;
+}
+
+// Checks if the post-optimization can be applied to a step. Conditional effects and
+// control variables are not supported
+bool PlanOptimizer::optimizableStep(std::shared_ptr<Plan> p)
+{
+	return p->action->conditionalEff.empty() && p->action->controlVars.empty() && p->cvarValues == nullptr;
+}
+
+// Checks the removal candidates, in parallel if there are enough of them
+void PlanOptimizer::checkCandidates(std::vector<TStep>& candidates, std::vector<bool>& removed, std::vector<bool>& valid)
+{
+	valid.assign(candidates.size(), false);
+	std::atomic<unsigned int> next(0);
+	std::vector<char> result(candidates.size(), 0);
+	auto worker = [&]() {
+		std::vector<bool> r = removed;
+		unsigned int i;
+		while ((i = next++) < candidates.size()) {
+			r[candidates[i]] = true;
+			result[i] = validPlan(r) ? 1 : 0;
+			r[candidates[i]] = false;
+		}
+	};
+	unsigned int numThreads = std::min((unsigned int)candidates.size() / MIN_CANDIDATES_PER_THREAD,
+		std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& t : threads)
+		t.join();
+	for (unsigned int i = 0; i < candidates.size(); i++)
+		valid[i] = result[i] != 0;
+}
+
+// Computes the order of the time points of the non-removed steps, according to the current schedule
+void PlanOptimizer::linearOrder(const std::vector<bool>& removed, std::vector<TTimePoint>& order)
+{
+	order.clear();
+	for (TStep s = 0; s < removed.size(); s++) {
+		if (!removed[s]) {
+			order.push_back(stepToStartPoint(s));
+			order.push_back(stepToEndPoint(s));
+		}
+	}
+	std::stable_sort(order.begin(), order.end(), [this](TTimePoint p1, TTimePoint p2) {
+		double t1 = (p1 & 1) == 0 ? startTimes[timePointToStep(p1)] : endTimes[timePointToStep(p1)];
+		double t2 = (p2 & 1) == 0 ? startTimes[timePointToStep(p2)] : endTimes[timePointToStep(p2)];
+		return t1 < t2;
+	});
+}
+
+// Simulates the plan without the removed steps and checks its validity
+bool PlanOptimizer::validPlan(const std::vector<bool>& removed)
+{
+	std::vector<TTimePoint> order;
+	linearOrder(removed, order);
+	std::vector<TValue> state(task->variables.size(), MAX_UINT16);
+	std::vector<double> fluents(task->numVariables.size(), 0);
+	std::vector<TStep> active;				// Steps with over-all conditions that must hold
+	for (TTimePoint tp : order) {
+		TStep s = timePointToStep(tp);
+		std::shared_ptr<SASAction> a = planComponents.get(s)->action;
+		if ((tp & 1) == 0) {
+			if (!holdConditions(a->startCond, state) || !holdNumericConditions(a->startNumCond, fluents, s) ||
+				!holdDurationConditions(s, true, fluents))
+				return false;
+			applyEffects(a->startEff, a->startNumEff, s, state, fluents);
+			active.push_back(s);
+		}
+		else {
+			active.erase(std::find(active.begin(), active.end(), s));
+			if (!holdOverAllConditions(s, state, fluents) || !holdConditions(a->endCond, state) ||
+				!holdNumericConditions(a->endNumCond, fluents, s) || !holdDurationConditions(s, false, fluents))
+				return false;
+			applyEffects(a->endEff, a->endNumEff, s, state, fluents);
+		}
+		for (TStep as : active) {
+			if (!holdOverAllConditions(as, state, fluents)) return false;
+		}
+	}
+	return true;
+}
+
+// Checks if the conditions hold in the given state
+bool PlanOptimizer::holdConditions(std::vector<SASCondition>& conds, std::vector<TValue>& state)
+{
+	for (SASCondition& c : conds) {
+		if (state[c.var] != c.value) return false;
+	}
+	return true;
+}
+
+// Checks if the numeric conditions hold with the given fluent values
+bool PlanOptimizer::holdNumericConditions(std::vector<SASNumericCondition>& conds, std::vector<double>& fluents, TStep s)
+{
+	for (SASNumericCondition& c : conds) {
+		if (c.comp == '-') continue;
+		double v1 = evaluate(c.terms[0], fluents, s), v2 = evaluate(c.terms[1], fluents, s);
+		bool hold = true;
+		switch (c.comp) {
+		case '=': hold = fabs(v1 - v2) < EPSILON / 10;	break;
+		case '<': hold = v1 < v2;						break;
+		case 'L': hold = v1 <= v2 + EPSILON / 10;		break;
+		case '>': hold = v1 > v2;						break;
+		case 'G': hold = v1 >= v2 - EPSILON / 10;		break;
+		case 'N': hold = fabs(v1 - v2) >= EPSILON / 10;	break;
+		}
+		if (!hold) return false;
+	}
+	return true;
+}
+
+// Checks the over-all conditions of a step
+bool PlanOptimizer::holdOverAllConditions(TStep s, std::vector<TValue>& state, std::vector<double>& fluents)
+{
+	std::shared_ptr<SASAction> a = planComponents.get(s)->action;
+	return holdConditions(a->overCond, state) && holdNumericConditions(a->overNumCond, fluents, s);
+}
+
+// Checks if the scheduled duration of a step satisfies its at-start (or at-end) duration conditions
+// with the given fluent values. Times are rounded to milliseconds, so the comparisons are relaxed.
+// The durations of the initial step and the TILs are fictitious
+bool PlanOptimizer::holdDurationConditions(TStep s, bool atStart, std::vector<double>& fluents)
+{
+	std::shared_ptr<SASAction> a = planComponents.get(s)->action;
+	if (s == 0 || a->isTIL) return true;
+	double duration = endTimes[s] - startTimes[s];
+	for (SASDurationCondition& d : a->duration.conditions) {
+		if ((d.time == 'E') == atStart) continue;
+		double value = evaluate(d.exp, fluents, s);
+		bool hold = true;
+		switch (d.comp) {
+		case '=': hold = fabs(duration - value) < EPSILON;	break;
+		case '<': hold = duration < value - EPSILON / 2;	break;
+		case 'L': hold = duration <= value + EPSILON / 2;	break;
+		case '>': hold = duration > value + EPSILON / 2;	break;
+		case 'G': hold = duration >= value - EPSILON / 2;	break;
+		}
+		if (!hold) return false;
+	}
+	return true;
+}
+
+// Applies the effects to the given state. Numeric effects are evaluated before modifying the fluents
+void PlanOptimizer::applyEffects(std::vector<SASCondition>& eff, std::vector<SASNumericEffect>& numEff, TStep s,
+	std::vector<TValue>& state, std::vector<double>& fluents)
+{
+	for (SASCondition& e : eff) {
+		state[e.var] = e.value;
+	}
+	std::vector<double> values;
+	for (SASNumericEffect& e : numEff) {
+		values.push_back(evaluate(e.exp, fluents, s));
+	}
+	for (unsigned int i = 0; i < numEff.size(); i++) {
+		SASNumericEffect& e = numEff[i];
+		switch (e.op) {
+		case '=': fluents[e.var] = values[i];	break;
+		case '+': fluents[e.var] += values[i];	break;
+		case '-': fluents[e.var] -= values[i];	break;
+		case '*': fluents[e.var] *= values[i];	break;
+		case '/': fluents[e.var] /= values[i];	break;
+		}
+	}
+}
+
+// Evaluates a numeric expression
+double PlanOptimizer::evaluate(SASNumericExpression& e, std::vector<double>& fluents, TStep s)
+{
+	switch (e.type) {
+	case 'N': return e.value;
+	case 'V': return fluents[e.var];
+	case 'D': return endTimes[s] - startTimes[s];
+	case '+': return evaluate(e.terms[0], fluents, s) + evaluate(e.terms[1], fluents, s);
+	case '-': return evaluate(e.terms[0], fluents, s) - evaluate(e.terms[1], fluents, s);
+	case '*': return evaluate(e.terms[0], fluents, s) * evaluate(e.terms[1], fluents, s);
+	case '/': return evaluate(e.terms[0], fluents, s) / evaluate(e.terms[1], fluents, s);
+	}
+	throwError("Error: unsupported numeric expression in plan post-optimization");
+	return 0;
+}
+
+// Adds an ordering between two time points (with the new numbering)
+void PlanOptimizer::addOrdering(TTimePoint p1, TTimePoint p2)
+{
+	if (p1 == p2 || ((p1 & 1) == 0 && p1 + 1 == p2)) return;	// Same point or start-end of the same step
+	newOrderings.insert(getOrdering(p1, p2));
+}
+
+// Registers a read access to a variable
+void PlanOptimizer::read(PlanVarAccess& v, TTimePoint p)
+{
+	if (v.lastWrite >= 0) addOrdering((TTimePoint)v.lastWrite, p);
+	for (TTimePoint w : v.additiveWrites) addOrdering(w, p);
+	v.reads.push_back(p);
+}
+
+// Registers a write access to a variable
+void PlanOptimizer::write(PlanVarAccess& v, TTimePoint p, bool additive)
+{
+	if (v.lastWrite >= 0) addOrdering((TTimePoint)v.lastWrite, p);
+	for (TTimePoint r : v.reads) addOrdering(r, p);
+	if (additive) {
+		v.additiveWrites.push_back(p);
+	}
+	else {
+		for (TTimePoint w : v.additiveWrites) addOrdering(w, p);
+		v.lastWrite = p;
+		v.reads.clear();
+		v.additiveWrites.clear();
+	}
+}
+
+// Registers the read accesses of a numeric expression
+void PlanOptimizer::readExpression(SASNumericExpression& e, std::vector<PlanVarAccess>& numAccess, TTimePoint p)
+{
+	std::vector<TVariable> vars;
+	e.getVariables(&vars);
+	for (TVariable v : vars) read(numAccess[v], p);
+}
+
+// Registers the read accesses of numeric conditions. The dummy conditions ('-') that the SAS
+// translator adds for the modified fluents always hold, so they do not read their variables
+void PlanOptimizer::readNumericConditions(std::vector<SASNumericCondition>& conds, std::vector<PlanVarAccess>& numAccess, TTimePoint p)
+{
+	for (SASNumericCondition& c : conds) {
+		if (c.comp == '-') continue;
+		for (SASNumericExpression& e : c.terms) readExpression(e, numAccess, p);
+	}
+}
+
+// Registers the read accesses of the at-start (or at-end) and over-all conditions of an action
+void PlanOptimizer::readConditions(std::shared_ptr<SASAction> a, bool atStart, bool overAll,
+	std::vector<PlanVarAccess>& access, std::vector<PlanVarAccess>& numAccess, TTimePoint p)
+{
+	if (overAll) {
+		for (SASCondition& c : a->overCond) read(access[c.var], p);
+		readNumericConditions(a->overNumCond, numAccess, p);
+	}
+	std::vector<SASCondition>& conds = atStart ? a->startCond : a->endCond;
+	for (SASCondition& c : conds) read(access[c.var], p);
+	readNumericConditions(atStart ? a->startNumCond : a->endNumCond, numAccess, p);
+	for (SASDurationCondition& d : a->duration.conditions)
+		if ((d.time == 'E') != atStart) readExpression(d.exp, numAccess, p);
+}
+
+// Computes the orderings required by the plan without the removed steps
+void PlanOptimizer::computeOrderings(const std::vector<bool>& removed)
+{
+	std::vector<TTimePoint> order;
+	linearOrder(removed, order);
+	std::vector<PlanVarAccess> access(task->variables.size()), numAccess(task->numVariables.size());
+	newOrderings.clear();
+	for (TTimePoint tp : order) {
+		std::shared_ptr<SASAction> a = planComponents.get(timePointToStep(tp))->action;
+		TTimePoint p = newIndex[tp];
+		bool atStart = (tp & 1) == 0;
+		if (atStart && timePointToStep(tp) > 0 && !a->isTIL)	// Every step starts after the initial state
+			addOrdering(stepToEndPoint(0), p);
+		readConditions(a, atStart, !atStart, access, numAccess, p);
+		for (SASCondition& e : atStart ? a->startEff : a->endEff)
+			write(access[e.var], p, false);
+		for (SASNumericEffect& e : atStart ? a->startNumEff : a->endNumEff) {
+			readExpression(e.exp, numAccess, p);
+			write(numAccess[e.var], p, e.op == '+' || e.op == '-');
+		}
+		if (atStart) {		// Over-all conditions are supported after the at-start effects
+			for (SASCondition& c : a->overCond) read(access[c.var], p);
+			readNumericConditions(a->overNumCond, numAccess, p);
+		}
+	}
+}
+
+// Builds the plan without the removed steps and with the relaxed orderings
+std::shared_ptr<Plan> PlanOptimizer::buildPlan(const std::vector<bool>& removed)
+{
+	newIndex.assign(removed.size() * 2, 0);
+	TStep numSteps = 0;
+	for (TStep s = 0; s < removed.size(); s++) {
+		if (!removed[s]) {
+			newIndex[stepToStartPoint(s)] = stepToStartPoint(numSteps);
+			newIndex[stepToEndPoint(s)] = stepToEndPoint(numSteps);
+			numSteps++;
+		}
+	}
+	computeOrderings(removed);
+	optimizedSteps.clear();
+	std::shared_ptr<Plan> parent = nullptr;
+	for (TStep s = 0; s < removed.size(); s++) {
+		if (removed[s]) continue;
+		std::shared_ptr<Plan> pc = planComponents.get(s);
+		std::shared_ptr<Plan> step = std::make_shared<Plan>(pc->action, parent, pc->id, nullptr);
+		if (pc->actionDuration.maxValue - pc->actionDuration.minValue < EPSILON / 2) {
+			step->setDuration(pc->actionDuration.minValue, pc->actionDuration.maxValue);
+		}
+		else {					// Keeps the scheduled duration
+			TFloatValue duration = (TFloatValue)(endTimes[s] - startTimes[s]);
+			step->setDuration(duration, duration);
+		}
+		step->setTime((TFloatValue)startTimes[s], (TFloatValue)endTimes[s], pc->fixedInit);
+		step->h = pc->h;
+		step->hLand = pc->hLand;
+		optimizedSteps.push_back(step);
+		parent = step;
+	}
+	for (TOrdering o : newOrderings) {		// Each ordering is stored in its latest step
+		TStep s = std::max(timePointToStep(firstPoint(o)), timePointToStep(secondPoint(o)));
+		optimizedSteps[s]->orderings.push_back(o);
+	}
+	return parent;
+}
+
+// Updates the current schedule with the times of the optimized plan and simulates the plan again
+// with them, as the durations of the flexible steps may have changed
+bool PlanOptimizer::validSchedule(std::shared_ptr<Plan> result, const std::vector<bool>& removed)
+{
+	PlanComponents components;
+	components.calculate(result);
+	TStep n = 0;
+	for (TStep s = 0; s < removed.size(); s++) {
+		if (removed[s]) continue;
+		std::shared_ptr<Plan> pc = components.get(n++);
+		startTimes[s] = pc->startPoint.updatedTime;
+		endTimes[s] = pc->endPoint.updatedTime;
+	}
+	return validPlan(removed);
+}
+
+// Rebuilds the causal links of the optimized plan following its schedule. Each condition is
+// supported by the last time point that wrote its variable, and each numeric variable accessed
+// in a time point by its last modifier
+void PlanOptimizer::addCausalLinks(const std::vector<bool>& removed)
+{
+	std::vector<TTimePoint> order;
+	linearOrder(removed, order);
+	std::vector<int> writer(task->variables.size(), -1), numWriter(task->numVariables.size(), -1);
+	std::vector<TVariable> numVars;
+	for (TTimePoint tp : order) {
+		std::shared_ptr<SASAction> a = planComponents.get(timePointToStep(tp))->action;
+		TTimePoint p = newIndex[tp];
+		bool atStart = (tp & 1) == 0;
+		std::shared_ptr<Plan> step = optimizedSteps[timePointToStep(p)];
+		PlanPoint& point = atStart ? step->startPoint : step->endPoint;
+		for (SASCondition& c : atStart ? a->startCond : a->endCond) {
+			if (writer[c.var] >= 0)
+				point.addCausalLink((TTimePoint)writer[c.var], SASTask::getVariableValueCode(c.var, c.value));
+		}
+		numVars.clear();
+		for (SASNumericCondition& c : atStart ? a->startNumCond : a->endNumCond)
+			for (SASNumericExpression& e : c.terms) e.getVariables(&numVars);
+		for (SASNumericCondition& c : a->overNumCond)
+			for (SASNumericExpression& e : c.terms) e.getVariables(&numVars);
+		for (SASDurationCondition& d : a->duration.conditions)
+			if ((d.time == 'E') != atStart) d.exp.getVariables(&numVars);
+		std::vector<SASNumericEffect>& numEff = atStart ? a->startNumEff : a->endNumEff;
+		for (SASNumericEffect& e : numEff) {
+			e.exp.getVariables(&numVars);
+			if (std::find(numVars.begin(), numVars.end(), e.var) == numVars.end())
+				numVars.push_back(e.var);
+		}
+		for (TVariable v : numVars) {
+			if (numWriter[v] >= 0)
+				point.addNumericCausalLink((TTimePoint)numWriter[v], v);
+		}
+		for (SASCondition& e : atStart ? a->startEff : a->endEff)
+			writer[e.var] = p;
+		for (SASNumericEffect& e : numEff)
+			numWriter[e.var] = p;
+		if (atStart) {		// Over-all conditions are supported after the at-start effects
+			for (SASCondition& c : a->overCond) {
+				if (writer[c.var] >= 0)
+					point.addCausalLink((TTimePoint)writer[c.var], SASTask::getVariableValueCode(c.var, c.value));
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef PLAN_OPTIMIZER_H
+#define PLAN_OPTIMIZER_H
+
+#include <vector>
+#include <unordered_set>
+#include "../sas/sasTask.h"
+#include "plan.h"
+#include "planComponents.h"
+#include "planScheduler.h"
+
+/********************************************************/
+/* Post-processing of a scheduled solution plan:        */
+/* removal of redundant steps, relaxation of the        */
+/* orderings and rescheduling.                          */
+/********************************************************/
+
+class PlanVarAccess {	// Accesses to a variable since its last (non-additive) write
+public:
+	int lastWrite;
+	std::vector<TTimePoint> reads;
+	std::vector<TTimePoint> additiveWrites;	// Increase/decrease effects, which commute among them
+	PlanVarAccess() { lastWrite = -1; }
+};
+
+class PlanOptimizer {
+private:
+	std::shared_ptr<SASTask> task;
+	PlanScheduler scheduler;
+	PlanComponents planComponents;
+	std::vector<std::shared_ptr<Plan>> optimizedSteps;		// Steps of the optimized plan (the last one is returned)
+	std::vector<double> startTimes, endTimes;				// Current schedule
+	std::vector<TTimePoint> newIndex;						// Time point numbering in the optimized plan
+	std::unordered_set<TOrdering> newOrderings;
+
+	bool optimizableStep(std::shared_ptr<Plan> p);
+	void linearOrder(const std::vector<bool>& removed, std::vector<TTimePoint>& order);
+	bool validPlan(const std::vector<bool>& removed);
+	bool holdConditions(std::vector<SASCondition>& conds, std::vector<TValue>& state);
+	bool holdNumericConditions(std::vector<SASNumericCondition>& conds, std::vector<double>& fluents, TStep s);
+	bool holdOverAllConditions(TStep s, std::vector<TValue>& state, std::vector<double>& fluents);
+	bool holdDurationConditions(TStep s, bool atStart, std::vector<double>& fluents);
+	void applyEffects(std::vector<SASCondition>& eff, std::vector<SASNumericEffect>& numEff, TStep s,
+		std::vector<TValue>& state, std::vector<double>& fluents);
+	double evaluate(SASNumericExpression& e, std::vector<double>& fluents, TStep s);
+	void checkCandidates(std::vector<TStep>& candidates, std::vector<bool>& removed, std::vector<bool>& valid);
+	void computeOrderings(const std::vector<bool>& removed);
+	void addOrdering(TTimePoint p1, TTimePoint p2);
+	void read(PlanVarAccess& v, TTimePoint p);
+	void write(PlanVarAccess& v, TTimePoint p, bool additive);
+	void readExpression(SASNumericExpression& e, std::vector<PlanVarAccess>& numAccess, TTimePoint p);
+	void readNumericConditions(std::vector<SASNumericCondition>& conds, std::vector<PlanVarAccess>& numAccess, TTimePoint p);
+	void readConditions(std::shared_ptr<SASAction> a, bool atStart, bool overAll,
+		std::vector<PlanVarAccess>& access, std::vector<PlanVarAccess>& numAccess, TTimePoint p);
+	std::shared_ptr<Plan> buildPlan(const std::vector<bool>& removed);
+	bool validSchedule(std::shared_ptr<Plan> result, const std::vector<bool>& removed);
+	void addCausalLinks(const std::vector<bool>& removed);
+
+public:
+	unsigned int removedSteps;		// Steps removed by the last optimization
+
+	PlanOptimizer(std::shared_ptr<SASTask> task);
+	std::shared_ptr<Plan> optimize(std::shared_ptr<Plan> p);
+};
+
+#endif
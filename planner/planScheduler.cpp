@@ -0,0 +1,234 @@
+#include "planScheduler.h"
+#include <algorithm>
+
+/********************************************************/
+/* Makespan minimization of a valid plan, through the   */
+/* computation of the earliest start times over the    */
+/* plan orderings. Not applicable if the numeric        */
+/* conditions or effects depend on the plan timing.     */
+/********************************************************/
+
+// If the numeric values do not depend on the timing, the plan constraints reduce
+// to start + minDuration <= end <= start + maxDuration and the orderings
+// (t1 + EPSILON <= t2), as in the Z3 model. The earliest times satisfying these constraints minimize all the time
+// points at once, so they also minimize the makespan.
+
+using namespace std;
+
+// Schedules the plan. Returns false if the plan cannot be scheduled in this way
+bool PlanScheduler::schedule(std::shared_ptr<Plan> p)
+{
+	planComponents.calculate(p);
+	TStep numSteps = (TStep)planComponents.size();
+	durations.resize(numSteps);
+	maxDurations.resize(numSteps);
+	fixedStart.resize(numSteps);
+	for (TStep s = 0; s < numSteps; s++) {
+		std::shared_ptr<Plan> pc = planComponents.get(s);
+		if (timeDependentAction(pc->action, pc) || !computeDuration(pc, s))
+			return false;
+		fixedStart[s] = s == 0 || pc->action->isTIL;
+	}
+	if (!computeEarliestTimes())
+		return false;
+	updatePlan(p);
+	return true;
+}
+
+// Checks if an expression depends on the plan timing
+bool PlanScheduler::timeDependentExpression(SASNumericExpression& e)
+{
+	if (e.type == 'D' || e.type == '#' || e.type == 'C') return true;
+	for (SASNumericExpression& t : e.terms) {
+		if (timeDependentExpression(t)) return true;
+	}
+	return false;
+}
+
+// Checks if a numeric condition depends on the plan timing
+bool PlanScheduler::timeDependentCondition(SASNumericCondition& c)
+{
+	for (SASNumericExpression& e : c.terms) {
+		if (timeDependentExpression(e)) return true;
+	}
+	return false;
+}
+
+// Checks if the numeric conditions or effects of the action depend on the plan timing
+bool PlanScheduler::timeDependentAction(std::shared_ptr<SASAction> a, std::shared_ptr<Plan> p)
+{
+	if (!a->controlVars.empty()) return true;
+	for (SASNumericCondition& c : a->startNumCond)
+		if (timeDependentCondition(c)) return true;
+	for (SASNumericCondition& c : a->overNumCond)
+		if (timeDependentCondition(c)) return true;
+	for (SASNumericCondition& c : a->endNumCond)
+		if (timeDependentCondition(c)) return true;
+	for (SASNumericEffect& e : a->startNumEff)
+		if (timeDependentExpression(e.exp)) return true;
+	for (SASNumericEffect& e : a->endNumEff)
+		if (timeDependentExpression(e.exp)) return true;
+	if (p->holdCondEff != nullptr) {
+		for (unsigned int numEff : *p->holdCondEff) {
+			SASConditionalEffect& ce = a->conditionalEff[numEff];
+			for (SASNumericCondition& c : ce.startNumCond)
+				if (timeDependentCondition(c)) return true;
+			for (SASNumericCondition& c : ce.endNumCond)
+				if (timeDependentCondition(c)) return true;
+			for (SASNumericEffect& e : ce.startNumEff)
+				if (timeDependentExpression(e.exp)) return true;
+			for (SASNumericEffect& e : ce.endNumEff)
+				if (timeDependentExpression(e.exp)) return true;
+		}
+	}
+	for (SASDurationCondition& d : a->duration.conditions)
+		if (timeDependentExpression(d.exp)) return true;
+	return false;
+}
+
+// Evaluates an expression without variables. Returns false if it has variables
+bool PlanScheduler::constantExpression(SASNumericExpression& e, double* value)
+{
+	double v1, v2;
+	switch (e.type) {
+	case 'N':
+		*value = e.value;
+		return true;
+	case '+':
+	case '-':
+	case '*':
+	case '/':
+		if (!constantExpression(e.terms[0], &v1) || !constantExpression(e.terms[1], &v2)) return false;
+		if (e.type == '+') *value = v1 + v2;
+		else if (e.type == '-') *value = v1 - v2;
+		else if (e.type == '*') *value = v1 * v2;
+		else if (v2 == 0) return false;
+		else *value = v1 / v2;
+		return true;
+	}
+	return false;
+}
+
+// Computes the duration bounds of a step. Fixed durations are taken from the plan, as
+// computed by the planner, and flexible durations start at their minimum value
+bool PlanScheduler::computeDuration(std::shared_ptr<Plan> p, TStep s)
+{
+	bool fixed = false;
+	double minDuration = 0, maxDuration = FLOAT_INFINITY, value;
+	for (SASDurationCondition& d : p->action->duration.conditions) {
+		if (d.comp == '=') {
+			fixed = true;
+			continue;
+		}
+		if (!constantExpression(d.exp, &value)) return false;
+		switch (d.comp) {
+		case '>': minDuration = max(minDuration, value + EPSILON);	break;
+		case 'G': minDuration = max(minDuration, value);			break;
+		case '<': maxDuration = min(maxDuration, value - EPSILON);	break;
+		case 'L': maxDuration = min(maxDuration, value);			break;
+		default:  return false;
+		}
+	}
+	if (fixed) {
+		if (p->actionDuration.maxValue - p->actionDuration.minValue > EPSILON / 2) return false;
+		durations[s] = maxDurations[s] = p->actionDuration.minValue;
+	}
+	else if (p->action->duration.conditions.empty()) {	// Fictitious initial action
+		durations[s] = maxDurations[s] = p->actionDuration.minValue;
+	}
+	else {
+		if (minDuration > maxDuration + EPSILON / 2) return false;
+		durations[s] = (TFloatValue)minDuration;
+		maxDurations[s] = (TFloatValue)max(minDuration, maxDuration);
+	}
+	return true;
+}
+
+// Delays a time point to the given time. A delayed end point stretches the duration of
+// the step up to its maximum, and the start is only delayed when it is not enough. A
+// delayed start point also delays the end if the minimum duration requires it. Returns
+// false if the step start is fixed and it should be delayed
+bool PlanScheduler::delayPoint(TTimePoint tp, double time)
+{
+	TStep s = timePointToStep(tp);
+	TTimePoint start = stepToStartPoint(s);
+	if ((tp & 1) == 0) {
+		if (fixedStart[s]) return false;
+		times[start] = time;
+		times[start + 1] = max(times[start + 1], time + durations[s]);
+	}
+	else {
+		if (time - times[start] > maxDurations[s] + EPSILON / 10) {
+			if (fixedStart[s]) return false;
+			times[start] = time - maxDurations[s];
+		}
+		times[start + 1] = time;
+	}
+	return true;
+}
+
+// Computes the earliest time of each time point through successive relaxations
+// of the orderings. Returns false if the constraints cannot be satisfied
+bool PlanScheduler::computeEarliestTimes()
+{
+	TStep numSteps = (TStep)planComponents.size();
+	unsigned int numPoints = numSteps * 2;
+	times.resize(numPoints);
+	for (TStep s = 0; s < numSteps; s++) {
+		TTimePoint start = stepToStartPoint(s);
+		times[start] = s == 0 && !planComponents.get(s)->action->isTIL ? -EPSILON : 0;
+		times[start + 1] = times[start] + durations[s];
+	}
+	std::vector<TOrdering> orderings;
+	std::vector<unsigned int> numPrev(numPoints, 0);
+	for (TStep s = 0; s < numSteps; s++) {
+		for (TOrdering o : planComponents.get(s)->orderings) {
+			TTimePoint tp1 = firstPoint(o), tp2 = secondPoint(o);
+			if (tp1 + 1 != tp2 || (tp1 & 1) == 1) {
+				orderings.push_back(o);
+				numPrev[tp2]++;
+			}
+		}
+	}
+	// Sorting by the number of previous points of their first point only reduces the
+	// number of passes. The orderings are not always transitively closed (e.g. those
+	// of PlanOptimizer), so this is not a topological order: the passes are repeated
+	// until no point is delayed, which makes the schedule correct in any order
+	sort(orderings.begin(), orderings.end(), [&numPrev](TOrdering o1, TOrdering o2) {
+		return numPrev[firstPoint(o1)] < numPrev[firstPoint(o2)]; });
+	for (unsigned int pass = 0; pass <= numPoints; pass++) {
+		bool changed = false;
+		for (TOrdering o : orderings) {
+			TTimePoint tp1 = firstPoint(o), tp2 = secondPoint(o);
+			double minTime = times[tp1] + EPSILON;
+			if (times[tp2] < minTime - EPSILON / 10) {
+				if (!delayPoint(tp2, minTime)) return false;
+				changed = true;
+			}
+		}
+		if (!changed) return true;
+	}
+	return false;
+}
+
+// Updates the plan times with the computed schedule
+void PlanScheduler::updatePlan(std::shared_ptr<Plan> p)
+{
+	for (TStep s = 0; s < planComponents.size(); s++) {
+		TTimePoint startPoint = stepToStartPoint(s), endPoint = startPoint + 1;
+		TFloatValue startTime = round3d((TFloatValue)times[startPoint]);
+		TFloatValue endTime = round3d((TFloatValue)times[endPoint]);
+		std::shared_ptr<Plan> pc = planComponents.get(s);
+		if (p == pc) {
+			p->setTime(startTime, endTime, p->fixedInit);
+		}
+		else {
+			if (abs(startTime - pc->startPoint.updatedTime) > EPSILON / 2) {
+				p->addPlanUpdate(startPoint, startTime);
+			}
+			if (abs(endTime - pc->endPoint.updatedTime) > EPSILON / 2) {
+				p->addPlanUpdate(endPoint, endTime);
+			}
+		}
+	}
+}
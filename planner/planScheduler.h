@@ -0,0 +1,36 @@
+#ifndef PLAN_SCHEDULER_H
+#define PLAN_SCHEDULER_H
+
+#include <vector>
+#include "plan.h"
+#include "planComponents.h"
+
+/********************************************************/
+/* Makespan minimization of a valid plan, through the   */
+/* computation of the earliest start times over the    */
+/* plan orderings. Not applicable if the numeric        */
+/* conditions or effects depend on the plan timing.     */
+/********************************************************/
+
+class PlanScheduler {
+private:
+	PlanComponents planComponents;
+	std::vector<TFloatValue> durations;	// Minimum duration of each step
+	std::vector<TFloatValue> maxDurations;	// Maximum duration of each step (flexible durations)
+	std::vector<bool> fixedStart;		// Steps with a fixed start time (initial step and TILs)
+	std::vector<double> times;			// Time of each time point
+
+	bool timeDependentExpression(SASNumericExpression& e);
+	bool timeDependentCondition(SASNumericCondition& c);
+	bool timeDependentAction(std::shared_ptr<SASAction> a, std::shared_ptr<Plan> p);
+	bool constantExpression(SASNumericExpression& e, double* value);
+	bool computeDuration(std::shared_ptr<Plan> p, TStep s);
+	bool computeEarliestTimes();
+	bool delayPoint(TTimePoint tp, double time);
+	void updatePlan(std::shared_ptr<Plan> p);
+
+public:
+	bool schedule(std::shared_ptr<Plan> p);
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include "planner.h"
-#include "z3Checker.h"
 #include "printPlan.h"
 
 #include <iomanip>
@@ -53,10 +52,13 @@ std::shared_ptr<Plan> Planner::plan(float bestMakespan, clock_t startTime)
 {
 	this->startTime = startTime;
 	this->bestMakespan = bestMakespan;
+	Z3Checker::settings.startTime = startTime;		// Z3 checks are interrupted when the deadline is reached
+	Z3Checker::settings.timeLimit = MAX_PLANNING_TIME;
 	while (solution == nullptr && this->selector->size() > 0) {
-		if (toSeconds(startTime) > 600) break;
+		if (toSeconds(startTime) > MAX_PLANNING_TIME) break;
 		searchStep();
 	}
+	Z3Checker::settings.timeLimit = 0;				// The final checks of the solution are not interrupted
 	return solution;
 }
 
@@ -69,7 +71,6 @@ void Planner::clearSolution()
 
 // Checks if a plan is valid
 bool Planner::checkPlan(std::shared_ptr<Plan> p) {
-	Z3Checker checker;
 	cout << ".";
 	p->z3Checked = true;
 	bool valid = checker.checkPlan(p, false);
@@ -13,9 +13,12 @@
 #include "plan.h"
 #include "successors.h"
 #include "selector.h"
+#include "lpChecker.h"
 
 // #define _DEBUG true
 
+#define MAX_PLANNING_TIME	600		// Seconds
+
 class Planner {
 private:
 	std::shared_ptr<SASTask> task;
@@ -32,6 +35,7 @@ private:
 	std::shared_ptr<Plan> solution;
 	std::vector<std::shared_ptr<Plan>> sucPlans;
 	std::unique_ptr<SearchQueue> selector;
+	LPChecker checker;							// Plan validity checker (reused to warm-start the LP)
 	clock_t startTime;
 	float bestMakespan;
 	int bestNumSteps;
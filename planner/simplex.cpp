@@ -0,0 +1,279 @@
+#include "simplex.h"
+#include <cmath>
+
+/********************************************************/
+/* Bounded-variable primal simplex over a dense         */
+/* tableau. Rows and columns can be appended after a    */
+/* solve, keeping the current basis (warm start).       */
+/********************************************************/
+
+// Each row i is stored as sum(a_ij * x_j) - r_i = 0, where r_i is the logical
+// column of the row, bounded by the row limits. The initial basis is formed by
+// the logical columns, so the tableau starts as -A for the structural columns.
+
+using namespace std;
+
+// Constructor
+SimplexSolver::SimplexSolver()
+{
+	maxIterations = 50000;
+	clear();
+}
+
+// Removes all rows and columns
+void SimplexSolver::clear()
+{
+	lower.clear();
+	upper.clear();
+	value.clear();
+	cost.clear();
+	basicRow.clear();
+	head.clear();
+	logical.clear();
+	rows.clear();
+	tableau.clear();
+	numStructural = 0;
+	iterations = 0;
+	degeneratePivots = 0;
+	blandRule = false;
+}
+
+// Initial value of a nonbasic column
+double SimplexSolver::nonbasicStartValue(unsigned int col)
+{
+	if (lower[col] > -SIMPLEX_INFINITY) return lower[col];
+	if (upper[col] < SIMPLEX_INFINITY) return upper[col];
+	return 0;
+}
+
+// Adds a new nonbasic column. It does not appear in the existing rows
+unsigned int SimplexSolver::newColumn(double lo, double hi)
+{
+	unsigned int col = (unsigned int)lower.size();
+	lower.push_back(lo);
+	upper.push_back(hi);
+	cost.push_back(0);
+	basicRow.push_back(-1);
+	value.push_back(nonbasicStartValue(col));
+	for (vector<double>& t : tableau)
+		t.push_back(0);
+	return col;
+}
+
+// Adds a new structural variable with the given bounds
+unsigned int SimplexSolver::addVariable(double lo, double hi)
+{
+	numStructural++;
+	return newColumn(lo, hi);
+}
+
+// Adds the row lo <= sum(terms) <= hi. The new logical column enters the basis,
+// so the current basis remains valid (warm start)
+unsigned int SimplexSolver::addRow(const TLinearTerms& terms, double lo, double hi)
+{
+	unsigned int r = newColumn(lo, hi), numRow = (unsigned int)head.size();
+	vector<double> t(lower.size(), 0);
+	t[r] = 1;
+	for (const pair<unsigned int, double>& term : terms)
+		t[term.first] -= term.second;
+	for (const pair<unsigned int, double>& term : terms) {	// Expresses the row in terms of the nonbasic columns
+		int k = basicRow[term.first];
+		double f = t[term.first];
+		if (k >= 0 && f != 0) {
+			vector<double>& row = tableau[k];
+			for (unsigned int j = 0; j < t.size(); j++)
+				if (row[j] != 0) t[j] -= f * row[j];
+			t[term.first] = 0;
+		}
+	}
+	double v = 0;
+	for (unsigned int j = 0; j < t.size(); j++)
+		if (t[j] != 0 && j != r) v -= t[j] * value[j];
+	value[r] = v;
+	basicRow[r] = numRow;
+	head.push_back(r);
+	logical.push_back(r);
+	rows.push_back(terms);
+	tableau.push_back(t);
+	return r;
+}
+
+// Sets the objective function to minimize
+void SimplexSolver::setObjective(const TLinearTerms& terms)
+{
+	for (unsigned int j = 0; j < cost.size(); j++)
+		cost[j] = 0;
+	for (const pair<unsigned int, double>& term : terms)
+		cost[term.first] += term.second;
+}
+
+// Recomputes the values of the basic columns from the nonbasic ones
+void SimplexSolver::computeBasicValues()
+{
+	for (unsigned int i = 0; i < head.size(); i++) {
+		vector<double>& t = tableau[i];
+		double v = 0;
+		for (unsigned int j = 0; j < t.size(); j++)
+			if (t[j] != 0 && basicRow[j] < 0) v -= t[j] * value[j];
+		value[head[i]] = v;
+	}
+}
+
+// Gradient of the sum of infeasibilities with respect to a basic column
+double SimplexSolver::phase1Cost(unsigned int col)
+{
+	if (value[col] < lower[col] - SIMPLEX_FEAS_TOL) return -1;
+	if (value[col] > upper[col] + SIMPLEX_FEAS_TOL) return 1;
+	return 0;
+}
+
+// Pivots the given column into the basis in the given row
+void SimplexSolver::pivot(unsigned int row, unsigned int col)
+{
+	vector<double>& pr = tableau[row];
+	double p = pr[col];
+	for (unsigned int j = 0; j < pr.size(); j++)
+		if (pr[j] != 0) pr[j] /= p;
+	pr[col] = 1;
+	for (unsigned int i = 0; i < tableau.size(); i++) {
+		if (i == row) continue;
+		vector<double>& t = tableau[i];
+		double f = t[col];
+		if (f == 0) continue;
+		for (unsigned int j = 0; j < t.size(); j++)
+			if (pr[j] != 0) t[j] -= f * pr[j];
+		t[col] = 0;
+	}
+	basicRow[head[row]] = -1;
+	head[row] = col;
+	basicRow[col] = row;
+}
+
+// Performs one simplex iteration. Returns SIMPLEX_OPTIMAL if no column can improve
+// the objective, SIMPLEX_UNBOUNDED, SIMPLEX_LIMIT or ' ' to continue
+char SimplexSolver::iterate(bool phase1)
+{
+	unsigned int numCols = (unsigned int)lower.size();
+	vector<double> w(numCols, 0);					// Reduced costs
+	for (unsigned int j = 0; j < numCols; j++)
+		if (basicRow[j] < 0) w[j] = phase1 ? 0 : cost[j];
+	for (unsigned int i = 0; i < head.size(); i++) {
+		double c = phase1 ? phase1Cost(head[i]) : cost[head[i]];
+		if (c == 0) continue;
+		vector<double>& t = tableau[i];
+		for (unsigned int j = 0; j < numCols; j++)
+			if (t[j] != 0) w[j] -= c * t[j];
+	}
+	int enter = -1;									// Pricing
+	double dir = 0, best = 0;
+	for (unsigned int j = 0; j < numCols; j++) {
+		if (basicRow[j] >= 0 || lower[j] == upper[j]) continue;
+		double d = w[j];
+		if (d < -SIMPLEX_DUAL_TOL && value[j] < upper[j] - SIMPLEX_FEAS_TOL) {
+			if (-d > best) { enter = j; dir = 1; best = -d; }
+		}
+		else if (d > SIMPLEX_DUAL_TOL && value[j] > lower[j] + SIMPLEX_FEAS_TOL) {
+			if (d > best) { enter = j; dir = -1; best = d; }
+		}
+		if (blandRule && enter >= 0) break;
+	}
+	if (enter < 0) return SIMPLEX_OPTIMAL;
+	int leave = -1;									// Ratio test
+	double theta = upper[enter] - lower[enter], leaveValue = 0, pivotSize = 0;
+	if (theta >= SIMPLEX_INFINITY) theta = SIMPLEX_INFINITY;
+	for (unsigned int i = 0; i < head.size(); i++) {
+		double alpha = tableau[i][enter];
+		if (fabs(alpha) <= SIMPLEX_PIVOT_TOL) continue;
+		unsigned int col = head[i];
+		double rate = -alpha * dir, x = value[col], limit = SIMPLEX_INFINITY, bound = 0;
+		if (phase1 && x < lower[col] - SIMPLEX_FEAS_TOL) {
+			if (rate > 0) { bound = lower[col]; limit = (bound - x) / rate; }
+		}
+		else if (phase1 && x > upper[col] + SIMPLEX_FEAS_TOL) {
+			if (rate < 0) { bound = upper[col]; limit = (bound - x) / rate; }
+		}
+		else if (rate > 0) {
+			if (upper[col] < SIMPLEX_INFINITY) { bound = upper[col]; limit = (bound - x) / rate; }
+		}
+		else if (lower[col] > -SIMPLEX_INFINITY) {
+			bound = lower[col]; limit = (bound - x) / rate;
+		}
+		if (limit >= SIMPLEX_INFINITY) continue;
+		if (limit < 0) limit = 0;
+		if (limit < theta - 1e-12 || (limit <= theta + 1e-12 && leave >= 0 &&
+			(blandRule ? col < head[leave] : fabs(alpha) > pivotSize))) {
+			theta = limit;
+			leave = i;
+			leaveValue = bound;
+			pivotSize = fabs(alpha);
+		}
+	}
+	if (theta >= SIMPLEX_INFINITY)
+		return phase1 ? SIMPLEX_LIMIT : SIMPLEX_UNBOUNDED;
+	value[enter] += dir * theta;					// Update values
+	for (unsigned int i = 0; i < head.size(); i++) {
+		double alpha = tableau[i][enter];
+		if (alpha != 0) value[head[i]] -= alpha * dir * theta;
+	}
+	if (leave < 0) {								// Bound flip
+		value[enter] = dir > 0 ? upper[enter] : lower[enter];
+	}
+	else {
+		unsigned int col = head[leave];
+		pivot(leave, enter);
+		value[col] = leaveValue;
+	}
+	if (theta < 1e-12) {
+		if (++degeneratePivots > SIMPLEX_MAX_DEGENERATE) blandRule = true;
+	}
+	else degeneratePivots = 0;
+	if (++iterations % 100 == 0) computeBasicValues();
+	return iterations >= maxIterations ? SIMPLEX_LIMIT : ' ';
+}
+
+// Checks the current solution against the original rows
+bool SimplexSolver::checkSolution()
+{
+	computeBasicValues();
+	for (unsigned int j = 0; j < lower.size(); j++) {
+		double tol = SIMPLEX_FEAS_TOL * 10 * (1 + fabs(value[j]));
+		if (value[j] < lower[j] - tol || value[j] > upper[j] + tol) return false;
+	}
+	for (unsigned int i = 0; i < rows.size(); i++) {
+		double v = 0;
+		for (const pair<unsigned int, double>& term : rows[i])
+			v += term.second * value[term.first];
+		double tol = SIMPLEX_FEAS_TOL * 10 * (1 + fabs(v));
+		unsigned int r = logical[i];
+		if (fabs(v - value[r]) > tol || v < lower[r] - tol || v > upper[r] + tol) return false;
+	}
+	return true;
+}
+
+// Solves the problem starting from the current basis
+char SimplexSolver::solve()
+{
+	iterations = 0;
+	degeneratePivots = 0;
+	blandRule = false;
+	computeBasicValues();
+	char res;
+	do {											// Phase 1: minimize the sum of infeasibilities
+		res = iterate(true);
+	} while (res == ' ');
+	if (res != SIMPLEX_OPTIMAL) return SIMPLEX_LIMIT;
+	for (unsigned int i = 0; i < head.size(); i++)
+		if (phase1Cost(head[i]) != 0) return SIMPLEX_INFEASIBLE;
+	bool hasObjective = false;
+	for (double c : cost)
+		if (c != 0) { hasObjective = true; break; }
+	if (hasObjective) {								// Phase 2: minimize the objective
+		degeneratePivots = 0;
+		blandRule = false;
+		do {
+			res = iterate(false);
+		} while (res == ' ');
+		if (res != SIMPLEX_OPTIMAL) return res;
+	}
+	return checkSolution() ? SIMPLEX_OPTIMAL : SIMPLEX_LIMIT;
+}
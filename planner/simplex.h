@@ -0,0 +1,65 @@
+#ifndef SIMPLEX_H
+#define SIMPLEX_H
+
+#include <vector>
+#include "../utils/utils.h"
+
+/********************************************************/
+/* Bounded-variable primal simplex over a dense         */
+/* tableau. Rows and columns can be appended after a    */
+/* solve, keeping the current basis (warm start).       */
+/********************************************************/
+
+#define SIMPLEX_OPTIMAL			'O'
+#define SIMPLEX_INFEASIBLE		'I'
+#define SIMPLEX_UNBOUNDED		'U'
+#define SIMPLEX_LIMIT			'L'		// Iteration limit reached or numerical trouble
+
+#define SIMPLEX_INFINITY		1e30
+#define SIMPLEX_FEAS_TOL		1e-7
+#define SIMPLEX_DUAL_TOL		1e-9
+#define SIMPLEX_PIVOT_TOL		1e-9
+#define SIMPLEX_MAX_DEGENERATE	50		// Consecutive degenerate pivots before switching to Bland's rule
+
+typedef std::vector<std::pair<unsigned int, double>> TLinearTerms;	// (column, coefficient)
+
+class SimplexSolver {
+private:
+	std::vector<double> lower;				// Column bounds (structural and logical columns)
+	std::vector<double> upper;
+	std::vector<double> value;				// Current column values
+	std::vector<double> cost;				// Objective coefficients
+	std::vector<int> basicRow;				// Row in which a column is basic, -1 if nonbasic
+	std::vector<unsigned int> head;			// Basic column of each row
+	std::vector<unsigned int> logical;		// Logical column of each row
+	std::vector<TLinearTerms> rows;			// Original rows (structural terms only)
+	std::vector<std::vector<double>> tableau;	// B^-1 * A, one vector per row
+	unsigned int numStructural;
+	unsigned int iterations;
+	unsigned int degeneratePivots;
+	bool blandRule;							// Anti-cycling rule activated
+
+	unsigned int newColumn(double lo, double hi);
+	double nonbasicStartValue(unsigned int col);
+	void computeBasicValues();
+	char iterate(bool phase1);
+	double phase1Cost(unsigned int col);
+	void pivot(unsigned int row, unsigned int col);
+	bool checkSolution();
+
+public:
+	unsigned int maxIterations;
+
+	SimplexSolver();
+	void clear();
+	unsigned int addVariable(double lo, double hi);
+	unsigned int addRow(const TLinearTerms& terms, double lo, double hi);
+	void setObjective(const TLinearTerms& terms);
+	char solve();
+	inline double getValue(unsigned int col) { return value[col]; }
+	inline unsigned int numVariables() { return numStructural; }
+	inline unsigned int numRows() { return (unsigned int)rows.size(); }
+	inline unsigned int getIterations() { return iterations; }
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include "successors.h"
 #include "printPlan.h"
 #include "intervalCalculations.h"
+#include "../sas/linearConditions.h"
 using namespace std;
 
 //#define DEBUG_SUCC_ON
@@ -24,6 +25,7 @@ void Successors::computeOrderMatrix()
 		for (unsigned int i = 0; i < matrix.size(); i++)
 			for (unsigned int j = 0; j < matrix[i].size(); j++)
 				matrix[i][j] = 0;
+		std::fill(linearStateStamp.begin(), linearStateStamp.end(), 0);
 	}
 	newStep = planComponents.size();								// Steps start by 0
 	TTimePoint lastPoint = stepToEndPoint(newStep);
@@ -239,6 +241,14 @@ int Successors::supportedNumericConditions(std::shared_ptr<SASAction> a)
 	if (planEffects.numStates.empty()) return -1; // Supported since there are no numeric fluents in the problem
 	if (a->startNumCond.empty() && a->overNumCond.empty() && a->endNumCond.empty())
 		return -1;		// Supported since action has no numeric conditions
+	unsigned int index = task->actionTable->getIndex(*a);	// Goals are placed after the actions
+	if (task->linearConditions->isBatched(index)) {		// Linear conditions: batched evaluation
+		for (int i = (int)planEffects.numStates.size() - 1; i >= 0; i--) {
+			if (supportedLinearConditions(i, index))
+				return i;
+		}
+		return -2;
+	}
 	for (int i = (int)planEffects.numStates.size() - 1; i >= 0; i--) {
 		IntervalCalculations ic(a, i, &planEffects, task);
 		if (ic.supportedNumericStartConditions(nullptr))
@@ -247,6 +257,25 @@ int Successors::supportedNumericConditions(std::shared_ptr<SASAction> a)
 	return -2;	// Index of the numeric state that supports the numeric conditions. -2 means unsupported conditions
 }
 
+// Checks if the linear numeric conditions of an action (index in the action table) hold in a numeric
+// state. All the batched actions are evaluated in that state the first time it is required in the current iteration
+bool Successors::supportedLinearConditions(int numState, unsigned int a)
+{
+	if (numState >= (int)linearStateStamp.size()) {
+		linearStateStamp.resize(numState + 1, 0);
+		linearActionHolds.resize(numState + 1);
+	}
+	if (linearStateStamp[numState] != currentIteration) {
+		for (TVariable v = 0; v < task->numVariables.size(); v++) {
+			linearBounds[SASLinearConditions::minBound(v)] = planEffects.getMinValue(v, numState);
+			linearBounds[SASLinearConditions::maxBound(v)] = planEffects.getMaxValue(v, numState);
+		}
+		task->linearConditions->evaluate(linearBounds, linearRowHolds, linearActionHolds[numState]);
+		linearStateStamp[numState] = currentIteration;
+	}
+	return linearActionHolds[numState][a];
+}
+
 int Successors::supportedNumericConditions(SASConditionalEffect* e, std::shared_ptr<SASAction> a)
 {
 	if (planEffects.numStates.empty()) return -1; // Supported since there are no numeric fluents in the problem
@@ -262,18 +291,9 @@ int Successors::supportedNumericConditions(SASConditionalEffect* e, std::shared_
 
 bool Successors::supportedConditions(const std::shared_ptr<SASAction> a)
 {
-	for (unsigned int i = 0; i < a->startCond.size(); i++)
-		if (!supportedCondition(a->startCond[i]))
-			return false;
-	for (unsigned int i = 0; i < a->overCond.size(); i++) {
-		if (!supportedCondition(a->overCond[i]))
+	for (TVarValue c : task->actionTable->getAllConditions(task->actionTable->getIndex(*a)))
+		if (!supportedCondition(SASTask::getVariableIndex(c), SASTask::getValueIndex(c)))
 			return false;
-	}
-	//if (forceAtEndConditions) {
-		for (unsigned int i = 0; i < a->endCond.size(); i++)
-			if (!supportedCondition(a->endCond[i]))
-				return false;
-	//}
 	return true;
 }
 
@@ -295,6 +315,7 @@ Successors::Successors(std::shared_ptr<TState> state, std::shared_ptr<SASTask> t
 		checkedAction.push_back(0);
 	}
 	currentIteration = 0;
+	task->linearConditions->initializeBounds(linearBounds);
 	matrix.resize(INITAL_MATRIX_SIZE);
 	for (unsigned int i = 0; i < INITAL_MATRIX_SIZE; i++)
 		matrix[i].resize(INITAL_MATRIX_SIZE, 0);
@@ -604,40 +625,36 @@ void Successors::computeSuccessorsSupportedByLastActions()
 	TTimePoint startTimeNewAction = stepToStartPoint(newStep);
 	TTimePoint startTimeLastAction = startTimeNewAction - 2;
 	for (SASCondition& c : a->startEff) {
-		vector<std::shared_ptr<SASAction>>& req = task->requirers[c.var][c.value];
-		for (std::shared_ptr<SASAction> ra : req) {
+		for (uint32_t ra : task->getRequirers(c.var, c.value)) {
 			if (!visitedAction(ra)) {
 				setVisitedAction(ra);
-				//cout << "Action " << ra->name << " supported by at-start" << endl;
-				fullActionCheck(ra, c.var, c.value, startTimeLastAction, startTimeNewAction);
+				//cout << "Action " << task->actions[ra]->name << " supported by at-start" << endl;
+				fullActionCheck(task->actions[ra], c.var, c.value, startTimeLastAction, startTimeNewAction);
 			}
 		}
 	}
 	for (SASCondition& c : a->endEff) {
-		vector<std::shared_ptr<SASAction>>& req = task->requirers[c.var][c.value];
-		for (std::shared_ptr<SASAction> ra : req) {
+		for (uint32_t ra : task->getRequirers(c.var, c.value)) {
 			if (!visitedAction(ra)) {
 				setVisitedAction(ra);
-				//cout << "Action " << ra->name << " supported by at-end" << endl;
-				fullActionCheck(ra, c.var, c.value, startTimeLastAction + 1, startTimeNewAction);
+				//cout << "Action " << task->actions[ra]->name << " supported by at-end" << endl;
+				fullActionCheck(task->actions[ra], c.var, c.value, startTimeLastAction + 1, startTimeNewAction);
 			}
 		}
 	}
 	for (SASNumericEffect& c : a->startNumEff) {
-		vector<std::shared_ptr<SASAction>>& req = task->numRequirers[c.var];
-		for (std::shared_ptr<SASAction> ra : req) {
+		for (uint32_t ra : task->getNumRequirers(c.var)) {
 			if (!visitedAction(ra)) {
 				setVisitedAction(ra);
-				fullActionCheck(ra, MAX_UINT16, 0, startTimeLastAction, startTimeNewAction);
+				fullActionCheck(task->actions[ra], MAX_UINT16, 0, startTimeLastAction, startTimeNewAction);
 			}
 		}
 	}
 	for (SASNumericEffect& c : a->endNumEff) {
-		vector<std::shared_ptr<SASAction>>& req = task->numRequirers[c.var];
-		for (std::shared_ptr<SASAction> ra : req) {
+		for (uint32_t ra : task->getNumRequirers(c.var)) {
 			if (!visitedAction(ra)) {
 				setVisitedAction(ra);
-				fullActionCheck(ra, MAX_UINT16, 0, startTimeLastAction + 1, startTimeNewAction);
+				fullActionCheck(task->actions[ra], MAX_UINT16, 0, startTimeLastAction + 1, startTimeNewAction);
 			}
 		}
 	}
@@ -55,6 +55,10 @@ private:
 	std::vector< std::vector<unsigned int> > matrix;	// Orders between time points in the current plan
 	Linearizer linearizer;
 	float bestMakespan;
+	std::vector<float> linearBounds;					// Bounds of the numeric variables for the batched evaluation of linear conditions
+	std::vector<uint8_t> linearRowHolds;
+	std::vector<std::vector<uint8_t>> linearActionHolds;	// For each numeric state, true for the batched actions whose numeric conditions hold
+	std::vector<unsigned int> linearStateStamp;			// Iteration in which each numeric state was evaluated
 
 	void computeOrderMatrix();
 	void resizeMatrix();
@@ -64,9 +68,13 @@ private:
 	bool supportedConditions(const std::shared_ptr<SASAction> a);
 	int supportedNumericConditions(std::shared_ptr<SASAction> a);
 	int supportedNumericConditions(SASConditionalEffect* e, std::shared_ptr<SASAction> a);
+	bool supportedLinearConditions(int numState, unsigned int a);
 	inline bool supportedCondition(const SASCondition& c) {
 		return planEffects.planEffects[c.var][c.value].iteration == currentIteration;
 	}
+	inline bool supportedCondition(TVariable var, TValue value) {
+		return planEffects.planEffects[var][value].iteration == currentIteration;
+	}
 	void fullActionSupportCheck(PlanBuilder* pb);
 	void fullConditionSupportCheck(PlanBuilder* pb, SASCondition* c, TTimePoint condPoint, bool overAll, bool canLeaveOpen);
 	void setNumericCausalLinks(PlanBuilder* pb, int numSupportState);
@@ -91,6 +99,8 @@ private:
 	void computeSuccessorsSupportedByLastActions();
 	inline bool visitedAction(std::shared_ptr<SASAction> a) { return checkedAction[a->index] == currentIteration; }
 	inline void setVisitedAction(std::shared_ptr<SASAction> a) { checkedAction[a->index] = currentIteration; }
+	inline bool visitedAction(uint32_t a) { return checkedAction[a] == currentIteration; }
+	inline void setVisitedAction(uint32_t a) { checkedAction[a] = currentIteration; }
 	unsigned int addActionSupport(PlanBuilder* pb, TVariable var, TValue value, TTimePoint effectTime,
 		TTimePoint startTimeNewAction);
 	void computeSuccessorsThroughBrotherPlans();
@@ -1,4 +1,5 @@
 #include "z3Checker.h"
+#include <chrono>
 
 /********************************************************/
 /* Oscar Sapena Vercher - DSIC - UPV                    */
@@ -7,14 +8,35 @@
 /* Plan validity checking through Z3 solver.            */
 /********************************************************/
 
+Z3Settings Z3Checker::settings;
+Z3Statistics Z3Checker::stats;
+bool Z3Checker::globalParamsSet = false;
+
+// Prints the accumulated statistics of the Z3 checks
+void Z3Statistics::print()
+{
+    std::cout << ";Z3 checks: " << numChecks << " (sat: " << numSat << ", unsat: " << numUnsat 
+        << ", unknown: " << numUnknown << "). Time: " << totalTime << " (max: " << maxTime << ")" << std::endl;
+}
+
 bool Z3Checker::checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TControVarValues* cvarValues)
 {
-    z3::set_param("parallel.enable", true);
-    z3::set_param("pp.decimal", true);
-    //z3::set_param("pp.decimal-precision", 3);
+    if (!globalParamsSet) {
+        z3::set_param("parallel.enable", settings.parallel);
+        z3::set_param("pp.decimal", true);
+        //z3::set_param("pp.decimal-precision", 3);
+        globalParamsSet = true;
+    }
     //std::cout << (optimizeMakespan ? "o" : ".");
     this->optimizeMakespan = optimizeMakespan;
     bool valid = false;
+    check_result res = unknown;
+    stats.numChecks++;
+    if (settings.timeLimit > 0 && toSeconds(settings.startTime) > settings.timeLimit) { // Planner deadline reached
+        stats.numUnknown++;
+        return false;
+    }
+    std::chrono::steady_clock::time_point checkStart = std::chrono::steady_clock::now();
     planComponents.calculate(p);
     //for (int i = 0; i < planComponents.size(); i++)
     //    std::cout << i << ": " << planComponents.get(i)->action->name << std::endl;
@@ -24,8 +46,13 @@ bool Z3Checker::checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TContr
         for (TStep s = 0; s < planComponents.size(); s++) {
             defineVariables(planComponents.get(s), s);
         }
+        nonlinear = nonlinearPlan();
         if (optimizeMakespan) 
             optimizer = std::make_unique<optimize>(c);
+        else if (!settings.logic.empty())
+            checker = std::make_unique<solver>(c, settings.logic.c_str());
+        else if (!nonlinear)    // Time points are integers, the rest of variables are reals
+            checker = std::make_unique<solver>(c, "QF_LIRA");
         else checker = std::make_unique<solver>(c);
         for (TStep s = 0; s < planComponents.size(); s++) {
             defineConstraints(planComponents.get(s), s);
@@ -33,14 +60,16 @@ bool Z3Checker::checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TContr
         TStep lastStep = planComponents.size() - 1;
         if (optimizeMakespan) {
             optimizer->minimize(getPointVar(stepToEndPoint(lastStep)));
-            valid = optimizer->check() == sat;
+            res = solve();
+            valid = res == sat;
             //cout << optimizer->assertions() << endl;
             //showModel(optimizer->get_model());
             if (valid) 
                 updatePlan(p, optimizer->get_model(), cvarValues);
         }
         else {
-            valid = checker->check() == sat;
+            res = solve();
+            valid = res == sat;
             //if (p->action->isGoal) std::cout << checker->assertions() << std::endl;
             if (valid) 
                 updatePlan(p, checker->get_model(), cvarValues);
@@ -53,10 +82,102 @@ bool Z3Checker::checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TContr
     catch (std::exception& ex) {
         throwError("unexpected error: " + std::string(ex.what()));
     }
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - checkStart).count();
+    stats.totalTime += time;
+    if (time > stats.maxTime) stats.maxTime = time;
+    if (res == sat) stats.numSat++;
+    else if (res == unsat) stats.numUnsat++;
+    else stats.numUnknown++;
+#ifdef DEBUG_Z3_ON
+    std::cout << ";Z3 check (" << planComponents.size() << " steps" << (nonlinear ? ", nonlinear" : "") << "): "
+        << (res == sat ? "sat" : (res == unsat ? "unsat" : "unknown")) << " in " << time << std::endl;
+#endif
     //std::cout << (valid ? "v" : "x") << std::endl;
     return valid;
 }
 
+// Runs the solver. The check is interrupted if the time limit per check is exceeded
+// or the search deadline is reached, through the solver timeout
+check_result Z3Checker::solve()
+{
+    unsigned int timeout = settings.timeout;
+    if (settings.timeLimit > 0) {
+        float remaining = settings.timeLimit - toSeconds(settings.startTime);
+        unsigned int remainingMs = remaining > 0.001f ? (unsigned int)(remaining * 1000) : 1;
+        if (timeout == 0 || remainingMs < timeout) timeout = remainingMs;
+    }
+    if (timeout > 0) {
+        params prm(*cont);
+        prm.set("timeout", timeout);
+        if (optimizeMakespan) optimizer->set(prm);
+        else checker->set(prm);
+    }
+    return optimizeMakespan ? optimizer->check() : checker->check();
+}
+
+// Checks if the plan has nonlinear numeric constraints or effects
+bool Z3Checker::nonlinearPlan()
+{
+    for (TStep s = 0; s < planComponents.size(); s++) {
+        std::shared_ptr<Plan> p = planComponents.get(s);
+        std::shared_ptr<SASAction> a = p->action;
+        for (SASNumericCondition& c : a->startNumCond)
+            for (SASNumericExpression& e : c.terms)
+                if (nonlinearExpression(e)) return true;
+        for (SASNumericCondition& c : a->overNumCond)
+            for (SASNumericExpression& e : c.terms)
+                if (nonlinearExpression(e)) return true;
+        for (SASNumericCondition& c : a->endNumCond)
+            for (SASNumericExpression& e : c.terms)
+                if (nonlinearExpression(e)) return true;
+        for (SASControlVar& cv : a->controlVars)
+            for (SASControlVarCondition& c : cv.conditions)
+                for (SASNumericExpression& e : c.condition.terms)
+                    if (nonlinearExpression(e)) return true;
+        for (SASDurationCondition& d : a->duration.conditions)
+            if (nonlinearExpression(d.exp)) return true;
+        std::vector<SASNumericEffect*> effects;
+        for (SASNumericEffect& e : a->startNumEff) effects.push_back(&e);
+        for (SASNumericEffect& e : a->endNumEff) effects.push_back(&e);
+        if (p->holdCondEff != nullptr) {
+            for (unsigned int numEff : *p->holdCondEff) {
+                SASConditionalEffect& ce = a->conditionalEff[numEff];
+                for (SASNumericCondition& c : ce.startNumCond)
+                    for (SASNumericExpression& e : c.terms)
+                        if (nonlinearExpression(e)) return true;
+                for (SASNumericCondition& c : ce.endNumCond)
+                    for (SASNumericExpression& e : c.terms)
+                        if (nonlinearExpression(e)) return true;
+                for (SASNumericEffect& e : ce.startNumEff) effects.push_back(&e);
+                for (SASNumericEffect& e : ce.endNumEff) effects.push_back(&e);
+            }
+        }
+        for (SASNumericEffect* e : effects) {
+            if (nonlinearExpression(e->exp)) return true;
+            if ((e->op == '*' || e->op == '/') && e->exp.type != 'N') return true;
+        }
+    }
+    return false;
+}
+
+// Checks if a numeric expression is nonlinear
+bool Z3Checker::nonlinearExpression(SASNumericExpression& e)
+{
+    switch (e.type) {
+    case '+':
+    case '-':
+        return nonlinearExpression(e.terms[0]) || nonlinearExpression(e.terms[1]);
+    case '*':
+        if (nonlinearExpression(e.terms[0]) || nonlinearExpression(e.terms[1])) return true;
+        return e.terms[0].type != 'N' && e.terms[1].type != 'N';
+    case '/':
+        return nonlinearExpression(e.terms[0]) || e.terms[1].type != 'N';
+    case '#':
+        return true;
+    }
+    return false;
+}
+
 void Z3Checker::defineVariables(std::shared_ptr<Plan> p, TStep s)
 {
     char varName[10];
@@ -72,7 +193,10 @@ void Z3Checker::defineVariables(std::shared_ptr<Plan> p, TStep s)
     if (p->cvarValues != nullptr) {
         for (int cv = 0; cv < p->cvarValues->size(); cv++) {
             sprintf(varName, "c%ds%d", cv, s);    // Control var
-            vars.controlVars.push_back(cont->real_const(varName));
+            if (p->action->controlVars[cv].type == 'I')
+                vars.controlVars.push_back(cont->int_const(varName));
+            else
+                vars.controlVars.push_back(cont->real_const(varName));
         }
     }
     if (p->startPoint.numVarValues != nullptr) {
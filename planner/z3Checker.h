@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <string>
 #include "plan.h"
 #include "planComponents.h"
 #include "z3++.h"
@@ -17,6 +18,28 @@ using namespace z3;
 
 typedef std::unordered_map<TStep, std::vector<float> > TControVarValues;
 
+class Z3Settings {
+public:
+	unsigned int timeout;		// Time limit per check in milliseconds (0 = no limit)
+	bool parallel;				// Parallel solving (parallel.enable)
+	std::string logic;			// Solver logic (empty = selected according to the plan constraints)
+	clock_t startTime;			// Search deadline: checks are interrupted when
+	float timeLimit;			// toSeconds(startTime) > timeLimit (0 = no deadline)
+	Z3Settings() { timeout = 0; parallel = true; startTime = 0; timeLimit = 0; }
+};
+
+class Z3Statistics {
+public:
+	unsigned int numChecks;
+	unsigned int numSat;
+	unsigned int numUnsat;
+	unsigned int numUnknown;	// Timeouts and interruptions
+	double totalTime;			// Wall time in seconds
+	double maxTime;
+	Z3Statistics() { numChecks = numSat = numUnsat = numUnknown = 0; totalTime = maxTime = 0; }
+	void print();
+};
+
 class Z3StepVariables {
 public:
 	TStep s;
@@ -32,12 +55,18 @@ public:
 class Z3Checker {
 private:
 	bool optimizeMakespan;
+	bool nonlinear;
 	PlanComponents planComponents;
 	std::vector<Z3StepVariables> stepVars;
 	context* cont;
   std::unique_ptr<solver> checker;
 	std::unique_ptr<optimize> optimizer;
 
+	static bool globalParamsSet;
+
+	bool nonlinearExpression(SASNumericExpression& e);
+	bool nonlinearPlan();
+	check_result solve();
 	void defineVariables(std::shared_ptr<Plan> p, TStep s);
 	void defineConstraints(std::shared_ptr<Plan> p, TStep s);
 	expr& getDurationVar(TStep s);
@@ -56,6 +85,9 @@ private:
 	void updateFluentValues(std::vector<TFluentInterval>* numValues, TTimePoint tp, model& m);
 
 public:
+	static Z3Settings settings;
+	static Z3Statistics stats;
+
 	bool checkPlan(std::shared_ptr<Plan> p, bool optimizeMakespan, TControVarValues* cvarValues = nullptr);
 };
 
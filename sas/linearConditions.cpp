@@ -0,0 +1,217 @@
+/********************************************************/
+/* Batched evaluation of the linear numeric conditions  */
+/* of the actions against an interval state.            */
+/********************************************************/
+
+#include "linearConditions.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LINEAR_CONDITIONS_AVX2
+#endif
+
+using namespace std;
+
+/********************************************************/
+/* CLASS: SASLinearConditions                           */
+/********************************************************/
+
+// Builds the coefficient matrix from the actions and goals of the task. The rows of each action are
+// contiguous, in the same order as in the action table. Only the actions with numeric conditions,
+// all of them linear, are batched
+SASLinearConditions::SASLinearConditions(SASTask* task) {
+	numBounds = 2 * (unsigned int)task->numVariables.size() + 2;
+	numRows = 0;
+	for (std::shared_ptr<SASAction>& a : task->actions)
+		addAction(a);
+	for (std::shared_ptr<SASAction>& g : task->goals)
+		addAction(g);
+	rowOffset.push_back(numRows);
+	int32_t zero = numBounds - 2;
+	while (numRows % 8 != 0) {	// Padding rows
+		for (unsigned int j = 0; j < MAX_LINEAR_TERMS; j++) {
+			upperIndex[j].push_back(zero);
+			upperCoef[j].push_back(0.0f);
+			lowerIndex[j].push_back(zero);
+			lowerCoef[j].push_back(0.0f);
+		}
+		strict.push_back(0);
+		numRows++;
+	}
+#ifdef LINEAR_CONDITIONS_AVX2
+	useAVX2 = __builtin_cpu_supports("avx2");
+#else
+	useAVX2 = false;
+#endif
+}
+
+// Adds the rows of the start and over numeric conditions of an action. No row is added if any of
+// the conditions is not linear
+void SASLinearConditions::addAction(std::shared_ptr<SASAction> a) {
+	unsigned int firstRow = numRows;
+	rowOffset.push_back(firstRow);
+	bool linear = true;
+	for (unsigned int i = 0; i < a->startNumCond.size() && linear; i++)
+		linear = addCondition(a->startNumCond[i]);
+	for (unsigned int i = 0; i < a->overNumCond.size() && linear; i++)
+		linear = addCondition(a->overNumCond[i]);
+	if (!linear) {
+		for (unsigned int j = 0; j < MAX_LINEAR_TERMS; j++) {
+			upperIndex[j].resize(firstRow);
+			upperCoef[j].resize(firstRow);
+			lowerIndex[j].resize(firstRow);
+			lowerCoef[j].resize(firstRow);
+		}
+		strict.resize(firstRow);
+		numRows = firstRow;
+	}
+	batched.push_back(linear && numRows > firstRow);
+	if (batched.back())
+		batchedActions.push_back((uint32_t)batched.size() - 1);
+}
+
+// Adds the row of a numeric condition. Returns false if the condition is not linear
+bool SASLinearConditions::addCondition(SASNumericCondition& c) {
+	if (c.comp == '-') return true;		// Dummy comparator
+	if (c.comp != '<' && c.comp != 'L' && c.comp != '>' && c.comp != 'G') return false;
+	std::vector<LinearTerm> left, right;
+	if (!getTerms(&c.terms[0], 1.0f, left) || !getTerms(&c.terms[1], 1.0f, right) ||
+		left.size() > MAX_LINEAR_TERMS || right.size() > MAX_LINEAR_TERMS)
+		return false;
+	bool greater = c.comp == '>' || c.comp == 'G';	// max(left) >= min(right) or max(right) >= min(left)
+	addSide(greater ? left : right, true, upperIndex, upperCoef);
+	addSide(greater ? right : left, false, lowerIndex, lowerCoef);
+	strict.push_back(c.comp == '>' || c.comp == '<' ? -1 : 0);
+	numRows++;
+	return true;
+}
+
+// Stores the terms of one side of a row, padded to MAX_LINEAR_TERMS
+void SASLinearConditions::addSide(std::vector<LinearTerm>& terms, bool upper, std::vector<int32_t>* index, std::vector<float>* coef) {
+	for (unsigned int j = 0; j < MAX_LINEAR_TERMS; j++) {
+		if (j < terms.size()) {
+			LinearTerm& t = terms[j];
+			if (t.var < 0) index[j].push_back(numBounds - 1);	// Constant: coefficient * 1
+			else if ((t.coef >= 0) == upper) index[j].push_back(maxBound(t.var));
+			else index[j].push_back(minBound(t.var));
+			coef[j].push_back(t.coef);
+		}
+		else {
+			index[j].push_back(numBounds - 2);
+			coef[j].push_back(0.0f);
+		}
+	}
+}
+
+// Gets the terms of a linear expression, given as a left-to-right sum (((t1 +- t2) +- t3) ...). This
+// way, the sequential accumulation of the terms gives the same result as the interval arithmetic
+bool SASLinearConditions::getTerms(SASNumericExpression* e, float sign, std::vector<LinearTerm>& terms) {
+	if (getTerm(e, sign, terms))
+		return true;
+	if (e->type != '+' && e->type != '-')
+		return false;
+	return getTerms(&e->terms[0], sign, terms) && getTerm(&e->terms[1], e->type == '-' ? -sign : sign, terms);
+}
+
+// Gets a single term: a constant, a numeric variable or the product of a constant and a variable
+bool SASLinearConditions::getTerm(SASNumericExpression* e, float sign, std::vector<LinearTerm>& terms) {
+	if (isStatic(e)) {
+		terms.emplace_back(sign * evaluateStatic(e), -1);
+		return true;
+	}
+	if (e->type == 'V') {
+		terms.emplace_back(sign, e->var);
+		return true;
+	}
+	if (e->type == '*') {
+		if (isStatic(&e->terms[0]) && e->terms[1].type == 'V') {
+			terms.emplace_back(sign * evaluateStatic(&e->terms[0]), e->terms[1].var);
+			return true;
+		}
+		if (isStatic(&e->terms[1]) && e->terms[0].type == 'V') {
+			terms.emplace_back(sign * evaluateStatic(&e->terms[1]), e->terms[0].var);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Checks if an expression only contains constant numbers
+bool SASLinearConditions::isStatic(SASNumericExpression* e) {
+	if (e->type == 'N') return true;
+	if (e->type != '+' && e->type != '-' && e->type != '*' && e->type != '/') return false;
+	return isStatic(&e->terms[0]) && isStatic(&e->terms[1]);
+}
+
+// Evaluates an expression that only contains constant numbers
+float SASLinearConditions::evaluateStatic(SASNumericExpression* e) {
+	if (e->type == 'N') return e->value;
+	float left = evaluateStatic(&e->terms[0]), right = evaluateStatic(&e->terms[1]);
+	switch (e->type) {
+	case '+':	return left + right;
+	case '-':	return left - right;
+	case '*':	return left * right;
+	default:	return left / right;
+	}
+}
+
+// Resizes the bounds vector and sets the padding and constant positions
+void SASLinearConditions::initializeBounds(std::vector<float>& bounds) const {
+	bounds.resize(numBounds);
+	bounds[numBounds - 2] = 0.0f;
+	bounds[numBounds - 1] = 1.0f;
+}
+
+// Evaluates all the rows against the given bounds. For each batched action, actionHolds is set
+// to 1 if all its start and over numeric conditions are supported
+void SASLinearConditions::evaluate(const std::vector<float>& bounds, std::vector<uint8_t>& rowHolds, std::vector<uint8_t>& actionHolds) const {
+	rowHolds.resize(numRows);
+	actionHolds.resize(batched.size());
+	if (useAVX2) evaluateAVX2(bounds.data(), rowHolds.data());
+	else evaluateScalar(bounds.data(), rowHolds.data());
+	for (uint32_t a : batchedActions) {
+		uint8_t holds = 1;
+		for (uint32_t r = rowOffset[a]; r < rowOffset[a + 1] && holds; r++)
+			holds = rowHolds[r];
+		actionHolds[a] = holds;
+	}
+}
+
+// Scalar evaluation of the rows
+void SASLinearConditions::evaluateScalar(const float* bounds, uint8_t* rowHolds) const {
+	for (unsigned int r = 0; r < numRows; r++) {
+		float upper = 0.0f, lower = 0.0f;
+		for (unsigned int j = 0; j < MAX_LINEAR_TERMS; j++) {
+			upper += upperCoef[j][r] * bounds[upperIndex[j][r]];
+			lower += lowerCoef[j][r] * bounds[lowerIndex[j][r]];
+		}
+		rowHolds[r] = strict[r] ? upper > lower : upper >= lower;
+	}
+}
+
+#ifdef LINEAR_CONDITIONS_AVX2
+// AVX2 evaluation of the rows, in blocks of 8. Products and sums are not fused, so the results
+// are the same as in the scalar evaluation
+__attribute__((target("avx2")))
+void SASLinearConditions::evaluateAVX2(const float* bounds, uint8_t* rowHolds) const {
+	for (unsigned int r = 0; r < numRows; r += 8) {
+		__m256 upper = _mm256_setzero_ps(), lower = _mm256_setzero_ps();
+		for (unsigned int j = 0; j < MAX_LINEAR_TERMS; j++) {
+			__m256i ui = _mm256_loadu_si256((const __m256i*)(upperIndex[j].data() + r));
+			__m256i li = _mm256_loadu_si256((const __m256i*)(lowerIndex[j].data() + r));
+			upper = _mm256_add_ps(upper, _mm256_mul_ps(_mm256_loadu_ps(upperCoef[j].data() + r), _mm256_i32gather_ps(bounds, ui, 4)));
+			lower = _mm256_add_ps(lower, _mm256_mul_ps(_mm256_loadu_ps(lowerCoef[j].data() + r), _mm256_i32gather_ps(bounds, li, 4)));
+		}
+		__m256 ge = _mm256_cmp_ps(upper, lower, _CMP_GE_OQ);
+		__m256 gt = _mm256_cmp_ps(upper, lower, _CMP_GT_OQ);
+		__m256 mask = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(strict.data() + r)));
+		int res = _mm256_movemask_ps(_mm256_blendv_ps(ge, gt, mask));
+		for (unsigned int k = 0; k < 8; k++)
+			rowHolds[r + k] = (res >> k) & 1;
+	}
+}
+#else
+void SASLinearConditions::evaluateAVX2(const float* bounds, uint8_t* rowHolds) const {
+	evaluateScalar(bounds, rowHolds);
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef LINEAR_CONDITIONS_H
+#define LINEAR_CONDITIONS_H
+
+/********************************************************/
+/* Batched evaluation of the linear numeric conditions  */
+/* of the actions against an interval state.            */
+/********************************************************/
+
+#include <cstdint>
+#include <vector>
+#include "sasTask.h"
+
+#define MAX_LINEAR_TERMS	4		// Maximum number of terms in each side of a linear condition
+
+// Coefficient matrix of the linear start/over numeric conditions of the actions and goals. Each
+// condition (left <comp> right) is stored as a row that compares the upper bound of one side with
+// the lower bound of the other one, and each side is a left-to-right sum of terms c * bound. The
+// bounds of the numeric variables are given in a flat vector: [min v0, max v0, min v1, max v1, ...,
+// 0, 1], where the two last positions are used for padding terms and for constants. The rows are
+// stored in structure-of-arrays layout, padded to blocks of 8, so they can be evaluated with AVX2
+class SASLinearConditions {
+private:
+	unsigned int numBounds;
+	unsigned int numRows;							// Number of rows, padded to a multiple of 8
+	std::vector<uint8_t> batched;					// For each action (index in the action table), true if its conditions are rows
+	std::vector<uint32_t> batchedActions;			// Actions with rows
+	std::vector<uint32_t> rowOffset;				// For each action, position of its first row
+	std::vector<int32_t> upperIndex[MAX_LINEAR_TERMS];	// Upper bound side: position of each term in the bounds vector
+	std::vector<float> upperCoef[MAX_LINEAR_TERMS];		// Upper bound side: coefficient of each term
+	std::vector<int32_t> lowerIndex[MAX_LINEAR_TERMS];	// Lower bound side
+	std::vector<float> lowerCoef[MAX_LINEAR_TERMS];
+	std::vector<int32_t> strict;					// -1 if the comparison is strict (>), 0 otherwise (>=)
+	bool useAVX2;
+
+	class LinearTerm {
+	public:
+		float coef;
+		int32_t var;		// -1 for constants
+		LinearTerm(float c, int32_t v) { coef = c; var = v; }
+	};
+
+	void addAction(std::shared_ptr<SASAction> a);
+	bool addCondition(SASNumericCondition& c);
+	bool getTerms(SASNumericExpression* e, float sign, std::vector<LinearTerm>& terms);
+	bool getTerm(SASNumericExpression* e, float sign, std::vector<LinearTerm>& terms);
+	bool isStatic(SASNumericExpression* e);
+	float evaluateStatic(SASNumericExpression* e);
+	void addSide(std::vector<LinearTerm>& terms, bool upper, std::vector<int32_t>* index, std::vector<float>* coef);
+	void evaluateScalar(const float* bounds, uint8_t* rowHolds) const;
+	void evaluateAVX2(const float* bounds, uint8_t* rowHolds) const;
+
+public:
+	SASLinearConditions(SASTask* task);
+	inline bool empty() const { return numRows == 0; }
+	inline bool isBatched(unsigned int a) const { return batched[a]; }
+	inline unsigned int getNumBounds() const { return numBounds; }
+	inline static unsigned int minBound(TVariable v) { return v << 1; }
+	inline static unsigned int maxBound(TVariable v) { return (v << 1) + 1; }
+	void initializeBounds(std::vector<float>& bounds) const;
+	inline unsigned int getNumActions() const { return (unsigned int)batched.size(); }
+	void evaluate(const std::vector<float>& bounds, std::vector<uint8_t>& rowHolds, std::vector<uint8_t>& actionHolds) const;
+};
+
+#endif
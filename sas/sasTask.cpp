@@ -5,9 +5,14 @@
 /* Finite-domain task representation.                   */
 /********************************************************/
 
+#include <atomic>
+#include <functional>
 #include <limits>
+#include <mutex>
+#include <thread>
 #include <time.h>
 #include "sasTask.h"
+#include "linearConditions.h"
 using namespace std;
 
 /********************************************************/
@@ -196,6 +201,8 @@ void SASNumericExpression::copyFrom(SASNumericExpression* e)
 	type = e->type;
 	value = e->value;
 	var = e->var;
+	codeStart = e->codeStart;
+	codeLength = e->codeLength;
 	terms.clear();
 	for (SASNumericExpression& t : e->terms) {
 		terms.emplace_back();
@@ -480,6 +487,231 @@ string SASNumericEffect::toString(vector<NumericVariable> *numVariables, vector<
 		exp.toString(numVariables, controlVars) + ")";
 }
 
+/********************************************************/
+/* CLASS: SASExpressionCode                             */
+/********************************************************/
+
+// Compiles a numeric expression, if it is supported by the interval evaluation. Single
+// numbers and variables are not compiled, as they are directly evaluated
+void SASExpressionCode::compile(SASNumericExpression* e) {
+	if (e->terms.empty())
+		return;
+	int depth = stackDepth(e);
+	if (depth < 0 || depth > MAX_EXPRESSION_STACK || e->codeLength > 0)
+		return;
+	unsigned int start = (unsigned int)code.size();
+	emit(e);
+	e->codeStart = start;
+	e->codeLength = (uint16_t)(code.size() - start);
+}
+
+// Compiles the terms of a numeric condition
+void SASExpressionCode::compile(SASNumericCondition* c) {
+	for (SASNumericExpression& e : c->terms)
+		compile(&e);
+}
+
+// Stack size needed to evaluate an expression (-1 if the expression is not supported)
+int SASExpressionCode::stackDepth(SASNumericExpression* e) {
+	switch (e->type) {
+	case 'N':
+	case 'V':
+	case 'C':
+	case 'D':
+		return 1;
+	case '+':
+	case '-':
+	case '*':
+	case '/': {
+		if (e->terms.size() != 2) return -1;
+		int left = stackDepth(&e->terms[0]), right = stackDepth(&e->terms[1]);
+		if (left < 0 || right < 0) return -1;
+		return std::max(left, right + 1);
+	}
+	default:
+		return -1;
+	}
+}
+
+// Checks if an expression only contains constant numbers
+bool SASExpressionCode::isStatic(SASNumericExpression* e) {
+	if (e->type == 'N') return true;
+	if (e->type == 'V' || e->type == 'C' || e->type == 'D') return false;
+	return isStatic(&e->terms[0]) && isStatic(&e->terms[1]);
+}
+
+// Evaluates an expression that only contains constant numbers
+float SASExpressionCode::evaluateStatic(SASNumericExpression* e) {
+	if (e->type == 'N') return e->value;
+	float left = evaluateStatic(&e->terms[0]), right = evaluateStatic(&e->terms[1]);
+	switch (e->type) {
+	case '+':	return left + right;
+	case '-':	return left - right;
+	case '*':	return left * right;
+	default:	return left / right;
+	}
+}
+
+// Appends the postfix instructions of an expression, folding its static subtrees
+void SASExpressionCode::emit(SASNumericExpression* e) {
+	if (isStatic(e)) {
+		code.emplace_back('N', 0, evaluateStatic(e));
+		return;
+	}
+	switch (e->type) {
+	case 'V':
+	case 'C':
+		code.emplace_back(e->type, e->var, 0.0f);
+		break;
+	case 'D':
+		code.emplace_back('D', 0, 0.0f);
+		break;
+	default:
+		if (e->type == '*' && isStatic(&e->terms[0]) && e->terms[1].type == 'V')
+			code.emplace_back('S', e->terms[1].var, evaluateStatic(&e->terms[0]));
+		else if (e->type == '*' && isStatic(&e->terms[1]) && e->terms[0].type == 'V')
+			code.emplace_back('S', e->terms[0].var, evaluateStatic(&e->terms[1]));
+		else {
+			emit(&e->terms[0]);
+			emit(&e->terms[1]);
+			code.emplace_back(e->type, 0, 0.0f);
+		}
+	}
+}
+
+// Evaluates the value [min, max] of a compiled expression
+void SASExpressionCode::evaluate(const SASNumericExpression* e, const TInterval* fluents, const TInterval* cvars, const TInterval& duration,
+	TFloatValue* min, TFloatValue* max) const
+{
+	TInterval stack[MAX_EXPRESSION_STACK];
+	int top = -1;
+	const SASInstruction* ins = code.data() + e->codeStart;
+	const SASInstruction* end = ins + e->codeLength;
+	for (; ins < end; ins++) {
+		switch (ins->op) {
+		case 'N':
+			top++;
+			stack[top].minValue = ins->value;
+			stack[top].maxValue = ins->value;
+			break;
+		case 'V':
+			stack[++top] = fluents[ins->var];
+			break;
+		case 'C':
+			stack[++top] = cvars[ins->var];
+			break;
+		case 'D':
+			stack[++top] = duration;
+			break;
+		case 'S': {
+			TFloatValue d1 = ins->value * fluents[ins->var].minValue, d2 = ins->value * fluents[ins->var].maxValue;
+			top++;
+			stack[top].minValue = std::min(d1, d2);
+			stack[top].maxValue = std::max(d1, d2);
+		}
+			break;
+		default: {
+			TInterval& left = stack[top - 1];
+			TInterval& right = stack[top];
+			top--;
+			switch (ins->op) {
+			case '+':
+				left.minValue += right.minValue;
+				left.maxValue += right.maxValue;
+				break;
+			case '-': {
+				TFloatValue minValue = left.minValue - right.maxValue;
+				left.maxValue -= right.minValue;
+				left.minValue = minValue;
+			}
+				break;
+			case '*': {
+				TFloatValue d1 = left.minValue * right.maxValue, d2 = left.maxValue * right.minValue,
+					d3 = left.minValue * right.minValue, d4 = left.maxValue * right.maxValue;
+				left.minValue = std::min(std::min(d1, d2), std::min(d3, d4));
+				left.maxValue = std::max(std::max(d1, d2), std::max(d3, d4));
+			}
+				break;
+			case '/': {
+				TFloatValue d1 = left.minValue / right.maxValue, d2 = left.maxValue / right.minValue,
+					d3 = left.minValue / right.minValue, d4 = left.maxValue / right.maxValue;
+				left.minValue = std::min(std::min(d1, d2), std::min(d3, d4));
+				left.maxValue = std::max(std::max(d1, d2), std::max(d3, d4));
+			}
+				break;
+			}
+		}
+		}
+	}
+	*min = stack[0].minValue;
+	*max = stack[0].maxValue;
+}
+
+/********************************************************/
+/* CLASS: SASActionTable                                */
+/********************************************************/
+
+// Builds the table from the task actions and goals
+SASActionTable::SASActionTable(const std::vector<std::shared_ptr<SASAction>>& actions, const std::vector<std::shared_ptr<SASAction>>& goals) {
+	numActions = (unsigned int)actions.size();
+	for (const std::shared_ptr<SASAction>& a : actions)
+		addAction(a);
+	for (const std::shared_ptr<SASAction>& g : goals)
+		addAction(g);
+	condOffset.push_back((uint32_t)conditions.size());
+	effOffset.push_back((uint32_t)effects.size());
+	conditions.shrink_to_fit();
+	effects.shrink_to_fit();
+}
+
+// Appends the conditions and effects of an action
+void SASActionTable::addAction(const std::shared_ptr<SASAction>& a) {
+	condOffset.push_back((uint32_t)conditions.size());
+	addConditions(a->startCond, conditions);
+	condOffset.push_back((uint32_t)conditions.size());
+	addConditions(a->overCond, conditions);
+	condOffset.push_back((uint32_t)conditions.size());
+	addConditions(a->endCond, conditions);
+	effOffset.push_back((uint32_t)effects.size());
+	addConditions(a->startEff, effects);
+	effOffset.push_back((uint32_t)effects.size());
+	addConditions(a->endEff, effects);
+}
+
+// Appends a list of conditions or effects
+void SASActionTable::addConditions(const std::vector<SASCondition>& cond, std::vector<TVarValue>& list) {
+	for (const SASCondition& c : cond)
+		list.push_back(SASTask::getVariableValueCode(c.var, c.value));
+}
+
+/********************************************************/
+/* CLASS: SASMutexMatrix                                */
+/********************************************************/
+
+// Initializes an empty relation between the indexes 0..size-1
+void SASMutexMatrix::initialize(unsigned int size, bool symmetric) {
+	this->size = size;
+	this->symmetric = symmetric;
+	numPairs = 0;
+	uint64_t numBits = symmetric ? (((uint64_t)size * (size + 1)) >> 1) : (uint64_t)size * size;
+	uint64_t numWords = (numBits + 63) >> 6;
+	dense = numWords * sizeof(uint64_t) <= MUTEX_DENSE_MEMORY;
+	bits.clear();
+	blocks.clear();
+	if (dense) bits.assign(numWords, 0);
+}
+
+// Adds the pair (i, j) to the relation. Returns false if it was already included
+bool SASMutexMatrix::add(unsigned int i, unsigned int j) {
+	uint64_t p = getPosition(i, j);
+	uint64_t mask = 1ULL << (p & 63);
+	uint64_t& block = dense ? bits[p >> 6] : blocks[p >> 6];
+	if (block & mask) return false;
+	block |= mask;
+	numPairs++;
+	return true;
+}
+
 /********************************************************/
 /* CLASS: SASTask                                       */
 /********************************************************/
@@ -494,30 +726,32 @@ SASTask::SASTask() {
 	condProducers = nullptr;
 	staticNumFunctions = nullptr;
 	numGoalsInPlateau = 1;
+	numVarValues = 0;
 }
 
 
-// Adds a mutex relationship between (var1, value1) and (var2, value2)
+// Adds a mutex relationship between (var1, value1) and (var2, value2). The mutex are stored in the
+// matrix when the (variable, value) indexes are computed
 void SASTask::addMutex(unsigned int var1, unsigned int value1, unsigned int var2, unsigned int value2) {
-    mutex[getMutexCode(var1, value1, var2, value2)] = true;
-    mutex[getMutexCode(var2, value2, var1, value1)] = true;
+    mutexPairs.emplace_back(getVariableValueCode(var1, value1), getVariableValueCode(var2, value2));
 	//cout << "Mutex added: " << variables[var1].name << "=" << values[value1].name << " and " <<
 	//	variables[var2].name << "=" << values[value2].name << endl;
 }
 
 // Checks if (var1, value1) and (var2, value2) are mutex
 bool SASTask::isMutex(unsigned int var1, unsigned int value1, unsigned int var2, unsigned int value2) {
-    return mutex.find(getMutexCode(var1, value1, var2, value2)) != mutex.end();
+	if (!inVarValueRange(var1, value1) || !inVarValueRange(var2, value2)) return false;
+    return mutex.contains(getVarValueIndex(var1, value1), getVarValueIndex(var2, value2));
 }
 
 bool SASTask::isPermanentMutex(unsigned int var1, unsigned int value1, unsigned int var2, unsigned int value2) {
-    return permanentMutex.find(getMutexCode(var1, value1, var2, value2)) != permanentMutex.end();
+	if (permanentMutex.empty() || !inVarValueRange(var1, value1) || !inVarValueRange(var2, value2)) return false;
+    return permanentMutex.contains(getVarValueIndex(var1, value1), getVarValueIndex(var2, value2));
 }
 
 bool SASTask::isPermanentMutex(std::shared_ptr<SASAction> a1, std::shared_ptr<SASAction> a2) {
-	uint64_t n = a1->index;
-	n = (n << 32) + a2->index;
-	return permanentMutexActions.find(n) != permanentMutexActions.end();
+	unsigned int size = permanentMutexActions.getSize();
+	return a1->index < size && a2->index < size && permanentMutexActions.contains(a1->index, a2->index);
 }
 
 // Adds a new variable
@@ -666,6 +900,151 @@ void SASTask::computeProducers() {
 	}
 }
 
+// Computes the position of each pair (variable, value) in the flat arrays. Each variable
+// only takes the range between the lowest and the highest value of its domain
+void SASTask::computeVarValueIndexes() {
+	unsigned int numVars = (unsigned int)variables.size();
+	std::vector<TValue> minValue(numVars, MAX_UINT16), maxValue(numVars, 0);
+	for (unsigned int i = 0; i < numVars; i++) {
+		for (unsigned int v : variables[i].possibleValues) {
+			if (v < minValue[i]) minValue[i] = v;
+			if (v > maxValue[i]) maxValue[i] = v;
+		}
+		for (unsigned int v : variables[i].value) {
+			if (v < minValue[i]) minValue[i] = v;
+			if (v > maxValue[i]) maxValue[i] = v;
+		}
+	}
+	for (std::shared_ptr<SASAction> a : actions) {
+		updateVarValueRange(a->startCond, minValue, maxValue);
+		updateVarValueRange(a->overCond, minValue, maxValue);
+		updateVarValueRange(a->endCond, minValue, maxValue);
+		updateVarValueRange(a->startEff, minValue, maxValue);
+		updateVarValueRange(a->endEff, minValue, maxValue);
+		for (SASConditionalEffect& e : a->conditionalEff) {
+			updateVarValueRange(e.startCond, minValue, maxValue);
+			updateVarValueRange(e.endCond, minValue, maxValue);
+			updateVarValueRange(e.startEff, minValue, maxValue);
+			updateVarValueRange(e.endEff, minValue, maxValue);
+		}
+	}
+	for (std::shared_ptr<SASAction> g : goals) {
+		updateVarValueRange(g->startCond, minValue, maxValue);
+	}
+	varValueOffset.resize(numVars);
+	varMinValue.resize(numVars);
+	numVarValues = 0;
+	for (unsigned int i = 0; i < numVars; i++) {
+		if (minValue[i] > maxValue[i]) minValue[i] = maxValue[i];	// Empty domain
+		varValueOffset[i] = numVarValues;
+		varMinValue[i] = minValue[i];
+		numVarValues += maxValue[i] - minValue[i] + 1;
+	}
+}
+
+// Extends the value ranges of the variables with the values in the given conditions
+void SASTask::updateVarValueRange(std::vector<SASCondition>& conds, std::vector<TValue>& minValue, std::vector<TValue>& maxValue) {
+	for (SASCondition& c : conds) {
+		if (c.value < minValue[c.var]) minValue[c.var] = c.value;
+		if (c.value > maxValue[c.var]) maxValue[c.var] = c.value;
+	}
+}
+
+// Computes the CSR indexes of requirers and producers, once the requirers, producers and
+// numeric requirers have been computed. These lists do not change during the search
+void SASTask::computeCSRIndexes() {
+	requirersOffset.clear();
+	requirersIndex.clear();
+	producersOffset.clear();
+	producersIndex.clear();
+	condProducersOffset.clear();
+	condProducersIndex.clear();
+	for (TVariable var = 0; var < variables.size(); var++) {
+		unsigned int numValues = var + 1u < variables.size() ? varValueOffset[var + 1] - varValueOffset[var] : numVarValues - varValueOffset[var];
+		for (unsigned int i = 0; i < numValues; i++) {
+			TValue value = varMinValue[var] + i;
+			requirersOffset.push_back((uint32_t)requirersIndex.size());
+			for (std::shared_ptr<SASAction>& a : requirers[var][value])
+				requirersIndex.push_back(a->index);
+			producersOffset.push_back((uint32_t)producersIndex.size());
+			for (std::shared_ptr<SASAction>& a : producers[var][value])
+				producersIndex.push_back(a->index);
+			condProducersOffset.push_back((uint32_t)condProducersIndex.size());
+			for (SASConditionalProducer& cp : condProducers[var][value])
+				condProducersIndex.emplace_back(cp.a->index, cp.numEff);
+		}
+	}
+	requirersOffset.push_back((uint32_t)requirersIndex.size());
+	producersOffset.push_back((uint32_t)producersIndex.size());
+	condProducersOffset.push_back((uint32_t)condProducersIndex.size());
+	numRequirersOffset.clear();
+	numRequirersIndex.clear();
+	for (unsigned int v = 0; v < numVariables.size(); v++) {
+		numRequirersOffset.push_back((uint32_t)numRequirersIndex.size());
+		for (std::shared_ptr<SASAction>& a : numRequirers[v])
+			numRequirersIndex.push_back(a->index);
+	}
+	numRequirersOffset.push_back((uint32_t)numRequirersIndex.size());
+}
+
+// Builds the immutable table of the actions, once the actions will not change anymore
+void SASTask::buildActionTable() {
+	actionTable = std::make_shared<const SASActionTable>(actions, goals);
+}
+
+// Builds the coefficient matrix of the linear numeric conditions of the actions and goals
+void SASTask::buildLinearConditions() {
+	linearConditions = std::make_shared<const SASLinearConditions>(this);
+}
+
+// Compiles the numeric expressions of the actions and goals into a flat bytecode
+void SASTask::compileNumericExpressions() {
+	std::shared_ptr<SASExpressionCode> code = std::make_shared<SASExpressionCode>();
+	for (std::shared_ptr<SASAction>& a : actions)
+		compileNumericExpressions(a, *code);
+	for (std::shared_ptr<SASAction>& g : goals)
+		compileNumericExpressions(g, *code);
+	expressionCode = code;
+}
+
+// Compiles the numeric expressions of an action
+void SASTask::compileNumericExpressions(std::shared_ptr<SASAction> a, SASExpressionCode& code) {
+	for (SASDurationCondition& dc : a->duration.conditions)
+		code.compile(&dc.exp);
+	for (SASControlVar& cv : a->controlVars) {
+		for (SASControlVarCondition& cvc : cv.conditions)
+			code.compile(&cvc.condition);
+	}
+	for (SASNumericCondition& c : a->startNumCond)
+		code.compile(&c);
+	for (SASNumericCondition& c : a->overNumCond)
+		code.compile(&c);
+	for (SASNumericCondition& c : a->endNumCond)
+		code.compile(&c);
+	for (auto& pair : a->startNumConstrains) {
+		for (SASNumericCondition& c : pair.second)
+			code.compile(&c);
+	}
+	for (auto& pair : a->endNumConstrains) {
+		for (SASNumericCondition& c : pair.second)
+			code.compile(&c);
+	}
+	for (SASNumericEffect& e : a->startNumEff)
+		code.compile(&e.exp);
+	for (SASNumericEffect& e : a->endNumEff)
+		code.compile(&e.exp);
+	for (SASConditionalEffect& ce : a->conditionalEff) {
+		for (SASNumericCondition& c : ce.startNumCond)
+			code.compile(&c);
+		for (SASNumericCondition& c : ce.endNumCond)
+			code.compile(&c);
+		for (SASNumericEffect& e : ce.startNumEff)
+			code.compile(&e.exp);
+		for (SASNumericEffect& e : ce.endNumEff)
+			code.compile(&e.exp);
+	}
+}
+
 void SASTask::computeNumericVariablesInActions()
 {
 	this->numVarReqAtStart = std::make_unique<std::vector<TVariable>[]>(actions.size());
@@ -737,99 +1116,210 @@ void SASTask::computeNumericVariablesInActions(SASNumericExpression* e, std::vec
 	}
 }
 
+// Stores the mutex in the matrix, and computes the list of mutex of each (variable, value)
 void SASTask::computeMutexWithVarValues() {
-	uint32_t vv1, vv2;
-	std::unordered_map<uint64_t, bool>::const_iterator got = mutex.begin();
-  std::unordered_map<TVarValue, std::shared_ptr<std::vector<TVarValue>>>::const_iterator it;  
-	for (; got != mutex.end(); ++got) {
-		uint64_t n = got->first;
-		vv2 = n & 0xFFFFFFFF;
-		vv1 = (uint32_t) (n >> 32);
-		it = mutexWithVarValue.find(vv1);
-		if (it == mutexWithVarValue.end()) {
-      std::shared_ptr<std::vector<TVarValue>> item = std::make_shared<std::vector<TVarValue>>();
-      // std::vector<uint32_t> *item =  new std::vector<uint32_t>();
-			item->push_back(vv2);
-			mutexWithVarValue[vv1] = item;
-		} else {
-			it->second->push_back(vv2);
+	mutex.initialize(numVarValues, true);
+	for (std::pair<TVarValue, TVarValue>& m : mutexPairs) {
+		TVariable v1 = getVariableIndex(m.first), v2 = getVariableIndex(m.second);
+		TValue value1 = getValueIndex(m.first), value2 = getValueIndex(m.second);
+		if (!inVarValueRange(v1, value1) || !inVarValueRange(v2, value2)) continue;	// Values not used in the task
+		if (!mutex.add(getVarValueIndex(v1, value1), getVarValueIndex(v2, value2))) continue;
+		for (int i = 0; i < 2; i++) {
+			TVarValue vv1 = i == 0 ? m.first : m.second, vv2 = i == 0 ? m.second : m.first;
+			std::unordered_map<TVarValue, std::shared_ptr<std::vector<TVarValue>>>::const_iterator it = mutexWithVarValue.find(vv1);
+			if (it == mutexWithVarValue.end()) {
+				std::shared_ptr<std::vector<TVarValue>> item = std::make_shared<std::vector<TVarValue>>();
+				item->push_back(vv2);
+				mutexWithVarValue[vv1] = item;
+			} else {
+				it->second->push_back(vv2);
+			}
 		}
 	}
-}
-
-void SASTask::checkEffectReached(SASCondition* c, std::unordered_map<TVarValue,bool>* goals,
-		std::unordered_map<TVarValue, bool>* visitedVarValue, std::vector<TVarValue>* state) {
-	TVarValue code = getVariableValueCode(c->var, c->value);
-	goals->erase(code);
-	if (visitedVarValue->find(code) == visitedVarValue->end()) {
-		(*visitedVarValue)[code] = true;
-		state->push_back(code);
+	mutexPairs.clear();
+	mutexPairs.shrink_to_fit();
+}
+
+// Runs the worker in as many threads as available, but not more than n. The workers must share
+// an atomic counter to take the tasks 0..n-1
+static void runWorkers(unsigned int n, const std::function<void()>& worker) {
+	unsigned int numThreads = std::min(n, std::max(1u, std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++)
+		threads.emplace_back(worker);
+	worker();
+	for (std::thread& t : threads)
+		t.join();
+}
+
+// Removes from goals the (variable, value) pairs that can be reached from vv, ignoring the rest of conditions
+// of the actions. The bitsets and the visited flags are scratch memory, and they are left cleared
+void SASTask::checkReachability(TVarValue vv, std::vector<TVarValue>& goals, std::vector<uint64_t>& reached,
+	std::vector<uint64_t>& goalSet, std::vector<uint8_t>& visitedAction, std::vector<TVarValue>& state,
+	std::vector<unsigned int>& visitedList) {
+	unsigned int remaining = 0;
+	for (TVarValue g : goals) {
+		unsigned int i = getVarValueIndex(getVariableIndex(g), getValueIndex(g));
+		if (!((goalSet[i >> 6] >> (i & 63)) & 1)) {
+			goalSet[i >> 6] |= 1ULL << (i & 63);
+			remaining++;
+		}
 	}
-}
-
-void SASTask::checkReachability(TVarValue vv, std::unordered_map<TVarValue,bool>* goals) {
-	unsigned int numActions = actions.size();
-  std::unique_ptr<bool[]> visited = std::make_unique<bool[]>(numActions);
-	for (unsigned int i = 0; i < numActions; i++) visited[i] = false;
-	std::vector<TVarValue> state;
-	std::unordered_map<TVarValue, bool> visitedVarValue;
+	state.clear();
+	visitedList.clear();
 	state.push_back(vv);
-	visitedVarValue[vv] = true;
+	unsigned int vvIndex = getVarValueIndex(getVariableIndex(vv), getValueIndex(vv));
+	reached[vvIndex >> 6] |= 1ULL << (vvIndex & 63);
 	unsigned int start = 0;
-	while (start < state.size() && !goals->empty()) {
+	while (start < state.size() && remaining > 0) {
 		TVariable v = getVariableIndex(state[start]);
 		TValue value = getValueIndex(state[start]);
 		start++;
-		std::vector<std::shared_ptr<SASAction>> &req = requirers[v][value];
-		//cout << variables[v].name << "=" << values[value].name << endl;
-		for (unsigned int i = 0; i < req.size(); i++) {
-			std::shared_ptr<SASAction>a = req[i];
-			if (!visited[a->index]) {
-				visited[a->index] = true;
-				//cout << " - " << a->name << endl;
-				for (unsigned int j = 0; j < a->startEff.size(); j++)
-					checkEffectReached(&(a->startEff[j]), goals, &visitedVarValue, &state);
-				for (unsigned int j = 0; j < a->endEff.size(); j++)
-					checkEffectReached(&(a->endEff[j]), goals, &visitedVarValue, &state);
+		for (const std::shared_ptr<SASAction>& a : requirers[v][value]) {
+			if (visitedAction[a->index]) continue;
+			visitedAction[a->index] = 1;
+			visitedList.push_back(a->index);
+			for (int k = 0; k < 2; k++) {
+				for (SASCondition& c : k == 0 ? a->startEff : a->endEff) {
+					unsigned int i = getVarValueIndex(c.var, c.value);
+					uint64_t mask = 1ULL << (i & 63);
+					if (goalSet[i >> 6] & mask) {
+						goalSet[i >> 6] &= ~mask;
+						remaining--;
+					}
+					if (!(reached[i >> 6] & mask)) {
+						reached[i >> 6] |= mask;
+						state.push_back(getVariableValueCode(c.var, c.value));
+					}
+				}
 			}
 		}
 	}
+	unsigned int n = 0;
+	for (TVarValue g : goals) {
+		unsigned int i = getVarValueIndex(getVariableIndex(g), getValueIndex(g));
+		if ((goalSet[i >> 6] >> (i & 63)) & 1) {
+			goalSet[i >> 6] &= ~(1ULL << (i & 63));
+			goals[n++] = g;
+		}
+	}
+	goals.resize(n);
+	for (TVarValue f : state) {
+		unsigned int i = getVarValueIndex(getVariableIndex(f), getValueIndex(f));
+		reached[i >> 6] &= ~(1ULL << (i & 63));
+	}
+	for (unsigned int a : visitedList)
+		visitedAction[a] = 0;
 }
 
+// Computes the permanent mutex: (variable, value) pairs that cannot be reached once a mutex pair holds.
+// Two actions are permanent mutex if each one has an effect that is permanent mutex with a condition of
+// the other one. Both steps are computed in parallel
 void SASTask::computePermanentMutex() {
     //clock_t tini = clock();
     computeMutexWithVarValues();
-	std::unordered_map<TVarValue, std::shared_ptr<std::vector<TVarValue>>>::const_iterator it;
-	std::unordered_map<uint32_t,bool>::const_iterator ug;
-	for (it = mutexWithVarValue.begin(); it != mutexWithVarValue.end(); ++it) {
-		//cout << it->second->size() << endl;
-		std::unordered_map<uint32_t,bool> goals;
-		for (unsigned int i = 0; i < it->second->size(); i++) {
-			goals[it->second->at(i)] = true;
+	unsigned int numActions = actions.size();
+	unsigned int numWords = (numVarValues + 63) >> 6;
+	std::vector<TVarValue> facts;
+	std::vector<std::vector<TVarValue>> unreached;
+	for (std::unordered_map<TVarValue, std::shared_ptr<std::vector<TVarValue>>>::const_iterator it = mutexWithVarValue.begin();
+		it != mutexWithVarValue.end(); ++it) {
+		facts.push_back(it->first);
+		unreached.push_back(*(it->second));
+	}
+	std::atomic<unsigned int> next(0);
+	runWorkers((unsigned int)facts.size(), [&]() {
+		std::vector<uint64_t> reached(numWords, 0), goalSet(numWords, 0);
+		std::vector<uint8_t> visitedAction(numActions, 0);
+		std::vector<TVarValue> state;
+		std::vector<unsigned int> visitedList;
+		unsigned int i;
+		while ((i = next++) < facts.size()) {
+			checkReachability(facts[i], unreached[i], reached, goalSet, visitedAction, state, visitedList);
 		}
-		checkReachability(it->first, &goals);
-		for (ug = goals.begin(); ug != goals.end(); ++ug) {
-			TMutex code = (((TMutex)it->first) << 32) + ug->first;
-			permanentMutex[code] = true;
+	});
+	// Permanent mutex, and their CSR lists in both directions
+	permanentMutex.initialize(numVarValues, false);
+	std::vector<uint32_t> outOffset(numVarValues + 1, 0), inOffset(numVarValues + 1, 0);
+	std::vector<uint32_t> outList, inList;
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	for (unsigned int i = 0; i < facts.size(); i++) {
+		unsigned int vv1 = getVarValueIndex(getVariableIndex(facts[i]), getValueIndex(facts[i]));
+		for (TVarValue g : unreached[i]) {
+			unsigned int vv2 = getVarValueIndex(getVariableIndex(g), getValueIndex(g));
+			if (permanentMutex.add(vv1, vv2)) {
+				pairs.emplace_back(vv1, vv2);
+				outOffset[vv1 + 1]++;
+				inOffset[vv2 + 1]++;
+			}
+		}
+	}
+	permanentMutexActions.initialize(numActions, true);
+	if (permanentMutex.empty() || numActions == 0) return;
+	for (unsigned int i = 0; i < numVarValues; i++) {
+		outOffset[i + 1] += outOffset[i];
+		inOffset[i + 1] += inOffset[i];
+	}
+	outList.resize(pairs.size());
+	inList.resize(pairs.size());
+	{
+		std::vector<uint32_t> outPos(outOffset.begin(), outOffset.end() - 1), inPos(inOffset.begin(), inOffset.end() - 1);
+		for (std::pair<uint32_t, uint32_t>& p : pairs) {
+			outList[outPos[p.first]++] = p.second;
+			inList[inPos[p.second]++] = p.first;
 		}
 	}
-	if (permanentMutex.size() > 0) {
-		unsigned int numActions = actions.size();
-		for (unsigned int i = 0; i < numActions - 1; i++) {
-			std::shared_ptr<SASAction> a1 = actions[i];
+	// Conditions and effects of each action, as (variable, value) indexes
+	std::vector<uint32_t> condOffset(1, 0), effOffset(1, 0), cond, eff;
+	for (std::shared_ptr<SASAction> a : actions) {
+		for (std::vector<SASCondition>* v : { &a->startCond, &a->overCond, &a->endCond })
+			for (SASCondition& c : *v) cond.push_back(getVarValueIndex(c.var, c.value));
+		for (std::vector<SASCondition>* v : { &a->startEff, &a->endEff })
+			for (SASCondition& c : *v) eff.push_back(getVarValueIndex(c.var, c.value));
+		condOffset.push_back((uint32_t)cond.size());
+		effOffset.push_back((uint32_t)eff.size());
+	}
+	// For each action a1, deleted is the set of pairs that are permanent mutex with an effect of a1, and
+	// threatening is the set of pairs whose achievement is permanent mutex with a condition of a1. Then,
+	// a2 is mutex with a1 if a condition of a2 is in deleted and an effect of a2 is in threatening
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> mutexActions;
+	std::mutex mutexActionsLock;
+	next = 0;
+	runWorkers(numActions - 1, [&]() {
+		std::vector<uint64_t> deleted(numWords, 0), threatening(numWords, 0);
+		std::vector<std::pair<uint32_t, uint32_t>> found;
+		unsigned int i;
+		while ((i = next++) < numActions - 1) {
+			for (uint32_t e = effOffset[i]; e < effOffset[i + 1]; e++)
+				for (uint32_t k = outOffset[eff[e]]; k < outOffset[eff[e] + 1]; k++)
+					deleted[outList[k] >> 6] |= 1ULL << (outList[k] & 63);
+			for (uint32_t c = condOffset[i]; c < condOffset[i + 1]; c++)
+				for (uint32_t k = inOffset[cond[c]]; k < inOffset[cond[c] + 1]; k++)
+					threatening[inList[k] >> 6] |= 1ULL << (inList[k] & 63);
 			for (unsigned int j = i + 1; j < numActions; j++) {
-				if (checkActionMutex(a1, actions[j])) {
-					//cout << a1->name << " <- mutex -> " << actions[j]->name << endl;
-					uint64_t n = a1->index;
-					n = (n << 32) + actions[j]->index;
-					permanentMutexActions[n] = true;
-					n = actions[j]->index;
-					n = (n << 32) + a1->index;
-					permanentMutexActions[n] = true;
+				bool mutex1 = false, mutex2 = false;
+				for (uint32_t c = condOffset[j]; c < condOffset[j + 1] && !mutex1; c++)
+					mutex1 = (deleted[cond[c] >> 6] >> (cond[c] & 63)) & 1;
+				for (uint32_t e = effOffset[j]; e < effOffset[j + 1] && mutex1 && !mutex2; e++)
+					mutex2 = (threatening[eff[e] >> 6] >> (eff[e] & 63)) & 1;
+				if (mutex1 && mutex2) {
+					//cout << actions[i]->name << " <- mutex -> " << actions[j]->name << endl;
+					found.emplace_back(actions[i]->index, actions[j]->index);
 				}
 			}
+			for (uint32_t e = effOffset[i]; e < effOffset[i + 1]; e++)
+				for (uint32_t k = outOffset[eff[e]]; k < outOffset[eff[e] + 1]; k++)
+					deleted[outList[k] >> 6] = 0;
+			for (uint32_t c = condOffset[i]; c < condOffset[i + 1]; c++)
+				for (uint32_t k = inOffset[cond[c]]; k < inOffset[cond[c] + 1]; k++)
+					threatening[inList[k] >> 6] = 0;
 		}
-	}
+		std::lock_guard<std::mutex> lock(mutexActionsLock);
+		mutexActions.push_back(std::move(found));
+	});
+	for (std::vector<std::pair<uint32_t, uint32_t>>& found : mutexActions)
+		for (std::pair<uint32_t, uint32_t>& p : found)
+			permanentMutexActions.add(p.first, p.second);
 	//cout << (float) (((int) (1000 * (clock() - tini)/(float) CLOCKS_PER_SEC))/1000.0) << " sec." << endl;
 }
 
@@ -849,52 +1339,6 @@ void SASTask::postProcessActions()
 		a->postProcess();
 }
 
-bool SASTask::checkActionMutex(std::shared_ptr<SASAction> a1, std::shared_ptr<SASAction> a2) {
-	return checkActionOrdering(a1, a2) && checkActionOrdering(a2, a1);
-}
-
-bool SASTask::checkActionOrdering(std::shared_ptr<SASAction> a1, std::shared_ptr<SASAction> a2) {
-	for (unsigned int i = 0; i < a1->startEff.size(); i++) {
-		TVariable v1 = a1->startEff[i].var;
-		TValue value1 = a1->startEff[i].value;
-		for (unsigned int j = 0; j < a2->startCond.size(); j++) {
-			TVariable v2 = a2->startCond[j].var;
-			TValue value2 = a2->startCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-		for (unsigned int j = 0; j < a2->overCond.size(); j++) {
-			TVariable v2 = a2->overCond[j].var;
-			TValue value2 = a2->overCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-		for (unsigned int j = 0; j < a2->endCond.size(); j++) {
-			TVariable v2 = a2->endCond[j].var;
-			TValue value2 = a2->endCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-	}
-	for (unsigned int i = 0; i < a1->endEff.size(); i++) {
-		TVariable v1 = a1->endEff[i].var;
-		TValue value1 = a1->endEff[i].value;
-		for (unsigned int j = 0; j < a2->startCond.size(); j++) {
-			TVariable v2 = a2->startCond[j].var;
-			TValue value2 = a2->startCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-		for (unsigned int j = 0; j < a2->overCond.size(); j++) {
-			TVariable v2 = a2->overCond[j].var;
-			TValue value2 = a2->overCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-		for (unsigned int j = 0; j < a2->endCond.size(); j++) {
-			TVariable v2 = a2->endCond[j].var;
-			TValue value2 = a2->endCond[j].value;
-			if (isPermanentMutex(v1, value1, v2, value2)) return true;
-		}
-	}
-	return false;
-}
-
 void SASTask::addToCondProducers(TVariable v, TValue val, std::shared_ptr<SASAction> a, unsigned int eff) {
 	std::vector<SASConditionalProducer>& prod = condProducers[v][val];
 	for (unsigned int i = 0; i < prod.size(); i++) {
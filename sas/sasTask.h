@@ -14,9 +14,11 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <span>
 #include "../utils/utils.h"
 
 #define FICTITIOUS_FUNCTION		999999U
+#define MAX_EXPRESSION_STACK	32		// Maximum stack depth of a compiled numeric expression
 
 class SASValue {
 public:
@@ -65,6 +67,8 @@ public:
 	float value;				// if type == 'N'
 	uint16_t var;
 	std::vector<SASNumericExpression> terms;	// if type == '+' | '-' | '*' | '/' | '#'
+	uint32_t codeStart = 0;		// Position of the compiled expression in the task bytecode
+	uint16_t codeLength = 0;	// Number of instructions of the compiled expression (0 = not compiled)
     std::string toString(std::vector<NumericVariable> *numVariables, std::vector<SASControlVar>* controlVars);
 	bool equals(SASNumericExpression* e);
 	void copyFrom(SASNumericExpression* e);
@@ -151,6 +155,40 @@ public:
 	TInterval(TFloatValue min, TFloatValue max) { minValue = min; maxValue = max; }
 };
 
+// Instruction of a compiled numeric expression (postfix bytecode)
+class SASInstruction {
+public:
+	char op;			// 'N' = push constant, 'V' = push fluent, 'C' = push control var, 'D' = push duration,
+						// 'S' = push constant * fluent, '+' | '-' | '*' | '/' = binary operation on the stack top
+	uint16_t var;		// if op == 'V' | 'C' | 'S'
+	float value;		// if op == 'N' | 'S'
+	SASInstruction(char op, uint16_t var, float value) {
+		this->op = op;
+		this->var = var;
+		this->value = value;
+	}
+};
+
+// Flat bytecode of all the numeric expressions of the task. Each expression is compiled once, after
+// the SAS translation, into a postfix sequence of instructions with its static subtrees folded into
+// constants. The interval evaluation of a compiled expression needs no recursion nor allocation
+class SASExpressionCode {
+private:
+	std::vector<SASInstruction> code;
+
+	int stackDepth(SASNumericExpression* e);
+	bool isStatic(SASNumericExpression* e);
+	float evaluateStatic(SASNumericExpression* e);
+	void emit(SASNumericExpression* e);
+
+public:
+	void compile(SASNumericExpression* e);
+	void compile(SASNumericCondition* c);
+	void evaluate(const SASNumericExpression* e, const TInterval* fluents, const TInterval* cvars, const TInterval& duration,
+		TFloatValue* min, TFloatValue* max) const;
+	inline unsigned int size() const { return (unsigned int)code.size(); }
+};
+
 class SASControlVarCondition {
 public:
 	SASNumericCondition condition;
@@ -271,34 +309,116 @@ public:
 	}
 };
 
+// Conditional producer in the CSR indexes of the task
+class SASConditionalProducerIndex {
+public:
+	uint32_t action;
+	uint32_t numEff;
+	SASConditionalProducerIndex(uint32_t a, uint32_t e) {
+		action = a;
+		numEff = e;
+	}
+};
+
+// Immutable table of the hot data of the actions (conditions and effects), built after the
+// SAS translation. Conditions and effects are packed (variable, value) codes stored in
+// contiguous arrays, with per-action offsets. Goals are stored after the actions. The cold
+// data (names, numeric constraints, control variables, etc.) remains in the SASAction objects
+class SASActionTable {
+private:
+	unsigned int numActions;
+	std::vector<uint32_t> condOffset;	// For each action: start, over and end conditions
+	std::vector<TVarValue> conditions;
+	std::vector<uint32_t> effOffset;	// For each action: start and end effects
+	std::vector<TVarValue> effects;
+
+	void addAction(const std::shared_ptr<SASAction>& a);
+	void addConditions(const std::vector<SASCondition>& cond, std::vector<TVarValue>& list);
+
+	inline std::span<const TVarValue> getConditions(unsigned int first, unsigned int last) const {
+		return std::span<const TVarValue>(conditions.data() + condOffset[first], condOffset[last] - condOffset[first]);
+	}
+	inline std::span<const TVarValue> getEffects(unsigned int first, unsigned int last) const {
+		return std::span<const TVarValue>(effects.data() + effOffset[first], effOffset[last] - effOffset[first]);
+	}
+
+public:
+	SASActionTable(const std::vector<std::shared_ptr<SASAction>>& actions, const std::vector<std::shared_ptr<SASAction>>& goals);
+	// Position of an action or goal in the table
+	inline unsigned int getIndex(const SASAction& a) const {
+		return a.isGoal ? numActions + a.index : a.index;
+	}
+	inline std::span<const TVarValue> getStartConditions(unsigned int a) const { return getConditions(3 * a, 3 * a + 1); }
+	inline std::span<const TVarValue> getOverConditions(unsigned int a) const { return getConditions(3 * a + 1, 3 * a + 2); }
+	inline std::span<const TVarValue> getEndConditions(unsigned int a) const { return getConditions(3 * a + 2, 3 * a + 3); }
+	inline std::span<const TVarValue> getStartOverConditions(unsigned int a) const { return getConditions(3 * a, 3 * a + 2); }
+	inline std::span<const TVarValue> getAllConditions(unsigned int a) const { return getConditions(3 * a, 3 * a + 3); }
+	inline std::span<const TVarValue> getStartEffects(unsigned int a) const { return getEffects(2 * a, 2 * a + 1); }
+	inline std::span<const TVarValue> getEndEffects(unsigned int a) const { return getEffects(2 * a + 1, 2 * a + 2); }
+	inline std::span<const TVarValue> getAllEffects(unsigned int a) const { return getEffects(2 * a, 2 * a + 2); }
+};
+
+#define MUTEX_DENSE_MEMORY	(64U << 20)		// Maximum memory for a dense mutex matrix (in bytes)
+
+// Binary relation between dense indexes (pairs (variable, value) or actions). A symmetric relation only
+// stores the pairs (i, j) with i >= j, in a lower-triangular bit matrix. If the matrix does not fit in
+// MUTEX_DENSE_MEMORY, the bits are stored in a hash table of 64-bit blocks
+class SASMutexMatrix {
+private:
+	unsigned int size;
+	bool symmetric;
+	bool dense;
+	uint64_t numPairs;
+	std::vector<uint64_t> bits;						// Dense storage
+	std::unordered_map<uint64_t, uint64_t> blocks;	// Sparse storage: block index -> 64 bits
+
+	inline uint64_t getPosition(unsigned int i, unsigned int j) const {
+		if (!symmetric) return (uint64_t)i * size + j;
+		if (i < j) std::swap(i, j);
+		return (((uint64_t)i * (i + 1)) >> 1) + j;
+	}
+
+public:
+	SASMutexMatrix() { size = 0; symmetric = dense = true; numPairs = 0; }
+	void initialize(unsigned int size, bool symmetric);
+	bool add(unsigned int i, unsigned int j);
+	inline bool contains(unsigned int i, unsigned int j) const {
+		uint64_t p = getPosition(i, j);
+		if (dense) return (bits[p >> 6] >> (p & 63)) & 1;
+		std::unordered_map<uint64_t, uint64_t>::const_iterator it = blocks.find(p >> 6);
+		return it != blocks.end() && ((it->second >> (p & 63)) & 1);
+	}
+	inline unsigned int getSize() const { return size; }
+	inline bool empty() const { return numPairs == 0; }
+};
+
+class SASLinearConditions;
+
 class SASTask {    
 private:
-    std::unordered_map<TMutex, bool> mutex;
+    std::vector<std::pair<TVarValue, TVarValue>> mutexPairs;	// Mutex added before computing the (variable, value) indexes
+    SASMutexMatrix mutex;					// Indexed by getVarValueIndex
     std::unordered_map<TVarValue, std::shared_ptr<std::vector<TVarValue>>> mutexWithVarValue;
-    std::unordered_map<TMutex, bool> permanentMutex;
-    std::unordered_map<TMutex, bool> permanentMutexActions;
+    SASMutexMatrix permanentMutex;			// Not symmetric, indexed by getVarValueIndex
+    SASMutexMatrix permanentMutexActions;	// Indexed by the action indexes
     std::unordered_map<std::string, unsigned int> valuesByName;
     std::vector<TVarValue> goalList;
     std::unique_ptr<bool[]> staticNumFunctions;
     std::vector<GoalDeadline> goalDeadlines;
 
-	inline static TMutex getMutexCode(TVariable var1, TValue value1, TVariable var2, TValue value2) {
-		TMutex code = (var1 << 16) + value1;
-        code = (code << 16) + var2;
-        code = (code << 16) + value2;
-        return code;
-    }
+	inline bool inVarValueRange(TVariable var, TValue value) {
+		return value >= varMinValue[var] &&
+			getVarValueIndex(var, value) < (var + 1u < varValueOffset.size() ? varValueOffset[var + 1] : numVarValues);
+	}
 	//void computeActionCost(std::shared_ptr<SASAction> a, bool* variablesOnMetric);
 	bool checkVariablesUsedInMetric(SASMetric* m, bool* variablesOnMetric);
 	bool checkVariableExpression(SASNumericExpression* e, bool* variablesOnMetric);
 	float computeFixedExpression(SASNumericExpression* e);
 	float evaluateMetric(SASMetric* m, float* numState, float makespan);
-	bool checkActionMutex(std::shared_ptr<SASAction> a1, std::shared_ptr<SASAction> a2);
-	bool checkActionOrdering(std::shared_ptr<SASAction> a1, std::shared_ptr<SASAction> a2);
 	void computeMutexWithVarValues();
-	void checkReachability(TVarValue vv, std::unordered_map<TVarValue,bool>* goals);
-	void checkEffectReached(SASCondition* c, std::unordered_map<TVarValue,bool>* goals,
-			std::unordered_map<TVarValue, bool>* visitedVarValue, std::vector<TVarValue>* state);
+	void checkReachability(TVarValue vv, std::vector<TVarValue>& goals, std::vector<uint64_t>& reached,
+		std::vector<uint64_t>& goalSet, std::vector<uint8_t>& visitedAction, std::vector<TVarValue>& state,
+		std::vector<unsigned int>& visitedList);
 	void addGoalToList(SASCondition* c);
 
 public:
@@ -331,6 +451,22 @@ public:
 	std::unique_ptr<std::vector<TVariable>[]> numVarReqAtStart;  // For each action, numeric variables that are required in the start point of the action
 	std::unique_ptr<std::vector<TVariable>[]> numVarReqAtEnd;	   // For each action, numeric variables that are required in the end point of the action
 	std::unique_ptr<std::vector<TVariable>[]> numVarReqGoal;		// For each goal, numeric variables that are required in the goal
+	std::vector<unsigned int> varValueOffset;	// For each variable, position of its first value in the flat (variable, value) arrays
+	std::vector<TValue> varMinValue;			// For each variable, lowest value of its domain
+	unsigned int numVarValues;					// Size of the flat (variable, value) arrays
+	// Frozen CSR indexes of requirers and producers. For each (variable, value), or numeric variable,
+	// the offsets array gives the position of its first action index in the contiguous array
+	std::vector<uint32_t> requirersOffset;
+	std::vector<uint32_t> requirersIndex;
+	std::vector<uint32_t> producersOffset;
+	std::vector<uint32_t> producersIndex;
+	std::vector<uint32_t> condProducersOffset;
+	std::vector<SASConditionalProducerIndex> condProducersIndex;
+	std::vector<uint32_t> numRequirersOffset;
+	std::vector<uint32_t> numRequirersIndex;
+	std::shared_ptr<const SASActionTable> actionTable;	// Hot data of the actions, shared by the search modules
+	std::shared_ptr<const SASExpressionCode> expressionCode;	// Compiled numeric expressions
+	std::shared_ptr<const SASLinearConditions> linearConditions;	// Linear numeric conditions, for batched evaluation
 
     SASTask();
 	void addMutex(unsigned int var1, unsigned int value1, unsigned int var2, unsigned int value2);
@@ -357,6 +493,32 @@ public:
 	void computeInitialState();
 	void computeRequirers();
 	void computeProducers();
+	void computeVarValueIndexes();
+	void updateVarValueRange(std::vector<SASCondition>& conds, std::vector<TValue>& minValue, std::vector<TValue>& maxValue);
+	inline unsigned int getVarValueIndex(TVariable var, TValue value) {
+		return varValueOffset[var] + value - varMinValue[var];
+	}
+	void computeCSRIndexes();
+	void buildActionTable();
+	void compileNumericExpressions();
+	void buildLinearConditions();
+	void compileNumericExpressions(std::shared_ptr<SASAction> a, SASExpressionCode& code);
+	inline std::span<const uint32_t> getRequirers(TVariable var, TValue value) {
+		unsigned int vv = getVarValueIndex(var, value);
+		return std::span<const uint32_t>(requirersIndex.data() + requirersOffset[vv], requirersOffset[vv + 1] - requirersOffset[vv]);
+	}
+	inline std::span<const uint32_t> getProducers(TVariable var, TValue value) {
+		unsigned int vv = getVarValueIndex(var, value);
+		return std::span<const uint32_t>(producersIndex.data() + producersOffset[vv], producersOffset[vv + 1] - producersOffset[vv]);
+	}
+	inline std::span<const SASConditionalProducerIndex> getCondProducers(TVariable var, TValue value) {
+		unsigned int vv = getVarValueIndex(var, value);
+		return std::span<const SASConditionalProducerIndex>(condProducersIndex.data() + condProducersOffset[vv],
+			condProducersOffset[vv + 1] - condProducersOffset[vv]);
+	}
+	inline std::span<const uint32_t> getNumRequirers(TVariable v) {
+		return std::span<const uint32_t>(numRequirersIndex.data() + numRequirersOffset[v], numRequirersOffset[v + 1] - numRequirersOffset[v]);
+	}
 	void computeNumericVariablesInActions();
 	void computeNumericVariablesInActions(std::shared_ptr<SASAction> a);
 	void computeNumericVariablesInGoals(std::shared_ptr<SASAction> a);
@@ -81,8 +81,13 @@ void SASTranslator::translate(std::unique_ptr<GroundedTask> &gTaskIn, bool onlyG
 	sTaskOut->computeInitialState();
 	sTaskOut->computeRequirers();
 	sTaskOut->computeProducers();
+	sTaskOut->computeVarValueIndexes();
 	sTaskOut->computePermanentMutex();
 	sTaskOut->computeNumericVariablesInActions();
+	sTaskOut->computeCSRIndexes();
+	sTaskOut->buildActionTable();
+	sTaskOut->compileNumericExpressions();
+	sTaskOut->buildLinearConditions();
 #ifdef DEBUG_SASTRANS_ON	
 	cout << sTaskOut->toString() << endl;
 #endif
@@ -161,7 +166,17 @@ bool SASTranslator::isMutex(GroundedCondition &c1, GroundedCondition &c2) {
 }
 
 // Disposes the memory
+// Frees the grounded task and the mutex data once the SAS task has been built, before the SAS task
+// computes its own indexes
 void SASTranslator::clearMemory() {
+    gTask = nullptr;
+    mutex = nullptr;
+    actions = nullptr;
+    isLiteral = nullptr;
+    literalInFNA = nullptr;
+    literalInF = nullptr;
+    negatedLiteral = nullptr;
+    mutexChanges.clear();
 }
 
 // F* <- I
@@ -497,8 +512,13 @@ void SASTranslator::splitMutex(std::shared_ptr<SASTask> sTask, bool onlyGenerate
 	removeMultipleValues(sTask, &trans);
     setInitialValuesForVariables(sTask, &trans);					// Initial state processing
  	sTask->preferenceNames = gTask->preferenceNames;
-    for (unsigned int i = 0; i < numActions; i++)					// Actions processing
-		createAction(&(gTask->actions[i]), sTask, &trans, false);
+    for (unsigned int i = 0; i < numActions; i++) {				// Actions processing
+		GroundedAction &ga = gTask->actions[i];
+		createAction(&ga, sTask, &trans, false);
+		ga = GroundedAction(ga.instantaneous, ga.isTIL, ga.isGoal);	// Releases the translated action
+	}
+	gTask->actions.clear();
+	gTask->actions.shrink_to_fit();
 	for (unsigned int i = 0; i < gTask->goals.size(); i++)			// Goals processing
 		createAction(&(gTask->goals[i]), sTask, &trans, true);
 	for (unsigned int i = 0; i < gTask->constraints.size(); i++)	// Constraints processing
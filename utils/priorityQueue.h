@@ -97,4 +97,65 @@ public:
 	}
 };
 
+// Priority queue of items stored by value, with the same ordering as PriorityQueue.
+// T must provide a default constructor and: int compare(const T& other) const
+template <typename T>
+class ValuePriorityQueue {
+private:
+	std::vector<T> pq;		// Priority queue
+
+	void heapify(unsigned int gap) {
+		T aux = pq[gap];
+		unsigned int child = gap << 1;
+		while (child < pq.size()) {
+			if (child != pq.size() - 1 && pq[child + 1].compare(pq[child]) < 0)
+				child++;
+			if (pq[child].compare(aux) < 0) {
+				pq[gap] = pq[child];
+				gap = child;
+				child = gap << 1;
+			}
+			else break;
+		}
+		pq[gap] = aux;
+	}
+
+public:
+	ValuePriorityQueue() : ValuePriorityQueue(DEFAULT_PQ_CAPACITY) { }
+
+	ValuePriorityQueue(unsigned int initialCapacity) {
+		pq.reserve(initialCapacity);
+		pq.emplace_back();	// Position 0 empty
+	}
+
+	void add(const T& p) {
+		unsigned int gap = (unsigned int)pq.size();
+		pq.emplace_back();
+		while (gap > 1 && p.compare(pq[gap >> 1]) < 0) {
+			pq[gap] = pq[gap >> 1];
+			gap = gap >> 1;
+		}
+		pq[gap] = p;
+	}
+
+	inline int size() {
+		return (int)pq.size() - 1;
+	}
+
+	// Removes the first item and stores it in the given parameter
+	void poll(T& next) {
+		next = pq[1];
+		if (pq.size() > 2) {
+			pq[1] = pq.back();
+			pq.pop_back();
+			heapify(1);
+		}
+		else if (pq.size() > 1) pq.pop_back();
+	}
+
+	inline void clear() {
+		pq.resize(1);	// Position 0 empty
+	}
+};
+
 #endif
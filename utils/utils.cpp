@@ -1,6 +1,7 @@
 #include "utils.h"
 #include <ctype.h>
 #include <string.h>
+#include <stdlib.h>
 
 /********************************************************/
 /* Oscar Sapena Vercher - DSIC - UPV                    */
@@ -28,6 +29,28 @@ bool compareStr(char* s1, const char* s2) {
 	return true;
 }
 
+// Reads a memory field (in KB) of the process status, or 0 if it is not available
+static size_t getStatusMemoryKB(const char* field) {
+	ifstream f("/proc/self/status");
+	string line;
+	size_t length = strlen(field);
+	while (getline(f, line)) {
+		if (line.compare(0, length, field) == 0)
+			return (size_t)atol(line.c_str() + length);
+	}
+	return 0;
+}
+
+// Peak resident memory of the process (in KB), or 0 if it is not available
+size_t getPeakMemoryKB() {
+	return getStatusMemoryKB("VmHWM:");
+}
+
+// Current resident memory of the process (in KB), or 0 if it is not available
+size_t getCurrentMemoryKB() {
+	return getStatusMemoryKB("VmRSS:");
+}
+
 #ifdef DEBUG_TO_FILE_NOT_CONSOLE
 void createDebugFile()
 {
@@ -50,6 +50,12 @@ using TFloatValue = float;
 // Compare two strings
 bool compareStr(char* s1, const char* s2);
 
+// Peak resident memory of the process (in KB), or 0 if it is not available
+size_t getPeakMemoryKB();
+
+// Current resident memory of the process (in KB), or 0 if it is not available
+size_t getCurrentMemoryKB();
+
 inline TTimePoint stepToStartPoint(TStep step) {	// Step number -> start time point
 	return step << 1;
 }